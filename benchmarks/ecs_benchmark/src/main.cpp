@@ -0,0 +1,267 @@
+#include <defines.h>
+#include <core/cememory.h>
+#include <core/logger.h>
+#include <systems/ecs_system.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// The iteration is repeated until this many entities have been visited, so the small counts are not just timer noise
+#define BENCHMARK_ITERATION_VISITS 20000000
+// The configurations whose components don't fit in this budget are skipped, a UI button takes about 1KiB
+#define BENCHMARK_MAX_ARCHETYPE_BYTES GIBIBYTES(1ULL)
+
+typedef std::chrono::steady_clock benchmark_clock;
+
+typedef struct benchmark_archetype {
+	const char* name;
+	caliope::archetype archetype;
+	// Component read by the iteration, its first member is the position
+	caliope::component_id iterated_component;
+} benchmark_archetype;
+
+typedef enum benchmark_operation {
+	BENCHMARK_OPERATION_ADD = 0,
+	BENCHMARK_OPERATION_INSERT_DATA,
+	BENCHMARK_OPERATION_GET_SEQUENTIAL,
+	BENCHMARK_OPERATION_GET_RANDOM,
+	BENCHMARK_OPERATION_ENABLE,
+	BENCHMARK_OPERATION_ITERATE,
+	BENCHMARK_OPERATION_DELETE,
+	BENCHMARK_OPERATION_SPAWN_BATCH,
+	BENCHMARK_OPERATION_COUNT
+} benchmark_operation;
+
+typedef struct benchmark_result {
+	const char* archetype_name;
+	uint entity_count;
+	bool skipped;
+	double ns_per_operation[BENCHMARK_OPERATION_COUNT];
+	// Bytes of the iterated column read per second
+	double iterate_bytes_per_second;
+} benchmark_result;
+
+static const benchmark_archetype archetypes[] = {
+	{ "sprite", caliope::ARCHETYPE_SPRITE, caliope::TRANSFORM_COMPONENT },
+	{ "sprite_animation", caliope::ARCHETYPE_SPRITE_ANIMATION, caliope::TRANSFORM_COMPONENT },
+	{ "point_light", caliope::ARCHETYPE_POINT_LIGHT, caliope::TRANSFORM_COMPONENT },
+	{ "ui_image", caliope::ARCHETYPE_UI_IMAGE, caliope::UI_TRANSFORM_COMPONENT },
+	{ "ui_button", caliope::ARCHETYPE_UI_BUTTON, caliope::UI_TRANSFORM_COMPONENT }
+};
+
+static const uint entity_counts[] = { 1000, 100000, 1000000 };
+
+static const char* operation_names[BENCHMARK_OPERATION_COUNT] = {
+	"add", "insert_data", "get_data seq", "get_data rand", "enable", "iterate", "delete", "spawn_batch"
+};
+
+// Keeps the compiler from dropping the reads of the benchmark
+static volatile uint64 benchmark_sink;
+
+static double elapsed_ns(benchmark_clock::time_point start_time) {
+	return std::chrono::duration<double, std::nano>(benchmark_clock::now() - start_time).count();
+}
+
+static uint64 random_next(uint64& random_state) {
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+	return random_state * 2685821657736338717ULL;
+}
+
+static void shuffle(std::vector<uint>& entities, uint64& random_state) {
+	for (uint i = (uint)entities.size() - 1; i > 0; --i) {
+		std::swap(entities[i], entities[random_next(random_state) % (i + 1)]);
+	}
+}
+
+static bool run_archetype(const benchmark_archetype& bench_archetype, uint entity_count, benchmark_result& out_result) {
+	caliope::memory_system_configuration memory_config = {};
+	memory_config.total_alloc_size = MEBIBYTES(512);
+	memory_config.max_alloc_size = GIBIBYTES(4ULL);
+	memory_config.reserve_address_space = true;
+	memory_config.allocator_freelist_type = caliope::FREELIST_TYPE_BINNED;
+	memory_config.track_callsites = false;
+	if (!caliope::memory_system_initialize(memory_config)) {
+		CE_LOG_FATAL("Failed to initialize the memory system for the benchmark");
+		return false;
+	}
+	if (!caliope::ecs_system_initialize()) {
+		CE_LOG_FATAL("Failed to initialize the ECS for the benchmark");
+		caliope::memory_system_shutdown();
+		return false;
+	}
+
+	out_result.archetype_name = bench_archetype.name;
+	out_result.entity_count = entity_count;
+	caliope::archetype archetype = bench_archetype.archetype;
+
+	// The components of the archetype, taken from an entity so the benchmark follows the builtin archetypes
+	uint probe = caliope::ecs_system_add_entity(archetype);
+	std::vector<caliope::component_id> components = caliope::ecs_system_get_entity_components(probe);
+	caliope::ecs_system_delete_entity(probe);
+
+	std::vector<uint> component_sizes;
+	uint64 row_bytes = 0;
+	uint max_component_size = 0;
+	for (caliope::component_id component : components) {
+		uint component_size = caliope::ecs_system_get_column(archetype, component).component_size;
+		component_sizes.push_back(component_size);
+		row_bytes += component_size;
+		max_component_size = std::max(max_component_size, component_size);
+	}
+
+	printf("\n== %s, %u entities, %u components, %llu bytes per entity\n", bench_archetype.name, entity_count, (uint)components.size(), row_bytes);
+	if (row_bytes * entity_count > BENCHMARK_MAX_ARCHETYPE_BYTES) {
+		printf("  skipped, the components take more than %llu MiB\n", (uint64)(BENCHMARK_MAX_ARCHETYPE_BYTES / 1024 / 1024));
+		out_result.skipped = true;
+		caliope::ecs_system_shutdown();
+		caliope::memory_system_shutdown();
+		return true;
+	}
+
+	uint64 random_state = 0x9E3779B97F4A7C15ULL;
+	uint64 checksum = 0;
+	std::vector<uint> entities(entity_count);
+
+	benchmark_clock::time_point start_time = benchmark_clock::now();
+	for (uint i = 0; i < entity_count; ++i) {
+		entities[i] = caliope::ecs_system_add_entity(archetype);
+	}
+	out_result.ns_per_operation[BENCHMARK_OPERATION_ADD] = elapsed_ns(start_time) / entity_count;
+
+	std::vector<uchar> component_data(max_component_size, 0);
+	start_time = benchmark_clock::now();
+	for (uint i = 0; i < entity_count; ++i) {
+		*(float*)component_data.data() = (float)i;
+		for (uint c = 0; c < components.size(); ++c) {
+			caliope::ecs_system_insert_data(entities[i], components[c], component_data.data());
+		}
+	}
+	out_result.ns_per_operation[BENCHMARK_OPERATION_INSERT_DATA] = elapsed_ns(start_time) / ((double)entity_count * components.size());
+
+	start_time = benchmark_clock::now();
+	for (uint i = 0; i < entity_count; ++i) {
+		uint64 size;
+		checksum += (uint64)caliope::ecs_system_get_component_data(entities[i], bench_archetype.iterated_component, size);
+	}
+	out_result.ns_per_operation[BENCHMARK_OPERATION_GET_SEQUENTIAL] = elapsed_ns(start_time) / entity_count;
+
+	// NOTE: In a random order every lookup misses the cache once the archetype is bigger than the cache
+	std::vector<uint> random_entities = entities;
+	shuffle(random_entities, random_state);
+	start_time = benchmark_clock::now();
+	for (uint i = 0; i < entity_count; ++i) {
+		uint64 size;
+		checksum += (uint64)caliope::ecs_system_get_component_data(random_entities[i], bench_archetype.iterated_component, size);
+	}
+	out_result.ns_per_operation[BENCHMARK_OPERATION_GET_RANDOM] = elapsed_ns(start_time) / entity_count;
+
+	// Disables every other entity and enables them again
+	start_time = benchmark_clock::now();
+	for (uint i = 0; i < entity_count; i += 2) {
+		caliope::ecs_system_enable_entity(random_entities[i], false);
+	}
+	for (uint i = 0; i < entity_count; i += 2) {
+		caliope::ecs_system_enable_entity(random_entities[i], true);
+	}
+	out_result.ns_per_operation[BENCHMARK_OPERATION_ENABLE] = elapsed_ns(start_time) / (((entity_count + 1) / 2) * 2.0);
+
+	// Iterates the enabled entities like a query does, with a quarter of them disabled
+	for (uint i = 0; i < entity_count; i += 4) {
+		caliope::ecs_system_enable_entity(random_entities[i], false);
+	}
+	caliope::ecs_column column = caliope::ecs_system_get_column(archetype, bench_archetype.iterated_component);
+	// NOTE: The disabled rows are skipped, the times are per visited entity
+	uint visited_count = std::max<uint>(caliope::ecs_system_get_enabled_entity_count(archetype), 1);
+	uint pass_count = std::max<uint>(BENCHMARK_ITERATION_VISITS / visited_count, 1);
+	float position_sum = 0.0f;
+	start_time = benchmark_clock::now();
+	for (uint pass = 0; pass < pass_count; ++pass) {
+		uint chunk_count = caliope::ecs_system_get_chunk_count(archetype);
+		for (uint chunk = 0; chunk < chunk_count; ++chunk) {
+			uchar* column_data = (uchar*)caliope::ecs_system_get_chunk_column_data(column, chunk);
+			caliope::ecs_for_each_enabled(caliope::ecs_system_get_chunk_enabled_mask(archetype, chunk), caliope::ecs_system_get_chunk_entity_count(archetype, chunk), [&](uint row) {
+				position_sum += *(float*)(column_data + (uint64)column.component_size * row);
+			});
+		}
+	}
+	double iterate_ns = elapsed_ns(start_time);
+	out_result.ns_per_operation[BENCHMARK_OPERATION_ITERATE] = iterate_ns / ((double)visited_count * pass_count);
+	out_result.iterate_bytes_per_second = (double)column.component_size * visited_count * pass_count / (iterate_ns / 1000000000.0);
+	checksum += (uint64)position_sum;
+
+	start_time = benchmark_clock::now();
+	for (uint i = 0; i < entity_count; ++i) {
+		caliope::ecs_system_delete_entity(random_entities[i]);
+	}
+	out_result.ns_per_operation[BENCHMARK_OPERATION_DELETE] = elapsed_ns(start_time) / entity_count;
+
+	// Same entities again in a single batch, with the iterated column given and the rest zeroed
+	std::vector<uchar> column_data((uint64)column.component_size * entity_count, 0);
+	const void* columns[] = { column_data.data() };
+	start_time = benchmark_clock::now();
+	caliope::ecs_system_spawn_batch(archetype, entity_count, 1, &bench_archetype.iterated_component, columns, entities.data());
+	out_result.ns_per_operation[BENCHMARK_OPERATION_SPAWN_BATCH] = elapsed_ns(start_time) / entity_count;
+
+	benchmark_sink = checksum;
+
+	for (uint i = 0; i < BENCHMARK_OPERATION_COUNT; ++i) {
+		printf("  %-14s %10.1f ns/op %10.2f Mops/s", operation_names[i], out_result.ns_per_operation[i], 1000.0 / out_result.ns_per_operation[i]);
+		if (i == BENCHMARK_OPERATION_ITERATE) {
+			printf(" %8.2f GB/s of column", out_result.iterate_bytes_per_second / 1000000000.0);
+		}
+		printf("\n");
+	}
+
+	caliope::ecs_system_shutdown();
+	caliope::memory_system_shutdown();
+	return true;
+}
+
+/**
+ * Runs every ECS operation on the builtin archetypes at 1k, 100k and 1M entities and prints the ns per operation, an archetype in a fresh ECS each time.
+ * The iteration also prints the bytes of the column read per second, to compare the layouts of the chunks.
+ * Usage: ecs_benchmark [max_entities]
+ */
+int main(int argc, char** argv) {
+	uint max_entities = argc > 1 ? (uint)atoi(argv[1]) : 0;
+
+	std::vector<benchmark_result> results;
+	for (uint i = 0; i < sizeof(archetypes) / sizeof(benchmark_archetype); ++i) {
+		for (uint j = 0; j < sizeof(entity_counts) / sizeof(uint); ++j) {
+			if (max_entities && entity_counts[j] > max_entities) {
+				continue;
+			}
+
+			benchmark_result result = {};
+			if (!run_archetype(archetypes[i], entity_counts[j], result)) {
+				return -1;
+			}
+			results.push_back(result);
+		}
+	}
+
+	printf("\n%-18s %9s", "archetype", "entities");
+	for (uint i = 0; i < BENCHMARK_OPERATION_COUNT; ++i) {
+		printf(" %14s", operation_names[i]);
+	}
+	printf(" %10s\n", "iter GB/s");
+	for (uint i = 0; i < results.size(); ++i) {
+		const benchmark_result& result = results[i];
+		printf("%-18s %9u", result.archetype_name, result.entity_count);
+		if (result.skipped) {
+			printf(" skipped\n");
+			continue;
+		}
+		for (uint j = 0; j < BENCHMARK_OPERATION_COUNT; ++j) {
+			printf(" %14.1f", result.ns_per_operation[j]);
+		}
+		printf(" %10.2f\n", result.iterate_bytes_per_second / 1000000000.0);
+	}
+
+	return 0;
+}
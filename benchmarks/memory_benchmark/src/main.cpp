@@ -0,0 +1,221 @@
+#include "memory_benchmark.h"
+
+#include <core/cememory.h>
+#include <core/logger.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#define BENCHMARK_DEFAULT_FRAME_COUNT 400
+#define BENCHMARK_FRAGMENTATION_SAMPLES 16
+#define BENCHMARK_FREELIST_OPERATIONS 250000
+
+typedef struct benchmark_trace {
+	const char* name;
+	PFN_benchmark_trace run;
+} benchmark_trace;
+
+typedef struct benchmark_result {
+	std::string name;
+	uint thread_count;
+	uint64 operation_count;
+	uint64 failed_allocations;
+	double seconds;
+	uint allocate_percentiles[5];
+	uint free_percentiles[5];
+	double final_fragmentation;
+} benchmark_result;
+
+static const benchmark_trace traces[] = {
+	{ "ecs_churn", trace_ecs_churn },
+	{ "loader_burst", trace_loader_burst },
+	{ "mixed_new", trace_mixed_new }
+};
+
+static const uint thread_counts[] = { 1, 2, 4, 8 };
+
+static const double percentiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+static double fragmentation_of(const fragmentation_sample& sample) {
+	// How much of the free space can't be handed out in a single block
+	if (!sample.free_space) {
+		return 0.0;
+	}
+	return 1.0 - (double)sample.largest_free_block / (double)sample.free_space;
+}
+
+static void compute_percentiles(std::vector<uint>& latencies, uint* out_percentiles) {
+	for (uint i = 0; i < 5; ++i) {
+		if (latencies.empty()) {
+			out_percentiles[i] = 0;
+			continue;
+		}
+
+		uint64 index = std::min<uint64>((uint64)(percentiles[i] * latencies.size()), latencies.size() - 1);
+		std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+		out_percentiles[i] = latencies[index];
+	}
+}
+
+static void print_percentiles(const char* label, const uint* values) {
+	printf("  %-9s ns: p50 %u, p90 %u, p99 %u, p99.9 %u, max %u\n", label, values[0], values[1], values[2], values[3], values[4]);
+}
+
+static void print_samples(const std::vector<fragmentation_sample>& samples) {
+	printf("  %8s %12s %8s %14s %14s %8s\n", "frame", "live(MiB)", "holes", "largest(MiB)", "free(MiB)", "frag");
+	for (uint i = 0; i < samples.size(); ++i) {
+		const fragmentation_sample& sample = samples[i];
+		printf("  %8u %12.2f %8llu %14.2f %14.2f %7.2f%%\n", sample.frame, sample.live_bytes / 1024.0 / 1024.0, sample.hole_count,
+			sample.largest_free_block / 1024.0 / 1024.0, sample.free_space / 1024.0 / 1024.0, fragmentation_of(sample) * 100.0);
+	}
+}
+
+static void finish_result(benchmark_result& result, std::vector<benchmark_thread_context>& contexts, std::vector<fragmentation_sample>& samples) {
+	std::vector<uint> allocate_latencies;
+	std::vector<uint> free_latencies;
+	for (uint i = 0; i < contexts.size(); ++i) {
+		allocate_latencies.insert(allocate_latencies.end(), contexts[i].allocate_latencies.begin(), contexts[i].allocate_latencies.end());
+		free_latencies.insert(free_latencies.end(), contexts[i].free_latencies.begin(), contexts[i].free_latencies.end());
+		result.failed_allocations += contexts[i].failed_allocations;
+	}
+	result.operation_count = allocate_latencies.size() + free_latencies.size();
+	compute_percentiles(allocate_latencies, result.allocate_percentiles);
+	compute_percentiles(free_latencies, result.free_percentiles);
+	result.final_fragmentation = samples.empty() ? 0.0 : fragmentation_of(samples.back());
+
+	printf("  %llu operations in %.3fs: %.2f Mops/s, %llu failed allocations\n", result.operation_count, result.seconds,
+		result.operation_count / result.seconds / 1000000.0, result.failed_allocations);
+	print_percentiles("allocate", result.allocate_percentiles);
+	print_percentiles("free", result.free_percentiles);
+	print_samples(samples);
+}
+
+static void init_context(benchmark_thread_context& context, uint thread_index, uint frame_count) {
+	context.thread_index = thread_index;
+	context.frame_count = frame_count;
+	context.random_state = 0x9E3779B97F4A7C15ULL * (thread_index + 1);
+	context.failed_allocations = 0;
+	context.samples = nullptr;
+	context.sample_interval = std::max<uint>(frame_count / BENCHMARK_FRAGMENTATION_SAMPLES, 1);
+	context.ready_count = nullptr;
+	context.start = nullptr;
+}
+
+static bool run_trace(const benchmark_trace& trace, uint thread_count, caliope::freelist_type heap_type, uint frame_count, benchmark_result& out_result) {
+	caliope::memory_system_configuration memory_config = {};
+	memory_config.total_alloc_size = MEBIBYTES(256);
+	memory_config.max_alloc_size = GIBIBYTES(2ULL);
+	memory_config.reserve_address_space = true;
+	memory_config.allocator_freelist_type = heap_type;
+	memory_config.track_callsites = false;
+	if (!caliope::memory_system_initialize(memory_config)) {
+		CE_LOG_FATAL("Failed to initialize the memory system for the benchmark");
+		return false;
+	}
+
+	printf("\n== %s, %u threads\n", trace.name, thread_count);
+
+	std::atomic<uint> ready_count = 0;
+	std::atomic<bool> start = false;
+	std::vector<fragmentation_sample> samples;
+	std::vector<benchmark_thread_context> contexts(thread_count);
+	for (uint i = 0; i < thread_count; ++i) {
+		init_context(contexts[i], i, frame_count);
+		contexts[i].samples = i == 0 ? &samples : nullptr;
+		contexts[i].ready_count = &ready_count;
+		contexts[i].start = &start;
+	}
+
+	std::vector<std::thread> threads;
+	for (uint i = 0; i < thread_count; ++i) {
+		threads.emplace_back(trace.run, std::ref(contexts[i]));
+	}
+
+	// The traces fill their working set before the start, only the steady state is measured
+	while (ready_count.load() < thread_count) {
+		std::this_thread::yield();
+	}
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+
+	for (uint i = 0; i < thread_count; ++i) {
+		threads[i].join();
+	}
+
+	std::chrono::steady_clock::time_point finish_time = start_time;
+	for (uint i = 0; i < thread_count; ++i) {
+		finish_time = std::max(finish_time, contexts[i].finish_time);
+	}
+
+	out_result.name = trace.name;
+	out_result.thread_count = thread_count;
+	out_result.seconds = std::chrono::duration<double>(finish_time - start_time).count();
+	finish_result(out_result, contexts, samples);
+
+	caliope::memory_system_shutdown();
+	return true;
+}
+
+static void run_freelist(caliope::freelist_type type, benchmark_result& out_result) {
+	out_result.name = type == caliope::FREELIST_TYPE_BINNED ? "freelist_binned" : "freelist_linked_list";
+	printf("\n== %s, 1 thread\n", out_result.name.c_str());
+
+	std::vector<fragmentation_sample> samples;
+	std::vector<benchmark_thread_context> contexts(1);
+	init_context(contexts[0], 0, BENCHMARK_FREELIST_OPERATIONS / 1024);
+	contexts[0].samples = &samples;
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	trace_freelist(type, BENCHMARK_FREELIST_OPERATIONS, contexts[0]);
+
+	out_result.thread_count = 1;
+	out_result.seconds = std::chrono::duration<double>(contexts[0].finish_time - start_time).count();
+	finish_result(out_result, contexts, samples);
+}
+
+/**
+ * Replays the allocation traces at 1 to 8 threads and prints the throughput, the latency percentiles and the fragmentation of the heap over time.
+ * Usage: memory_benchmark [binned|linked_list] [frame_count]
+ */
+int main(int argc, char** argv) {
+	caliope::freelist_type heap_type = caliope::FREELIST_TYPE_BINNED;
+	if (argc > 1 && strcmp(argv[1], "linked_list") == 0) {
+		heap_type = caliope::FREELIST_TYPE_LINKED_LIST;
+	}
+	uint frame_count = argc > 2 ? (uint)atoi(argv[2]) : BENCHMARK_DEFAULT_FRAME_COUNT;
+	if (!frame_count) {
+		frame_count = BENCHMARK_DEFAULT_FRAME_COUNT;
+	}
+
+	printf("Memory benchmark: heap freelist %s, %u frames per trace\n", heap_type == caliope::FREELIST_TYPE_BINNED ? "binned" : "linked_list", frame_count);
+
+	std::vector<benchmark_result> results;
+	for (uint i = 0; i < sizeof(traces) / sizeof(benchmark_trace); ++i) {
+		for (uint j = 0; j < sizeof(thread_counts) / sizeof(uint); ++j) {
+			benchmark_result result = {};
+			if (!run_trace(traces[i], thread_counts[j], heap_type, frame_count, result)) {
+				return -1;
+			}
+			results.push_back(result);
+		}
+	}
+
+	for (uint i = 0; i < 2; ++i) {
+		benchmark_result result = {};
+		run_freelist(i == 0 ? caliope::FREELIST_TYPE_LINKED_LIST : caliope::FREELIST_TYPE_BINNED, result);
+		results.push_back(result);
+	}
+
+	printf("\n%-22s %8s %10s %10s %10s %10s %10s %8s\n", "trace", "threads", "Mops/s", "alloc p50", "alloc p99", "free p50", "free p99", "frag");
+	for (uint i = 0; i < results.size(); ++i) {
+		const benchmark_result& result = results[i];
+		printf("%-22s %8u %10.2f %10u %10u %10u %10u %7.2f%%\n", result.name.c_str(), result.thread_count, result.operation_count / result.seconds / 1000000.0,
+			result.allocate_percentiles[0], result.allocate_percentiles[2], result.free_percentiles[0], result.free_percentiles[2], result.final_fragmentation * 100.0);
+	}
+
+	return 0;
+}
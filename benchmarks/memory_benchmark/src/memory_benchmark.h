@@ -0,0 +1,57 @@
+#pragma once
+
+#include <defines.h>
+#include <containers/freelist.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+typedef struct fragmentation_sample {
+	uint frame;
+	uint64 live_bytes;
+	uint64 hole_count;
+	uint64 largest_free_block;
+	uint64 free_space;
+} fragmentation_sample;
+
+typedef struct benchmark_thread_context {
+	uint thread_index;
+	uint frame_count;
+	uint64 random_state;
+
+	// Latencies in nanoseconds of every timed operation
+	std::vector<uint> allocate_latencies;
+	std::vector<uint> free_latencies;
+	uint64 failed_allocations;
+	std::chrono::steady_clock::time_point finish_time;
+
+	// Only the first thread samples the heap, every sample_interval frames
+	std::vector<fragmentation_sample>* samples;
+	uint sample_interval;
+
+	std::atomic<uint>* ready_count;
+	std::atomic<bool>* start;
+} benchmark_thread_context;
+
+typedef void (*PFN_benchmark_trace)(benchmark_thread_context& context);
+
+/**
+ * @brief Spawns and destroys entities with the component sizes of the builtin archetypes, every component is a zeroed allocation like in the ECS.
+ */
+void trace_ecs_churn(benchmark_thread_context& context);
+
+/**
+ * @brief Loads a scene every few frames: a component block, a few image buffers and many small records, that live for a few loads and are freed together.
+ */
+void trace_loader_burst(benchmark_thread_context& context);
+
+/**
+ * @brief Replays what the engine's operator new does with a mix of object sizes and lifetimes, mostly small blocks.
+ */
+void trace_mixed_new(benchmark_thread_context& context);
+
+/**
+ * @brief Replays a random trace of blocks up to 64KiB straight on a freelist, to measure the list without the pools and the locks.
+ */
+void trace_freelist(caliope::freelist_type type, uint operation_count, benchmark_thread_context& context);
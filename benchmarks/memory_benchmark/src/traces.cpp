@@ -0,0 +1,348 @@
+#include "memory_benchmark.h"
+
+#include <core/cememory.h>
+#include <components/components.inl>
+
+#include <thread>
+
+// Live entities of every thread and how many are destroyed and spawned again each frame
+#define ECS_CHURN_LIVE_ENTITIES 8192
+#define ECS_CHURN_ENTITIES_PER_FRAME 256
+#define ECS_CHURN_MAX_COMPONENTS 6
+
+// A scene is loaded every LOADER_BURST_INTERVAL frames and the oldest one is unloaded when there are LOADER_LIVE_SCENES
+#define LOADER_BURST_INTERVAL 8
+#define LOADER_LIVE_SCENES 4
+#define LOADER_MAX_IMAGES 6
+#define LOADER_MAX_RECORDS 256
+#define LOADER_TEMPORARIES_PER_FRAME 32
+
+#define MIXED_NEW_SLOTS 8192
+#define MIXED_NEW_OPERATIONS_PER_FRAME 2048
+
+#define FREELIST_BENCHMARK_SIZE MEBIBYTES(256)
+#define FREELIST_BENCHMARK_SLOTS 4096
+
+typedef std::chrono::steady_clock benchmark_clock;
+
+typedef struct churn_archetype {
+	uint component_count;
+	uint64 component_sizes[ECS_CHURN_MAX_COMPONENTS];
+} churn_archetype;
+
+// Same components as the builtin archetypes of the ECS
+static const churn_archetype churn_archetypes[] = {
+	{ 2, { sizeof(caliope::transform_component), sizeof(caliope::material_component) } },
+	{ 2, { sizeof(caliope::transform_component), sizeof(caliope::material_animation_component) } },
+	{ 2, { sizeof(caliope::transform_component), sizeof(caliope::point_light_component) } },
+	{ 4, { sizeof(caliope::parent_component), sizeof(caliope::ui_transform_component), sizeof(caliope::ui_material_component), sizeof(caliope::ui_behaviour_component) } },
+	{ 6, { sizeof(caliope::parent_component), sizeof(caliope::ui_transform_component), sizeof(caliope::ui_material_component), sizeof(caliope::ui_dynamic_material_component), sizeof(caliope::ui_events_component), sizeof(caliope::ui_behaviour_component) } },
+	{ 4, { sizeof(caliope::parent_component), sizeof(caliope::ui_transform_component), sizeof(caliope::ui_text_component), sizeof(caliope::ui_behaviour_component) } },
+	{ 3, { sizeof(caliope::parent_component), sizeof(caliope::ui_transform_component), sizeof(caliope::ui_container_component) } }
+};
+
+typedef struct churn_entity {
+	uint archetype_index;
+	void* components[ECS_CHURN_MAX_COMPONENTS];
+} churn_entity;
+
+typedef struct loaded_block {
+	void* block;
+	uint64 size;
+	caliope::memory_tag tag;
+} loaded_block;
+
+typedef struct loaded_scene {
+	uint block_count;
+	loaded_block blocks[1 + LOADER_MAX_IMAGES + LOADER_MAX_RECORDS];
+} loaded_scene;
+
+static uint64 random_next(benchmark_thread_context& context) {
+	// xorshift64*, every thread replays the same sequence on every run
+	context.random_state ^= context.random_state >> 12;
+	context.random_state ^= context.random_state << 25;
+	context.random_state ^= context.random_state >> 27;
+	return context.random_state * 2685821657736338717ULL;
+}
+
+static uint64 random_range(benchmark_thread_context& context, uint64 min, uint64 max) {
+	return min + random_next(context) % (max - min);
+}
+
+static uint elapsed_nanoseconds(benchmark_clock::time_point start, benchmark_clock::time_point end) {
+	long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	return nanoseconds > 0xFFFFFFFFLL ? 0xFFFFFFFFU : (uint)nanoseconds;
+}
+
+static void* timed_allocate(benchmark_thread_context& context, caliope::memory_tag tag, uint64 size, bool zeroed) {
+	benchmark_clock::time_point start = benchmark_clock::now();
+	void* block = zeroed ? caliope::allocate_memory(tag, size) : caliope::allocate_memory_uninitialized(tag, size);
+	benchmark_clock::time_point end = benchmark_clock::now();
+
+	if (!block) {
+		context.failed_allocations++;
+		return nullptr;
+	}
+	context.allocate_latencies.push_back(elapsed_nanoseconds(start, end));
+	return block;
+}
+
+static void timed_free(benchmark_thread_context& context, caliope::memory_tag tag, void* block, uint64 size) {
+	if (!block) {
+		return;
+	}
+
+	benchmark_clock::time_point start = benchmark_clock::now();
+	caliope::free_memory(tag, block, size);
+	benchmark_clock::time_point end = benchmark_clock::now();
+
+	context.free_latencies.push_back(elapsed_nanoseconds(start, end));
+}
+
+static void wait_start(benchmark_thread_context& context) {
+	context.ready_count->fetch_add(1);
+	while (!context.start->load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+}
+
+static void end_frame(benchmark_thread_context& context, uint frame) {
+	if (!context.samples || (frame % context.sample_interval != 0 && frame != context.frame_count - 1)) {
+		return;
+	}
+
+	caliope::freelist_metrics metrics;
+	caliope::get_memory_heap_metrics(metrics);
+
+	fragmentation_sample sample;
+	sample.frame = frame;
+	sample.live_bytes = caliope::get_memory_usage();
+	sample.hole_count = metrics.hole_count;
+	sample.largest_free_block = metrics.largest_free_block;
+	sample.free_space = metrics.free_space;
+	context.samples->push_back(sample);
+}
+
+static void churn_spawn(benchmark_thread_context& context, churn_entity& out_entity, bool timed) {
+	out_entity.archetype_index = (uint)random_range(context, 0, sizeof(churn_archetypes) / sizeof(churn_archetype));
+	const churn_archetype& archetype = churn_archetypes[out_entity.archetype_index];
+	for (uint i = 0; i < archetype.component_count; ++i) {
+		uint64 size = archetype.component_sizes[i];
+		out_entity.components[i] = timed ? timed_allocate(context, caliope::MEMORY_TAG_ECS, size, true) : caliope::allocate_memory(caliope::MEMORY_TAG_ECS, size);
+	}
+}
+
+static void churn_destroy(benchmark_thread_context& context, churn_entity& entity, bool timed) {
+	const churn_archetype& archetype = churn_archetypes[entity.archetype_index];
+	for (uint i = 0; i < archetype.component_count; ++i) {
+		if (timed) {
+			timed_free(context, caliope::MEMORY_TAG_ECS, entity.components[i], archetype.component_sizes[i]);
+		}
+		else if (entity.components[i]) {
+			caliope::free_memory(caliope::MEMORY_TAG_ECS, entity.components[i], archetype.component_sizes[i]);
+		}
+	}
+}
+
+void trace_ecs_churn(benchmark_thread_context& context) {
+	std::vector<churn_entity> entities(ECS_CHURN_LIVE_ENTITIES);
+	for (uint i = 0; i < ECS_CHURN_LIVE_ENTITIES; ++i) {
+		churn_spawn(context, entities[i], false);
+	}
+
+	wait_start(context);
+
+	for (uint frame = 0; frame < context.frame_count; ++frame) {
+		// Destroyed entities leave holes all over the pools, the spawned ones are appended like new entities in the ECS
+		for (uint i = 0; i < ECS_CHURN_ENTITIES_PER_FRAME; ++i) {
+			uint index = (uint)random_range(context, 0, entities.size());
+			churn_destroy(context, entities[index], true);
+			entities[index] = entities.back();
+			entities.pop_back();
+		}
+
+		for (uint i = 0; i < ECS_CHURN_ENTITIES_PER_FRAME; ++i) {
+			churn_entity entity;
+			churn_spawn(context, entity, true);
+			entities.push_back(entity);
+		}
+
+		end_frame(context, frame);
+	}
+	context.finish_time = benchmark_clock::now();
+
+	for (uint i = 0; i < entities.size(); ++i) {
+		churn_destroy(context, entities[i], false);
+	}
+}
+
+static void loader_load_scene(benchmark_thread_context& context, loaded_scene& out_scene) {
+	out_scene.block_count = 0;
+
+	// Components of the scene, copied from the loader scratch in one block
+	uint64 components_size = random_range(context, 1, 32) * KIBIBYTES(16);
+	out_scene.blocks[out_scene.block_count++] = { timed_allocate(context, caliope::MEMORY_TAG_LOADER, components_size, false), components_size, caliope::MEMORY_TAG_LOADER };
+
+	// Pixels of the textures, power of two sizes from 128x128 to 1024x1024 RGBA
+	uint image_count = (uint)random_range(context, 2, LOADER_MAX_IMAGES + 1);
+	for (uint i = 0; i < image_count; ++i) {
+		uint64 image_size = (128ULL << random_range(context, 0, 4)) * (128ULL << random_range(context, 0, 4)) * 4;
+		out_scene.blocks[out_scene.block_count++] = { timed_allocate(context, caliope::MEMORY_TAG_LOADER, image_size, false), image_size, caliope::MEMORY_TAG_LOADER };
+	}
+
+	// Names, resource records and small tables
+	uint record_count = (uint)random_range(context, 64, LOADER_MAX_RECORDS + 1);
+	for (uint i = 0; i < record_count; ++i) {
+		uint64 record_size = random_range(context, 16, 512);
+		out_scene.blocks[out_scene.block_count++] = { timed_allocate(context, caliope::MEMORY_TAG_NEW_OPERATOR, record_size, false), record_size, caliope::MEMORY_TAG_NEW_OPERATOR };
+	}
+}
+
+static void loader_unload_scene(benchmark_thread_context& context, loaded_scene& scene, bool timed) {
+	for (uint i = 0; i < scene.block_count; ++i) {
+		loaded_block& loaded = scene.blocks[i];
+		if (timed) {
+			timed_free(context, loaded.tag, loaded.block, loaded.size);
+		}
+		else if (loaded.block) {
+			caliope::free_memory(loaded.tag, loaded.block, loaded.size);
+		}
+	}
+	scene.block_count = 0;
+}
+
+void trace_loader_burst(benchmark_thread_context& context) {
+	std::vector<loaded_scene> scenes(LOADER_LIVE_SCENES);
+	for (uint i = 0; i < LOADER_LIVE_SCENES; ++i) {
+		scenes[i].block_count = 0;
+	}
+	uint next_scene = 0;
+	loaded_block temporaries[LOADER_TEMPORARIES_PER_FRAME];
+
+	wait_start(context);
+
+	for (uint frame = 0; frame < context.frame_count; ++frame) {
+		if (frame % LOADER_BURST_INTERVAL == 0) {
+			loader_unload_scene(context, scenes[next_scene], true);
+			loader_load_scene(context, scenes[next_scene]);
+			next_scene = (next_scene + 1) % LOADER_LIVE_SCENES;
+		}
+
+		// Strings and small objects that only live during the frame
+		for (uint i = 0; i < LOADER_TEMPORARIES_PER_FRAME; ++i) {
+			uint64 size = random_range(context, 32, 256);
+			temporaries[i] = { timed_allocate(context, caliope::MEMORY_TAG_NEW_OPERATOR, size, false), size, caliope::MEMORY_TAG_NEW_OPERATOR };
+		}
+		for (uint i = 0; i < LOADER_TEMPORARIES_PER_FRAME; ++i) {
+			timed_free(context, caliope::MEMORY_TAG_NEW_OPERATOR, temporaries[i].block, temporaries[i].size);
+		}
+
+		end_frame(context, frame);
+	}
+	context.finish_time = benchmark_clock::now();
+
+	for (uint i = 0; i < LOADER_LIVE_SCENES; ++i) {
+		loader_unload_scene(context, scenes[i], false);
+	}
+}
+
+static uint64 mixed_new_size(benchmark_thread_context& context) {
+	uint64 roll = random_range(context, 0, 100);
+	if (roll < 60) {
+		return random_range(context, 8, 64);
+	}
+	if (roll < 85) {
+		return random_range(context, 64, 512);
+	}
+	if (roll < 97) {
+		return random_range(context, 512, KIBIBYTES(4));
+	}
+	return random_range(context, KIBIBYTES(4), KIBIBYTES(64));
+}
+
+void trace_mixed_new(benchmark_thread_context& context) {
+	std::vector<loaded_block> slots(MIXED_NEW_SLOTS, { nullptr, 0, caliope::MEMORY_TAG_NEW_OPERATOR });
+
+	// Half of the slots are filled before measuring, every operation frees a random slot if it is taken or fills it otherwise
+	for (uint i = 0; i < MIXED_NEW_SLOTS; i += 2) {
+		slots[i].size = mixed_new_size(context);
+		slots[i].block = caliope::allocate_memory_uninitialized(caliope::MEMORY_TAG_NEW_OPERATOR, slots[i].size);
+	}
+
+	wait_start(context);
+
+	for (uint frame = 0; frame < context.frame_count; ++frame) {
+		for (uint i = 0; i < MIXED_NEW_OPERATIONS_PER_FRAME; ++i) {
+			loaded_block& slot = slots[random_range(context, 0, MIXED_NEW_SLOTS)];
+			if (slot.block) {
+				timed_free(context, caliope::MEMORY_TAG_NEW_OPERATOR, slot.block, slot.size);
+				slot.block = nullptr;
+			}
+			else {
+				slot.size = mixed_new_size(context);
+				slot.block = timed_allocate(context, caliope::MEMORY_TAG_NEW_OPERATOR, slot.size, false);
+			}
+		}
+
+		end_frame(context, frame);
+	}
+	context.finish_time = benchmark_clock::now();
+
+	for (uint i = 0; i < MIXED_NEW_SLOTS; ++i) {
+		if (slots[i].block) {
+			caliope::free_memory(caliope::MEMORY_TAG_NEW_OPERATOR, slots[i].block, slots[i].size);
+		}
+	}
+}
+
+void trace_freelist(caliope::freelist_type type, uint operation_count, benchmark_thread_context& context) {
+	uint64 memory_requirement = 0;
+	caliope::freelist list;
+	caliope::freelist_create(FREELIST_BENCHMARK_SIZE, type, memory_requirement, nullptr, list);
+	std::vector<uchar> list_memory(memory_requirement);
+	caliope::freelist_create(FREELIST_BENCHMARK_SIZE, type, memory_requirement, list_memory.data(), list);
+
+	typedef struct freelist_slot {
+		uint64 offset;
+		uint64 size;
+	} freelist_slot;
+	std::vector<freelist_slot> slots(FREELIST_BENCHMARK_SLOTS, { 0, 0 });
+	uint64 live_bytes = 0;
+
+	for (uint i = 0; i < operation_count; ++i) {
+		freelist_slot& slot = slots[random_range(context, 0, FREELIST_BENCHMARK_SLOTS)];
+		if (slot.size) {
+			benchmark_clock::time_point start = benchmark_clock::now();
+			caliope::freelist_free_block(list, slot.size, slot.offset);
+			context.free_latencies.push_back(elapsed_nanoseconds(start, benchmark_clock::now()));
+			live_bytes -= slot.size;
+			slot.size = 0;
+		}
+		else {
+			// Sizes spread over every power of two from 16B to 64KiB, rounded to 16 like in the dynamic allocator
+			uint64 size = (16ULL << random_range(context, 0, 13)) + random_range(context, 0, 16) * 16;
+			benchmark_clock::time_point start = benchmark_clock::now();
+			bool allocated = caliope::freelist_allocate_block(list, size, slot.offset);
+			benchmark_clock::time_point end = benchmark_clock::now();
+			if (allocated) {
+				context.allocate_latencies.push_back(elapsed_nanoseconds(start, end));
+				slot.size = size;
+				live_bytes += size;
+			}
+			else {
+				context.failed_allocations++;
+			}
+		}
+
+		// A frame every 1024 operations, to sample the list like the heap
+		uint frame = i / 1024;
+		if (context.samples && i % 1024 == 1023 && (frame % context.sample_interval == 0 || i + 1024 >= operation_count)) {
+			caliope::freelist_metrics metrics;
+			caliope::freelist_get_metrics(list, metrics);
+			context.samples->push_back({ frame, live_bytes, metrics.hole_count, metrics.largest_free_block, metrics.free_space });
+		}
+	}
+	context.finish_time = benchmark_clock::now();
+
+	caliope::freelist_destroy(list);
+}
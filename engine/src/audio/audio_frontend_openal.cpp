@@ -2,10 +2,12 @@
 #include "core/logger.h"
 #include "core/cememory.h"
 #include "core/asserts.h"
+#include "containers/slot_map.h"
 
 #include <miniaudio.h>
 #include <thread>
 #include <chrono>
+#include <mutex>
 
 #include <fstream>
 
@@ -17,10 +19,11 @@ namespace caliope {
 
 		ma_engine engine;
 
-		std::array<ma_sound, MAX_SOUND_COUNT> sounds;
-		std::vector<uint> reusable_ids;
-
-		uint current_sounds_count;
+		// The emmiter ids are handles of the slot map, a destroyed emmiter id is detected as stale instead of using the sound that reused its slot.
+		// The sounds are allocated apart because miniaudio keeps their address while the slot map moves its values.
+		slot_map<ma_sound*> sounds;
+		// The delayed play/stop/pause threads look up the sounds after the delay, it guards them from the create and destroy of the main thread
+		std::mutex sounds_mutex;
 
 	} miniaudio_state;
 
@@ -34,7 +37,7 @@ namespace caliope {
 			return false;
 		}
 
-		state_ptr->current_sounds_count = 0;
+		slot_map_create(state_ptr->sounds, MAX_SOUND_COUNT);
 
 		if (ma_engine_init(NULL, &state_ptr->engine) != MA_SUCCESS) {
 			return false;
@@ -48,41 +51,36 @@ namespace caliope {
 
 	void audio_frontend_destroy() {
 
-		ma_engine_uninit(&state_ptr->engine);
-
-		for (uint i = 0; i < MAX_SOUND_COUNT; ++i) {
-			if (state_ptr->sounds[i].pDataSource != nullptr) {
-				ma_sound_uninit(&state_ptr->sounds[i]);
-			}
+		// The sounds are nodes of the engine graph, uninit them before the engine
+		for (ma_sound* sound : state_ptr->sounds) {
+			ma_sound_uninit(sound);
+			free_memory(MEMORY_TAG_AUDIO, sound, sizeof(ma_sound));
 		}
+		slot_map_destroy(state_ptr->sounds);
+
+		ma_engine_uninit(&state_ptr->engine);
 
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
 
-
-	uint audio_frontend_create_emmiter(uint format,	int channels, uint sample_rate, uint total_samples_left , void* data, uint data_size) {
-		
-		if (state_ptr->current_sounds_count >= MAX_SOUND_COUNT) {
-			CE_LOG_WARNING("create_emmiter reached maximum emmiters created, use destroy_emmiter to free space. Returning 0");
-			return 0;
+	static ma_sound* get_sound(uint emmiter_id) {
+		ma_sound** sound = slot_map_get(state_ptr->sounds, emmiter_id);
+		if (!sound) {
+			CE_LOG_WARNING("audio emmiter %u doesn't exist or was destroyed", emmiter_id);
+			return nullptr;
 		}
+		return *sound;
+	}
 
-		bool has_reusable_id = !state_ptr->reusable_ids.empty();
-
-		uint source_id = -1;
-		if (has_reusable_id) {
-			source_id = state_ptr->reusable_ids.back();
-			state_ptr->reusable_ids.pop_back();
-
-		} else {
 
-			source_id = state_ptr->current_sounds_count;
-			state_ptr->current_sounds_count++;
+	uint audio_frontend_create_emmiter(uint format,	int channels, uint sample_rate, uint total_samples_left , void* data, uint data_size) {
+		
+		if (slot_map_size(state_ptr->sounds) >= MAX_SOUND_COUNT) {
+			CE_LOG_WARNING("create_emmiter reached maximum emmiters created, use destroy_emmiter to free space. Returning INVALID_ID");
+			return INVALID_ID;
 		}
 
-
-
 		ma_decoder decoder;
 		ma_uint64 length_in_pcm_frames;
 		ma_result result = ma_decoder_init_file((const char*)data, NULL, &decoder);
@@ -97,19 +95,32 @@ namespace caliope {
 			flags |= MA_SOUND_FLAG_STREAM;
 		}
 
-		ma_sound_init_from_file(&state_ptr->engine, (const char*)data, flags, nullptr, nullptr, &state_ptr->sounds[source_id]);
+		ma_sound* sound = (ma_sound*)allocate_memory(MEMORY_TAG_AUDIO, sizeof(ma_sound));
+		ma_sound_init_from_file(&state_ptr->engine, (const char*)data, flags, nullptr, nullptr, sound);
 
-		return source_id;
+		std::lock_guard<std::mutex> lock(state_ptr->sounds_mutex);
+		return slot_map_insert(state_ptr->sounds, sound);
 	}
 
 	void audio_frontend_destroy_emmiter(uint emmiter_id) {
-		ma_sound_uninit(&state_ptr->sounds[emmiter_id]);
-		state_ptr->reusable_ids.push_back(emmiter_id);
+		std::lock_guard<std::mutex> lock(state_ptr->sounds_mutex);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (!sound) {
+			return;
+		}
+
+		ma_sound_uninit(sound);
+		free_memory(MEMORY_TAG_AUDIO, sound, sizeof(ma_sound));
+		slot_map_remove(state_ptr->sounds, emmiter_id);
 	}
 
 	void play_emmiter(uint emmiter_id, uint delay_ms) {
 		std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-		ma_sound_start(&state_ptr->sounds[emmiter_id]);
+		std::lock_guard<std::mutex> lock(state_ptr->sounds_mutex);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (sound) {
+			ma_sound_start(sound);
+		}
 	}
 	void audio_frontend_play_emmiter(uint emmiter_id, uint delay_ms) {
 		std::thread thread(play_emmiter, emmiter_id, delay_ms);
@@ -118,8 +129,12 @@ namespace caliope {
 
 	void stop_emmiter(uint emmiter_id, uint delay_ms) {
 		std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-		ma_sound_stop(&state_ptr->sounds[emmiter_id]);
-		ma_sound_seek_to_pcm_frame(&state_ptr->sounds[emmiter_id], 0);
+		std::lock_guard<std::mutex> lock(state_ptr->sounds_mutex);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (sound) {
+			ma_sound_stop(sound);
+			ma_sound_seek_to_pcm_frame(sound, 0);
+		}
 	}
 	void audio_frontend_stop_emmiter(uint emmiter_id, uint delay_ms) {
 		std::thread thread(stop_emmiter, emmiter_id, delay_ms);
@@ -128,27 +143,44 @@ namespace caliope {
 
 	void pause_emmiter(uint emmiter_id, uint delay_ms) {
 		std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-		ma_sound_stop(&state_ptr->sounds[emmiter_id]);
+		std::lock_guard<std::mutex> lock(state_ptr->sounds_mutex);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (sound) {
+			ma_sound_stop(sound);
+		}
 	}
 	void audio_frontend_pause_emmiter(uint emmiter_id, uint delay_ms) {
 		std::thread thread(pause_emmiter, emmiter_id, delay_ms);
 		thread.detach();
 	}
 
+	// NOTE: The slot map is only modified from the main thread, the lookups of the main thread don't need the lock
 	void audio_frontend_fade_emmiter(uint emmiter_id, float begin_volume, float end_volume, uint64 time_ms) {
-		ma_sound_set_fade_in_milliseconds(&state_ptr->sounds[emmiter_id], begin_volume, end_volume, time_ms);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (sound) {
+			ma_sound_set_fade_in_milliseconds(sound, begin_volume, end_volume, time_ms);
+		}
 	}
 
 	void audio_frontend_loop_emmiter(uint emmiter_id, bool loop) {
-		ma_sound_set_looping(&state_ptr->sounds[emmiter_id], loop);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (sound) {
+			ma_sound_set_looping(sound, loop);
+		}
 	}
 
 	void audio_frontend_set_emmiter_gain(uint emmiter_id, float gain) {
-		ma_sound_set_volume(&state_ptr->sounds[emmiter_id], gain);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (sound) {
+			ma_sound_set_volume(sound, gain);
+		}
 	}
 
 	void audio_frontend_positionate_emmiter(uint emmiter_id, glm::vec3 position) {
-		ma_sound_set_position(&state_ptr->sounds[emmiter_id], position.x, position.y, position.z);
+		ma_sound* sound = get_sound(emmiter_id);
+		if (sound) {
+			ma_sound_set_position(sound, position.x, position.y, position.z);
+		}
 	}
 
 	void audio_frontend_move_listener(glm::vec3 new_position) {
@@ -1,5 +1,6 @@
 #pragma once
 #include "defines.h"
+#include "core/name_id.h"
 #include <glm/glm.hpp>
 
 
@@ -14,11 +15,17 @@ namespace caliope {
 		std::array<char, MAX_NAME_LENGTH> material_name;
 		uint z_order;
 		std::array<glm::vec2, 2> texture_region;
+
+		// Note: Not parsed, id of material_name set by the ECS when the component is spawned or inserted. Change the name with ecs_system_insert_data.
+		name_id material_id;
 	} material_component;
 
 	typedef struct material_animation_component {
 		std::array<char, MAX_NAME_LENGTH> animation_name;
 		uint z_order;
+
+		// Note: Not parsed, id of animation_name set by the ECS when the component is spawned or inserted. Change the name with ecs_system_insert_data.
+		name_id animation_id;
 	} material_animation_component;
 
 	typedef struct sound_emmiter_component {
@@ -67,6 +74,9 @@ namespace caliope {
 	typedef struct ui_material_component {
 		std::array<char, MAX_NAME_LENGTH> material_name;
 		std::array<glm::vec2, 2> texture_region;
+
+		// Note: Not parsed, id of material_name set by the ECS when the component is spawned or inserted. Change the name with ecs_system_insert_data.
+		name_id material_id;
 	} ui_material_component;
 
 	typedef struct ui_dynamic_material_component {
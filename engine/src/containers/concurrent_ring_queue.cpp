@@ -0,0 +1,146 @@
+#include "concurrent_ring_queue.h"
+
+#include "core/cememory.h"
+#include "core/logger.h"
+
+#include <new>
+
+namespace caliope {
+	// The value is stored right after the sequence, the slots are padded to keep the sequences aligned
+	typedef struct concurrent_ring_queue_slot {
+		std::atomic<uint64> sequence;
+	} concurrent_ring_queue_slot;
+
+	static uint get_slot_size(uint stride) {
+		uint64 size = sizeof(concurrent_ring_queue_slot) + stride;
+		return (uint)((size + alignof(concurrent_ring_queue_slot) - 1) & ~(uint64)(alignof(concurrent_ring_queue_slot) - 1));
+	}
+
+	static concurrent_ring_queue_slot* get_slot(concurrent_ring_queue& queue, uint64 position) {
+		return (concurrent_ring_queue_slot*)((char*)queue.block + (position & (queue.capacity - 1)) * queue.slot_size);
+	}
+
+	uint64 concurrent_ring_queue_memory_requirement(uint stride, uint capacity) {
+		return (uint64)get_slot_size(stride) * capacity;
+	}
+
+	bool concurrent_ring_queue_create(uint stride, uint capacity, void* memory, concurrent_ring_queue& out_queue)
+	{
+		if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+			CE_LOG_ERROR("concurrent_ring_queue_create capacity must be a power of two, got %u", capacity);
+			return false;
+		}
+
+		out_queue.capacity = capacity;
+		out_queue.stride = stride;
+		out_queue.slot_size = get_slot_size(stride);
+		out_queue.enqueue_position.store(0, std::memory_order_relaxed);
+		out_queue.dequeue_position.store(0, std::memory_order_relaxed);
+
+		uint64 memory_requirement = concurrent_ring_queue_memory_requirement(stride, capacity);
+		if (memory) {
+			out_queue.owns_memory = false;
+			out_queue.block = memory;
+		}
+		else {
+			out_queue.owns_memory = true;
+			out_queue.block = allocate_memory_uninitialized(MEMORY_TAG_RING_QUEUE, memory_requirement);
+		}
+
+		// The slot i is free to be written by the producer that takes the position i
+		for (uint i = 0; i < capacity; ++i) {
+			new (get_slot(out_queue, i)) concurrent_ring_queue_slot{ i };
+		}
+
+		return true;
+	}
+
+	void concurrent_ring_queue_destroy(concurrent_ring_queue& queue)
+	{
+		if (queue.owns_memory) {
+			free_memory(MEMORY_TAG_RING_QUEUE, queue.block, concurrent_ring_queue_memory_requirement(queue.stride, queue.capacity));
+		}
+
+		queue.block = nullptr;
+		queue.owns_memory = false;
+		queue.capacity = 0;
+		queue.stride = 0;
+		queue.slot_size = 0;
+		queue.enqueue_position.store(0, std::memory_order_relaxed);
+		queue.dequeue_position.store(0, std::memory_order_relaxed);
+	}
+
+	bool concurrent_ring_queue_enqueue(concurrent_ring_queue& queue, const void* value)
+	{
+		if (value == nullptr) {
+			CE_LOG_ERROR("concurrent_ring_queue_enqueue requires a valid value");
+			return false;
+		}
+
+		concurrent_ring_queue_slot* slot = nullptr;
+		uint64 position = queue.enqueue_position.load(std::memory_order_relaxed);
+		while (true) {
+			slot = get_slot(queue, position);
+			uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+			int64 difference = (int64)sequence - (int64)position;
+			if (difference == 0) {
+				// The slot is free for this lap, take the position if no other producer took it first
+				if (queue.enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (difference < 0) {
+				// The consumers haven't read the slot of the previous lap yet
+				CE_LOG_ERROR("concurrent_ring_queue_enqueue cannot enqueue the value, concurrent_ring_queue full");
+				return false;
+			}
+			else {
+				position = queue.enqueue_position.load(std::memory_order_relaxed);
+			}
+		}
+
+		copy_memory(slot + 1, value, queue.stride);
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool concurrent_ring_queue_dequeue(concurrent_ring_queue& queue, void* out_value)
+	{
+		if (out_value == nullptr) {
+			CE_LOG_ERROR("concurrent_ring_queue_dequeue requires a valid out_value");
+			return false;
+		}
+
+		concurrent_ring_queue_slot* slot = nullptr;
+		uint64 position = queue.dequeue_position.load(std::memory_order_relaxed);
+		while (true) {
+			slot = get_slot(queue, position);
+			uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+			int64 difference = (int64)sequence - (int64)(position + 1);
+			if (difference == 0) {
+				if (queue.dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (difference < 0) {
+				// Nothing written in this slot for the current lap, the queue is empty
+				return false;
+			}
+			else {
+				position = queue.dequeue_position.load(std::memory_order_relaxed);
+			}
+		}
+
+		copy_memory(out_value, slot + 1, queue.stride);
+		// Free for the producer of the next lap
+		slot->sequence.store(position + queue.capacity, std::memory_order_release);
+		return true;
+	}
+
+	uint concurrent_ring_queue_length(const concurrent_ring_queue& queue)
+	{
+		uint64 dequeue_position = queue.dequeue_position.load(std::memory_order_relaxed);
+		uint64 enqueue_position = queue.enqueue_position.load(std::memory_order_relaxed);
+		return enqueue_position > dequeue_position ? (uint)(enqueue_position - dequeue_position) : 0;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "defines.h"
+
+#include <atomic>
+
+namespace caliope {
+	/**
+	 * @brief Bounded ring queue that many threads can enqueue to and dequeue from at the same time without locks.
+	 * Every slot stores a sequence number next to the value that tells if the slot is ready to be written or read for the current lap.
+	 */
+	typedef struct concurrent_ring_queue {
+		uint stride;
+		uint capacity;
+		uint slot_size;
+		void* block;
+		bool owns_memory;
+
+		// Each position in its own cache line, producers and consumers don't invalidate each other's position
+		alignas(64) std::atomic<uint64> enqueue_position;
+		alignas(64) std::atomic<uint64> dequeue_position;
+	}concurrent_ring_queue;
+
+	/**
+	 * @brief Gets the size of the memory the queue needs to store capacity elements of stride bytes.
+	 */
+	uint64 concurrent_ring_queue_memory_requirement(uint stride, uint capacity);
+
+	/**
+	 * @note capacity must be a power of two. When memory is given it must be at least concurrent_ring_queue_memory_requirement bytes and aligned to 8 bytes.
+	 */
+	bool concurrent_ring_queue_create(uint stride, uint capacity, void* memory, concurrent_ring_queue& out_queue);
+
+	void concurrent_ring_queue_destroy(concurrent_ring_queue& queue);
+
+	/**
+	 * @brief Copies stride bytes from value to the queue, returns false when the queue is full.
+	 */
+	bool concurrent_ring_queue_enqueue(concurrent_ring_queue& queue, const void* value);
+
+	/**
+	 * @brief Copies the oldest element to out_value, returns false when the queue is empty.
+	 * @note There is no peek, another consumer could take the element between a peek and the dequeue.
+	 */
+	bool concurrent_ring_queue_dequeue(concurrent_ring_queue& queue, void* out_value);
+
+	/**
+	 * @brief Gets the number of elements in the queue, it could change right after if other threads are using it.
+	 */
+	uint concurrent_ring_queue_length(const concurrent_ring_queue& queue);
+}
@@ -0,0 +1,443 @@
+#pragma once
+#include "defines.h"
+#include "core/cememory.h"
+
+#include <functional>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define FLAT_HASH_MAP_SSE2
+#endif
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace caliope {
+
+	// The slots are probed in groups of 16 control bytes, one SSE2 compare checks a whole group
+	#define FLAT_HASH_MAP_GROUP_WIDTH 16
+	// Number of values of each page, the pages are never moved so the values keep their address when the table grows
+	#define FLAT_HASH_MAP_PAGE_SIZE 64
+	#define FLAT_HASH_MAP_MIN_CAPACITY 16
+
+	// Control byte of the slots that have never been used, a full slot stores the 7 low bits of the hash of its key
+	#define FLAT_HASH_MAP_EMPTY ((signed char)-128)
+	// Control byte of the slots whose key was removed, the lookups keep probing past them
+	#define FLAT_HASH_MAP_DELETED ((signed char)-2)
+
+	/**
+	 * @brief Index of a value in the pages of a flat_hash_map. It stays valid until the key is removed, also when the table grows.
+	 */
+	typedef uint flat_hash_map_handle;
+
+	template<typename K>
+	struct flat_hash_map_slot {
+		K key;
+		flat_hash_map_handle handle;
+	};
+
+	/**
+	 * @brief Open addressing hash map. The keys are stored in a flat table probed in groups of 16 control bytes (SwissTable layout) and the values in pages that never move,
+	 * so the pointers given by the map stay valid until their key is removed. All the memory comes from the engine allocator.
+	 * @note Not thread safe. It must be created with flat_hash_map_create and destroyed with flat_hash_map_destroy, copying the struct doesn't copy the entries.
+	 */
+	template<typename K, typename V, typename H = std::hash<K>>
+	struct flat_hash_map {
+		// The functions take the key as key_type so the keys can be converted, i.e. an enum to a uint key
+		typedef K key_type;
+
+		signed char* control;
+		// The key and the handle of the value share the cache line, a lookup touches the control bytes, the slot and the value
+		flat_hash_map_slot<K>* slots;
+		uint capacity;
+		uint count;
+		// Empty slots that can be filled before the table grows, keeps the load factor under 7/8
+		uint growth_left;
+
+		V** pages;
+		uint page_count;
+		// Handles of the removed values, they are reused before taking new ones
+		flat_hash_map_handle* free_handles;
+		uint free_handle_count;
+		uint used_handle_count;
+	};
+
+	template<typename K, typename V, typename H>
+	struct flat_hash_map_iterator {
+		const flat_hash_map<K, V, H>* map;
+		uint slot;
+
+		std::pair<const K&, V&> operator*() const {
+			return { map->slots[slot].key, map->pages[map->slots[slot].handle / FLAT_HASH_MAP_PAGE_SIZE][map->slots[slot].handle % FLAT_HASH_MAP_PAGE_SIZE] };
+		}
+
+		flat_hash_map_iterator& operator++() {
+			do {
+				++slot;
+			} while (slot < map->capacity && map->control[slot] < 0);
+			return *this;
+		}
+
+		bool operator!=(const flat_hash_map_iterator& other) const { return slot != other.slot; }
+	};
+
+	// Internal helpers
+	namespace flat_hash_map_internal {
+		inline uint64 mix_hash(uint64 hash) {
+			// std::hash of integers is the identity in some STLs, spread the bits before splitting the hash in group and control byte
+			hash *= 0x9E3779B97F4A7C15ULL;
+			return hash ^ (hash >> 32);
+		}
+
+		inline uint first_bit(uint mask) {
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return (uint)index;
+#else
+			return (uint)__builtin_ctz(mask);
+#endif
+		}
+
+		// Bit i of the result is set when the control byte i of the group equals value
+		inline uint match_group(const signed char* group, signed char value) {
+#ifdef FLAT_HASH_MAP_SSE2
+			__m128i control = _mm_load_si128((const __m128i*)group);
+			return (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value)));
+#else
+			uint mask = 0;
+			for (uint i = 0; i < FLAT_HASH_MAP_GROUP_WIDTH; ++i) {
+				mask |= (uint)(group[i] == value) << i;
+			}
+			return mask;
+#endif
+		}
+
+		// Bit i of the result is set when the slot i of the group is empty or deleted
+		inline uint match_group_not_full(const signed char* group) {
+#ifdef FLAT_HASH_MAP_SSE2
+			__m128i control = _mm_load_si128((const __m128i*)group);
+			return (uint)_mm_movemask_epi8(control);
+#else
+			uint mask = 0;
+			for (uint i = 0; i < FLAT_HASH_MAP_GROUP_WIDTH; ++i) {
+				mask |= (uint)(group[i] < 0) << i;
+			}
+			return mask;
+#endif
+		}
+
+		template<typename K, typename V, typename H>
+		V* get_value(const flat_hash_map<K, V, H>& map, flat_hash_map_handle handle) {
+			return &map.pages[handle / FLAT_HASH_MAP_PAGE_SIZE][handle % FLAT_HASH_MAP_PAGE_SIZE];
+		}
+
+		// Gets the slot of the key, or INVALID_ID when the key is not in the map
+		template<typename K, typename V, typename H>
+		uint find_slot(const flat_hash_map<K, V, H>& map, const K& key, uint64 hash) {
+			if (!map.capacity) {
+				return INVALID_ID;
+			}
+
+			signed char control_byte = (signed char)(hash & 0x7F);
+			uint group_mask = map.capacity / FLAT_HASH_MAP_GROUP_WIDTH - 1;
+			uint group = (uint)(hash >> 7) & group_mask;
+			// Triangular probing visits every group once when the number of groups is a power of two
+			for (uint step = 1; step <= group_mask + 1; ++step) {
+				const signed char* group_control = map.control + group * FLAT_HASH_MAP_GROUP_WIDTH;
+				uint matches = match_group(group_control, control_byte);
+				while (matches) {
+					uint slot = group * FLAT_HASH_MAP_GROUP_WIDTH + first_bit(matches);
+					if (map.slots[slot].key == key) {
+						return slot;
+					}
+					matches &= matches - 1;
+				}
+
+				// The key would have been stored in the first empty slot of its probe sequence
+				if (match_group(group_control, FLAT_HASH_MAP_EMPTY)) {
+					return INVALID_ID;
+				}
+				group = (group + step) & group_mask;
+			}
+
+			return INVALID_ID;
+		}
+
+		// Gets the first empty or deleted slot of the probe sequence of the hash, the table must have room
+		template<typename K, typename V, typename H>
+		uint find_free_slot(const flat_hash_map<K, V, H>& map, uint64 hash) {
+			uint group_mask = map.capacity / FLAT_HASH_MAP_GROUP_WIDTH - 1;
+			uint group = (uint)(hash >> 7) & group_mask;
+			for (uint step = 1; ; ++step) {
+				uint free_slots = match_group_not_full(map.control + group * FLAT_HASH_MAP_GROUP_WIDTH);
+				if (free_slots) {
+					return group * FLAT_HASH_MAP_GROUP_WIDTH + first_bit(free_slots);
+				}
+				group = (group + step) & group_mask;
+			}
+		}
+
+		template<typename K, typename V, typename H>
+		void allocate_table(flat_hash_map<K, V, H>& map, uint capacity) {
+			map.capacity = capacity;
+			map.control = (signed char*)allocate_memory_aligned(MEMORY_TAG_HASH_MAP, capacity, FLAT_HASH_MAP_GROUP_WIDTH);
+			set_memory(map.control, FLAT_HASH_MAP_EMPTY, capacity);
+			map.slots = (flat_hash_map_slot<K>*)allocate_memory_aligned(MEMORY_TAG_HASH_MAP, sizeof(flat_hash_map_slot<K>) * capacity, alignof(flat_hash_map_slot<K>));
+			map.growth_left = capacity - capacity / 8;
+		}
+
+		template<typename K, typename V, typename H>
+		void free_table(flat_hash_map<K, V, H>& map) {
+			if (!map.capacity) {
+				return;
+			}
+
+			free_memory_aligned(MEMORY_TAG_HASH_MAP, map.control, map.capacity, FLAT_HASH_MAP_GROUP_WIDTH);
+			free_memory_aligned(MEMORY_TAG_HASH_MAP, map.slots, sizeof(flat_hash_map_slot<K>) * map.capacity, alignof(flat_hash_map_slot<K>));
+			map.control = nullptr;
+			map.slots = nullptr;
+			map.capacity = 0;
+			map.growth_left = 0;
+		}
+
+		// Moves the keys to a new table, the values don't move
+		template<typename K, typename V, typename H>
+		void rehash(flat_hash_map<K, V, H>& map, uint new_capacity) {
+			flat_hash_map<K, V, H> old_table = map;
+			allocate_table(map, new_capacity);
+
+			for (uint slot = 0; slot < old_table.capacity; ++slot) {
+				if (old_table.control[slot] < 0) {
+					continue;
+				}
+
+				uint64 hash = mix_hash((uint64)H{}(old_table.slots[slot].key));
+				uint new_slot = find_free_slot(map, hash);
+				map.control[new_slot] = (signed char)(hash & 0x7F);
+				new (&map.slots[new_slot].key) K(std::move(old_table.slots[slot].key));
+				map.slots[new_slot].handle = old_table.slots[slot].handle;
+				old_table.slots[slot].key.~K();
+			}
+			map.growth_left -= map.count;
+
+			free_table(old_table);
+		}
+
+		template<typename K, typename V, typename H>
+		flat_hash_map_handle take_handle(flat_hash_map<K, V, H>& map) {
+			if (map.free_handle_count) {
+				return map.free_handles[--map.free_handle_count];
+			}
+
+			if (map.used_handle_count == map.page_count * FLAT_HASH_MAP_PAGE_SIZE) {
+				// Only the array of page pointers grows, the pages stay where they are
+				V** pages = (V**)allocate_memory(MEMORY_TAG_HASH_MAP, sizeof(V*) * (map.page_count + 1));
+				flat_hash_map_handle* free_handles = (flat_hash_map_handle*)allocate_memory_uninitialized(MEMORY_TAG_HASH_MAP, sizeof(flat_hash_map_handle) * (map.page_count + 1) * FLAT_HASH_MAP_PAGE_SIZE);
+				if (map.page_count) {
+					copy_memory(pages, map.pages, sizeof(V*) * map.page_count);
+					free_memory(MEMORY_TAG_HASH_MAP, map.pages, sizeof(V*) * map.page_count);
+					free_memory(MEMORY_TAG_HASH_MAP, map.free_handles, sizeof(flat_hash_map_handle) * map.page_count * FLAT_HASH_MAP_PAGE_SIZE);
+				}
+				pages[map.page_count] = (V*)allocate_memory_aligned(MEMORY_TAG_HASH_MAP, sizeof(V) * FLAT_HASH_MAP_PAGE_SIZE, alignof(V));
+				map.pages = pages;
+				map.free_handles = free_handles;
+				map.page_count++;
+			}
+
+			return map.used_handle_count++;
+		}
+
+		template<typename K, typename V, typename H>
+		void remove_slot(flat_hash_map<K, V, H>& map, uint slot) {
+			flat_hash_map_handle handle = map.slots[slot].handle;
+			get_value(map, handle)->~V();
+			map.slots[slot].key.~K();
+			map.free_handles[map.free_handle_count++] = handle;
+
+			// The lookups stop at the first group with an empty slot, if the group already has one the slot can be empty again
+			const signed char* group_control = map.control + (slot / FLAT_HASH_MAP_GROUP_WIDTH) * FLAT_HASH_MAP_GROUP_WIDTH;
+			if (match_group(group_control, FLAT_HASH_MAP_EMPTY)) {
+				map.control[slot] = FLAT_HASH_MAP_EMPTY;
+				map.growth_left++;
+			}
+			else {
+				map.control[slot] = FLAT_HASH_MAP_DELETED;
+			}
+			map.count--;
+		}
+	}
+
+	/**
+	 * @note capacity is the number of entries that fit before the first rehash, 0 allocates on the first insert.
+	 */
+	template<typename K, typename V, typename H>
+	void flat_hash_map_create(flat_hash_map<K, V, H>& out_map, uint capacity = 0) {
+		out_map.control = nullptr;
+		out_map.slots = nullptr;
+		out_map.capacity = 0;
+		out_map.count = 0;
+		out_map.growth_left = 0;
+		out_map.pages = nullptr;
+		out_map.page_count = 0;
+		out_map.free_handles = nullptr;
+		out_map.free_handle_count = 0;
+		out_map.used_handle_count = 0;
+
+		if (capacity) {
+			uint table_capacity = FLAT_HASH_MAP_MIN_CAPACITY;
+			while (table_capacity - table_capacity / 8 < capacity) {
+				table_capacity *= 2;
+			}
+			flat_hash_map_internal::allocate_table(out_map, table_capacity);
+		}
+	}
+
+	/**
+	 * @brief Destroys every key and value, the memory is kept for the next inserts. The pointers and handles given by the map are no longer valid.
+	 */
+	template<typename K, typename V, typename H>
+	void flat_hash_map_clear(flat_hash_map<K, V, H>& map) {
+		for (uint slot = 0; slot < map.capacity; ++slot) {
+			if (map.control[slot] >= 0) {
+				flat_hash_map_internal::get_value(map, map.slots[slot].handle)->~V();
+				map.slots[slot].key.~K();
+			}
+		}
+		if (map.capacity) {
+			set_memory(map.control, FLAT_HASH_MAP_EMPTY, map.capacity);
+		}
+		map.count = 0;
+		map.growth_left = map.capacity - map.capacity / 8;
+		map.free_handle_count = 0;
+		map.used_handle_count = 0;
+	}
+
+	template<typename K, typename V, typename H>
+	void flat_hash_map_destroy(flat_hash_map<K, V, H>& map) {
+		flat_hash_map_clear(map);
+		flat_hash_map_internal::free_table(map);
+
+		for (uint i = 0; i < map.page_count; ++i) {
+			free_memory_aligned(MEMORY_TAG_HASH_MAP, map.pages[i], sizeof(V) * FLAT_HASH_MAP_PAGE_SIZE, alignof(V));
+		}
+		if (map.page_count) {
+			free_memory(MEMORY_TAG_HASH_MAP, map.pages, sizeof(V*) * map.page_count);
+			free_memory(MEMORY_TAG_HASH_MAP, map.free_handles, sizeof(flat_hash_map_handle) * map.page_count * FLAT_HASH_MAP_PAGE_SIZE);
+		}
+		map.pages = nullptr;
+		map.page_count = 0;
+		map.free_handles = nullptr;
+	}
+
+	/**
+	 * @brief Gets the handle of the value of the key, INVALID_ID if the key is not in the map.
+	 */
+	template<typename K, typename V, typename H>
+	flat_hash_map_handle flat_hash_map_find_handle(const flat_hash_map<K, V, H>& map, const typename flat_hash_map<K, V, H>::key_type& key) {
+		uint slot = flat_hash_map_internal::find_slot(map, key, flat_hash_map_internal::mix_hash((uint64)H{}(key)));
+		return slot == INVALID_ID ? INVALID_ID : map.slots[slot].handle;
+	}
+
+	/**
+	 * @brief Gets the value of a handle given by the map, the handle must belong to a key that is still in the map.
+	 */
+	template<typename K, typename V, typename H>
+	V* flat_hash_map_get(const flat_hash_map<K, V, H>& map, flat_hash_map_handle handle) {
+		return flat_hash_map_internal::get_value(map, handle);
+	}
+
+	/**
+	 * @brief Gets the value of the key, nullptr if the key is not in the map.
+	 */
+	template<typename K, typename V, typename H>
+	V* flat_hash_map_find(const flat_hash_map<K, V, H>& map, const typename flat_hash_map<K, V, H>::key_type& key) {
+		flat_hash_map_handle handle = flat_hash_map_find_handle(map, key);
+		return handle == INVALID_ID ? nullptr : flat_hash_map_internal::get_value(map, handle);
+	}
+
+	template<typename K, typename V, typename H>
+	bool flat_hash_map_contains(const flat_hash_map<K, V, H>& map, const typename flat_hash_map<K, V, H>::key_type& key) {
+		return flat_hash_map_find_handle(map, key) != INVALID_ID;
+	}
+
+	/**
+	 * @brief Inserts the value if the key is not in the map yet, otherwise the stored value is kept. Returns the stored value.
+	 * @note The returned pointer stays valid until the key is removed, growing the table doesn't move the values.
+	 */
+	template<typename K, typename V, typename H, typename T>
+	V* flat_hash_map_insert(flat_hash_map<K, V, H>& map, const typename flat_hash_map<K, V, H>::key_type& key, T&& value, flat_hash_map_handle* out_handle = nullptr) {
+		uint64 hash = flat_hash_map_internal::mix_hash((uint64)H{}(key));
+		uint slot = flat_hash_map_internal::find_slot(map, key, hash);
+		if (slot == INVALID_ID) {
+			if (!map.growth_left) {
+				// Only rehash in place when most of the slots are deleted, otherwise double
+				uint new_capacity = map.capacity && map.count < map.capacity / 2 ? map.capacity : (map.capacity ? map.capacity * 2 : FLAT_HASH_MAP_MIN_CAPACITY);
+				flat_hash_map_internal::rehash(map, new_capacity);
+			}
+
+			slot = flat_hash_map_internal::find_free_slot(map, hash);
+			if (map.control[slot] == FLAT_HASH_MAP_EMPTY) {
+				map.growth_left--;
+			}
+			map.control[slot] = (signed char)(hash & 0x7F);
+			new (&map.slots[slot].key) K(key);
+			map.slots[slot].handle = flat_hash_map_internal::take_handle(map);
+			new (flat_hash_map_internal::get_value(map, map.slots[slot].handle)) V(std::forward<T>(value));
+			map.count++;
+		}
+
+		if (out_handle) {
+			*out_handle = map.slots[slot].handle;
+		}
+		return flat_hash_map_internal::get_value(map, map.slots[slot].handle);
+	}
+
+	/**
+	 * @brief Same as the operator[] of std::unordered_map, inserts a default value when the key is not in the map.
+	 */
+	template<typename K, typename V, typename H>
+	V* flat_hash_map_find_or_insert(flat_hash_map<K, V, H>& map, const typename flat_hash_map<K, V, H>::key_type& key) {
+		V* value = flat_hash_map_find(map, key);
+		return value ? value : flat_hash_map_insert(map, key, V());
+	}
+
+	/**
+	 * @brief Removes the key and destroys its value, returns false if the key is not in the map.
+	 */
+	template<typename K, typename V, typename H>
+	bool flat_hash_map_remove(flat_hash_map<K, V, H>& map, const typename flat_hash_map<K, V, H>::key_type& key) {
+		uint slot = flat_hash_map_internal::find_slot(map, key, flat_hash_map_internal::mix_hash((uint64)H{}(key)));
+		if (slot == INVALID_ID) {
+			return false;
+		}
+
+		flat_hash_map_internal::remove_slot(map, slot);
+		return true;
+	}
+
+	template<typename K, typename V, typename H>
+	uint flat_hash_map_size(const flat_hash_map<K, V, H>& map) {
+		return map.count;
+	}
+
+	/**
+	 * @brief The entries can be iterated with a range for, for (auto [key, value] : map). Removing the key being visited is allowed, adding keys while iterating is not.
+	 */
+	template<typename K, typename V, typename H>
+	flat_hash_map_iterator<K, V, H> begin(const flat_hash_map<K, V, H>& map) {
+		uint slot = 0;
+		while (slot < map.capacity && map.control[slot] < 0) {
+			++slot;
+		}
+		return { &map, slot };
+	}
+
+	template<typename K, typename V, typename H>
+	flat_hash_map_iterator<K, V, H> end(const flat_hash_map<K, V, H>& map) {
+		return { &map, map.capacity };
+	}
+}
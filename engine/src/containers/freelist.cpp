@@ -3,6 +3,10 @@
 #include "core/cememory.h"
 #include "core/logger.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace caliope {
 	typedef struct freelist_node {
 		uint64 offset;
@@ -20,7 +24,20 @@ namespace caliope {
 	freelist_node* get_node(freelist& list);
 	void return_node(freelist_node* node);
 
-	void freelist_create(uint64 total_size, uint64& memory_requirement, void* memory, freelist& out_list) {
+	void binned_freelist_create(uint64 total_size, uint64& memory_requirement, void* memory, freelist& out_list);
+	void binned_freelist_destroy(freelist& list);
+	bool binned_freelist_allocate_block(freelist& list, uint64 size, uint64& out_offset);
+	bool binned_freelist_free_block(freelist& list, uint64 size, uint64 offset);
+	bool binned_freelist_resize(freelist& list, uint64& memory_requirement, void* new_memory, uint64 new_size, void*& out_old_memory);
+	void binned_freelist_clear(freelist& list);
+	void binned_freelist_get_metrics(freelist& list, freelist_metrics& out_metrics);
+
+	void freelist_create(uint64 total_size, freelist_type type, uint64& memory_requirement, void* memory, freelist& out_list) {
+		if (type == FREELIST_TYPE_BINNED) {
+			binned_freelist_create(total_size, memory_requirement, memory, out_list);
+			return;
+		}
+
 		uint64 max_entries = (total_size / (sizeof(void*) * sizeof(freelist_node)));
 		memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
 		if (!memory) {
@@ -32,6 +49,7 @@ namespace caliope {
 			CE_LOG_WARNING("Freelist are very inefficient with amounts of memory less than %iB; it is recommended to not use this structure in this case.", mem_min);
 		}
 
+		out_list.type = FREELIST_TYPE_LINKED_LIST;
 		out_list.memory = memory;
 
 		// The block's layout in head* first, the array of available nodes.
@@ -56,6 +74,11 @@ namespace caliope {
 	}
 
 	void freelist_destroy(freelist& list) {
+		if (list.type == FREELIST_TYPE_BINNED) {
+			binned_freelist_destroy(list);
+			return;
+		}
+
 		if (list.memory) {
 			// Zero out the memory before giving it back.
 			internal_state* state = static_cast<internal_state*>(list.memory);
@@ -69,6 +92,10 @@ namespace caliope {
 			return false;
 		}
 
+		if (list.type == FREELIST_TYPE_BINNED) {
+			return binned_freelist_allocate_block(list, size, out_offset);
+		}
+
 		internal_state* state = static_cast<internal_state*>(list.memory);
 		freelist_node* node = state->head;
 		freelist_node* previous = 0;
@@ -110,6 +137,10 @@ namespace caliope {
 			return false;
 		}
 
+		if (list.type == FREELIST_TYPE_BINNED) {
+			return binned_freelist_free_block(list, size, offset);
+		}
+
 		internal_state* state = static_cast<internal_state*>(list.memory);
 		freelist_node* node = state->head;
 		freelist_node* previous = 0;
@@ -181,6 +212,10 @@ namespace caliope {
 	}
 
 	bool freelist_resize(freelist& list, uint64& memory_requirement, void* new_memory, uint64 new_size, void*& out_old_memory) {
+		if (list.type == FREELIST_TYPE_BINNED) {
+			return binned_freelist_resize(list, memory_requirement, new_memory, new_size, out_old_memory);
+		}
+
 		if (!memory_requirement || ((internal_state*)list.memory)->total_size > new_size) {
 			return false;
 		}
@@ -260,6 +295,11 @@ namespace caliope {
 			return;
 		}
 
+		if (list.type == FREELIST_TYPE_BINNED) {
+			binned_freelist_clear(list);
+			return;
+		}
+
 		internal_state* state = static_cast<internal_state*>(list.memory);
 		for (uint64 i = 1; i < state->max_entries; ++i) {
 			state->nodes[i].offset = INVALID_ID;
@@ -276,6 +316,12 @@ namespace caliope {
 			return 0;
 		}
 
+		if (list.type == FREELIST_TYPE_BINNED) {
+			freelist_metrics metrics;
+			binned_freelist_get_metrics(list, metrics);
+			return metrics.free_space;
+		}
+
 		uint64 running_total = 0;
 		internal_state* state = static_cast<internal_state*>(list.memory);
 		freelist_node* node = state->head;
@@ -287,6 +333,27 @@ namespace caliope {
 		return running_total;
 	}
 
+	void freelist_get_metrics(freelist& list, freelist_metrics& out_metrics) {
+		zero_memory(&out_metrics, sizeof(freelist_metrics));
+		if (!list.memory) {
+			return;
+		}
+
+		if (list.type == FREELIST_TYPE_BINNED) {
+			binned_freelist_get_metrics(list, out_metrics);
+			return;
+		}
+
+		internal_state* state = static_cast<internal_state*>(list.memory);
+		freelist_node* node = state->head;
+		while (node) {
+			out_metrics.free_space += node->size;
+			out_metrics.largest_free_block = node->size > out_metrics.largest_free_block ? node->size : out_metrics.largest_free_block;
+			out_metrics.hole_count++;
+			node = node->next;
+		}
+	}
+
 	freelist_node* get_node(freelist& list) {
 		internal_state* state = static_cast<internal_state*>(list.memory);
 		for (uint64 i = 1; i < state->max_entries; ++i) {
@@ -303,4 +370,476 @@ namespace caliope {
 		node->size = INVALID_ID;
 		node->next = 0;
 	}
+
+	// ------------------------------------------------------------------------------------------------------------
+	// Binned freelist
+	// The free blocks are kept in two structures that share the same nodes:
+	// - Size bins with two levels, the first level is the power of two of the size and the second level splits it
+	//   linearly in FREELIST_SL_COUNT bins. Two bitmaps tell which bins are not empty, so the search is a bit scan.
+	// - A treap ordered by offset, used to find the neighbours of a freed block to coalesce them.
+	// The nodes are referenced by index so the whole state can be copied on resize.
+	// ------------------------------------------------------------------------------------------------------------
+
+	#define FREELIST_SL_BITS 4
+	#define FREELIST_SL_COUNT (1 << FREELIST_SL_BITS)
+	#define FREELIST_FL_COUNT 64
+
+	typedef struct binned_freelist_node {
+		uint64 offset;
+		uint64 size;
+		uint left;
+		uint right;
+		uint priority;
+		uint bin_previous;
+		uint bin_next; // Also used to link the unused nodes
+	} binned_freelist_node;
+
+	typedef struct binned_internal_state {
+		uint64 total_size;
+		uint64 free_space;
+		uint64 hole_count;
+		uint max_entries;
+		// The nodes after this one were never used, they are taken in order so the node array is only touched as it is needed
+		uint next_unused_node;
+		uint free_nodes_head;
+		uint tree_root;
+		uint random_state;
+
+		uint64 first_level_bitmap;
+		uint second_level_bitmaps[FREELIST_FL_COUNT];
+		uint bins[FREELIST_FL_COUNT][FREELIST_SL_COUNT];
+
+		binned_freelist_node* nodes;
+	} binned_internal_state;
+
+	uint binned_bit_scan_forward(uint64 value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+#else
+		return __builtin_ctzll(value);
+#endif
+	}
+
+	uint binned_bit_scan_reverse(uint64 value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	uint64 binned_max_entries(uint64 total_size) {
+		uint64 max_entries = (total_size / (sizeof(void*) * sizeof(binned_freelist_node)));
+		max_entries = max_entries < 8 ? 8 : max_entries;
+		return max_entries < INVALID_ID ? max_entries : INVALID_ID - 1;
+	}
+
+	// Gets the bin where a block of this size is stored
+	void binned_mapping_insert(uint64 size, uint& out_first_level, uint& out_second_level) {
+		if (size < FREELIST_SL_COUNT) {
+			out_first_level = 0;
+			out_second_level = (uint)size;
+			return;
+		}
+
+		uint most_significant_bit = binned_bit_scan_reverse(size);
+		out_first_level = most_significant_bit - FREELIST_SL_BITS + 1;
+		out_second_level = (uint)(size >> (most_significant_bit - FREELIST_SL_BITS)) - FREELIST_SL_COUNT;
+	}
+
+	// Gets the first bin where every block is big enough for this size
+	void binned_mapping_search(uint64 size, uint& out_first_level, uint& out_second_level) {
+		if (size >= FREELIST_SL_COUNT) {
+			size += (1ull << (binned_bit_scan_reverse(size) - FREELIST_SL_BITS)) - 1;
+		}
+		binned_mapping_insert(size, out_first_level, out_second_level);
+	}
+
+	uint binned_get_node(binned_internal_state* state) {
+		uint index = state->free_nodes_head;
+		if (index != INVALID_ID) {
+			state->free_nodes_head = state->nodes[index].bin_next;
+		}
+		else if (state->next_unused_node < state->max_entries) {
+			index = state->next_unused_node++;
+		}
+
+		if (index != INVALID_ID) {
+
+			// xorshift, the priority only has to be random enough to keep the treap balanced
+			state->random_state ^= state->random_state << 13;
+			state->random_state ^= state->random_state >> 17;
+			state->random_state ^= state->random_state << 5;
+
+			binned_freelist_node& node = state->nodes[index];
+			node.left = INVALID_ID;
+			node.right = INVALID_ID;
+			node.priority = state->random_state;
+			node.bin_previous = INVALID_ID;
+			node.bin_next = INVALID_ID;
+		}
+
+		return index;
+	}
+
+	void binned_return_node(binned_internal_state* state, uint index) {
+		state->nodes[index].offset = INVALID_ID;
+		state->nodes[index].size = INVALID_ID;
+		state->nodes[index].bin_next = state->free_nodes_head;
+		state->free_nodes_head = index;
+	}
+
+	void binned_bin_insert(binned_internal_state* state, uint index) {
+		uint first_level, second_level;
+		binned_mapping_insert(state->nodes[index].size, first_level, second_level);
+
+		uint head = state->bins[first_level][second_level];
+		state->nodes[index].bin_previous = INVALID_ID;
+		state->nodes[index].bin_next = head;
+		if (head != INVALID_ID) {
+			state->nodes[head].bin_previous = index;
+		}
+		state->bins[first_level][second_level] = index;
+
+		state->first_level_bitmap |= (1ull << first_level);
+		state->second_level_bitmaps[first_level] |= (1u << second_level);
+	}
+
+	// NOTE: Must be called before changing the size of the node, the size tells in which bin it is
+	void binned_bin_remove(binned_internal_state* state, uint index) {
+		uint first_level, second_level;
+		binned_mapping_insert(state->nodes[index].size, first_level, second_level);
+
+		binned_freelist_node& node = state->nodes[index];
+		if (node.bin_previous != INVALID_ID) {
+			state->nodes[node.bin_previous].bin_next = node.bin_next;
+		}
+		else {
+			state->bins[first_level][second_level] = node.bin_next;
+		}
+
+		if (node.bin_next != INVALID_ID) {
+			state->nodes[node.bin_next].bin_previous = node.bin_previous;
+		}
+
+		if (state->bins[first_level][second_level] == INVALID_ID) {
+			state->second_level_bitmaps[first_level] &= ~(1u << second_level);
+			if (state->second_level_bitmaps[first_level] == 0) {
+				state->first_level_bitmap &= ~(1ull << first_level);
+			}
+		}
+
+		node.bin_previous = INVALID_ID;
+		node.bin_next = INVALID_ID;
+	}
+
+	// Splits the tree in the nodes with an offset lower than the given one and the rest
+	void binned_tree_split(binned_internal_state* state, uint root, uint64 offset, uint& out_left, uint& out_right) {
+		if (root == INVALID_ID) {
+			out_left = INVALID_ID;
+			out_right = INVALID_ID;
+			return;
+		}
+
+		binned_freelist_node& node = state->nodes[root];
+		if (node.offset < offset) {
+			binned_tree_split(state, node.right, offset, node.right, out_right);
+			out_left = root;
+		}
+		else {
+			binned_tree_split(state, node.left, offset, out_left, node.left);
+			out_right = root;
+		}
+	}
+
+	// Every offset in left must be lower than the ones in right
+	uint binned_tree_merge(binned_internal_state* state, uint left, uint right) {
+		if (left == INVALID_ID) {
+			return right;
+		}
+		if (right == INVALID_ID) {
+			return left;
+		}
+
+		if (state->nodes[left].priority > state->nodes[right].priority) {
+			state->nodes[left].right = binned_tree_merge(state, state->nodes[left].right, right);
+			return left;
+		}
+
+		state->nodes[right].left = binned_tree_merge(state, left, state->nodes[right].left);
+		return right;
+	}
+
+	void binned_tree_insert(binned_internal_state* state, uint index) {
+		uint left, right;
+		binned_tree_split(state, state->tree_root, state->nodes[index].offset, left, right);
+		state->tree_root = binned_tree_merge(state, binned_tree_merge(state, left, index), right);
+	}
+
+	void binned_tree_remove(binned_internal_state* state, uint index) {
+		uint left, middle, right;
+		binned_tree_split(state, state->tree_root, state->nodes[index].offset, left, right);
+		binned_tree_split(state, right, state->nodes[index].offset + 1, middle, right);
+		state->tree_root = binned_tree_merge(state, left, right);
+		state->nodes[index].left = INVALID_ID;
+		state->nodes[index].right = INVALID_ID;
+	}
+
+	// Gets the free block with the highest offset lower than the given one
+	uint binned_tree_find_previous(binned_internal_state* state, uint64 offset) {
+		uint found = INVALID_ID;
+		uint current = state->tree_root;
+		while (current != INVALID_ID) {
+			if (state->nodes[current].offset < offset) {
+				found = current;
+				current = state->nodes[current].right;
+			}
+			else {
+				current = state->nodes[current].left;
+			}
+		}
+
+		return found;
+	}
+
+	// Gets the free block with the lowest offset equal or higher than the given one
+	uint binned_tree_find_next(binned_internal_state* state, uint64 offset) {
+		uint found = INVALID_ID;
+		uint current = state->tree_root;
+		while (current != INVALID_ID) {
+			if (state->nodes[current].offset >= offset) {
+				found = current;
+				current = state->nodes[current].left;
+			}
+			else {
+				current = state->nodes[current].right;
+			}
+		}
+
+		return found;
+	}
+
+	// Leaves every node unused and a single free block with the whole size
+	void binned_reset(binned_internal_state* state) {
+		state->free_space = state->total_size;
+		state->hole_count = 1;
+		state->tree_root = INVALID_ID;
+		state->first_level_bitmap = 0;
+		zero_memory(state->second_level_bitmaps, sizeof(state->second_level_bitmaps));
+		set_memory(state->bins, 0xFF, sizeof(state->bins)); // All to INVALID_ID
+
+		state->free_nodes_head = INVALID_ID;
+		state->next_unused_node = 0;
+
+		uint first = binned_get_node(state);
+		state->nodes[first].offset = 0;
+		state->nodes[first].size = state->total_size;
+		binned_tree_insert(state, first);
+		binned_bin_insert(state, first);
+	}
+
+	void binned_freelist_create(uint64 total_size, uint64& memory_requirement, void* memory, freelist& out_list) {
+		uint64 max_entries = binned_max_entries(total_size);
+		memory_requirement = sizeof(binned_internal_state) + (sizeof(binned_freelist_node) * max_entries);
+		if (!memory) {
+			return;
+		}
+
+		out_list.type = FREELIST_TYPE_BINNED;
+		out_list.memory = memory;
+
+		zero_memory(out_list.memory, sizeof(binned_internal_state));
+		binned_internal_state* state = static_cast<binned_internal_state*>(out_list.memory);
+		state->nodes = (binned_freelist_node*)(((char*)out_list.memory) + sizeof(binned_internal_state));
+		state->max_entries = (uint)max_entries;
+		state->total_size = total_size;
+		state->random_state = 2463534242u;
+
+		binned_reset(state);
+	}
+
+	void binned_freelist_destroy(freelist& list) {
+		if (list.memory) {
+			binned_internal_state* state = static_cast<binned_internal_state*>(list.memory);
+			zero_memory(list.memory, sizeof(binned_internal_state) + sizeof(binned_freelist_node) * state->next_unused_node);
+			list.memory = 0;
+		}
+	}
+
+	bool binned_freelist_allocate_block(freelist& list, uint64 size, uint64& out_offset) {
+		binned_internal_state* state = static_cast<binned_internal_state*>(list.memory);
+		if (!size) {
+			return false;
+		}
+
+		// Looks for the first non empty bin where any block fits
+		uint index = INVALID_ID;
+		uint first_level, second_level;
+		binned_mapping_search(size, first_level, second_level);
+		if (first_level < FREELIST_FL_COUNT) {
+			uint second_level_map = state->second_level_bitmaps[first_level] & (~0u << second_level);
+			if (!second_level_map) {
+				uint64 first_level_map = first_level + 1 < FREELIST_FL_COUNT ? state->first_level_bitmap & (~0ull << (first_level + 1)) : 0;
+				if (first_level_map) {
+					first_level = binned_bit_scan_forward(first_level_map);
+					second_level_map = state->second_level_bitmaps[first_level];
+				}
+			}
+
+			if (second_level_map) {
+				second_level = binned_bit_scan_forward(second_level_map);
+				index = state->bins[first_level][second_level];
+			}
+		}
+
+		// The search rounds up the size, so the blocks of the exact bin may still fit
+		if (index == INVALID_ID) {
+			binned_mapping_insert(size, first_level, second_level);
+			uint candidate = state->bins[first_level][second_level];
+			while (candidate != INVALID_ID && state->nodes[candidate].size < size) {
+				candidate = state->nodes[candidate].bin_next;
+			}
+			index = candidate;
+		}
+
+		if (index == INVALID_ID) {
+			CE_LOG_WARNING("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB)", size, state->free_space);
+			return false;
+		}
+
+		binned_bin_remove(state, index);
+		binned_freelist_node& node = state->nodes[index];
+		out_offset = node.offset;
+		if (node.size == size) {
+			binned_tree_remove(state, index);
+			binned_return_node(state, index);
+			state->hole_count--;
+		}
+		else {
+			// The remaining block keeps its position between the same neighbours, so the tree is still ordered
+			node.offset += size;
+			node.size -= size;
+			binned_bin_insert(state, index);
+		}
+
+		state->free_space -= size;
+		return true;
+	}
+
+	bool binned_freelist_free_block(freelist& list, uint64 size, uint64 offset) {
+		binned_internal_state* state = static_cast<binned_internal_state*>(list.memory);
+		if (offset + size > state->total_size) {
+			CE_LOG_WARNING("Unable to free block outside of the freelist range. Corruption possible?");
+			return false;
+		}
+
+		uint previous = binned_tree_find_previous(state, offset);
+		uint next = binned_tree_find_next(state, offset);
+
+		if ((previous != INVALID_ID && state->nodes[previous].offset + state->nodes[previous].size > offset) ||
+			(next != INVALID_ID && offset + size > state->nodes[next].offset)) {
+			CE_LOG_WARNING("Unable to free block that overlaps a free block. Corruption possible?");
+			return false;
+		}
+
+		bool merge_previous = previous != INVALID_ID && state->nodes[previous].offset + state->nodes[previous].size == offset;
+		bool merge_next = next != INVALID_ID && offset + size == state->nodes[next].offset;
+
+		if (merge_previous && merge_next) {
+			binned_bin_remove(state, previous);
+			binned_bin_remove(state, next);
+			state->nodes[previous].size += size + state->nodes[next].size;
+			binned_tree_remove(state, next);
+			binned_return_node(state, next);
+			binned_bin_insert(state, previous);
+			state->hole_count--;
+		}
+		else if (merge_previous) {
+			binned_bin_remove(state, previous);
+			state->nodes[previous].size += size;
+			binned_bin_insert(state, previous);
+		}
+		else if (merge_next) {
+			binned_bin_remove(state, next);
+			state->nodes[next].offset = offset;
+			state->nodes[next].size += size;
+			binned_bin_insert(state, next);
+		}
+		else {
+			uint index = binned_get_node(state);
+			if (index == INVALID_ID) {
+				CE_LOG_ERROR("freelist_free_block run out of nodes to track %llu holes.", state->hole_count);
+				return false;
+			}
+
+			state->nodes[index].offset = offset;
+			state->nodes[index].size = size;
+			binned_tree_insert(state, index);
+			binned_bin_insert(state, index);
+			state->hole_count++;
+		}
+
+		state->free_space += size;
+		return true;
+	}
+
+	bool binned_freelist_resize(freelist& list, uint64& memory_requirement, void* new_memory, uint64 new_size, void*& out_old_memory) {
+		binned_internal_state* old_state = static_cast<binned_internal_state*>(list.memory);
+		if (old_state->total_size > new_size) {
+			return false;
+		}
+
+		uint64 max_entries = binned_max_entries(new_size);
+		memory_requirement = sizeof(binned_internal_state) + (sizeof(binned_freelist_node) * max_entries);
+		if (!new_memory) {
+			return true;
+		}
+
+		out_old_memory = list.memory;
+		list.memory = new_memory;
+
+		// The nodes are referenced by index, so the state and the nodes can be copied as they are
+		binned_internal_state* state = static_cast<binned_internal_state*>(list.memory);
+		copy_memory(state, old_state, sizeof(binned_internal_state));
+		state->nodes = (binned_freelist_node*)(((char*)list.memory) + sizeof(binned_internal_state));
+		copy_memory(state->nodes, old_state->nodes, sizeof(binned_freelist_node) * old_state->next_unused_node);
+		state->max_entries = (uint)max_entries;
+
+		uint64 old_size = state->total_size;
+		state->total_size = new_size;
+		if (new_size > old_size) {
+			// Adds the new space as a freed block, so it coalesces with the last one if possible
+			binned_freelist_free_block(list, new_size - old_size, old_size);
+		}
+
+		return true;
+	}
+
+	void binned_freelist_clear(freelist& list) {
+		binned_reset(static_cast<binned_internal_state*>(list.memory));
+	}
+
+	void binned_freelist_get_metrics(freelist& list, freelist_metrics& out_metrics) {
+		binned_internal_state* state = static_cast<binned_internal_state*>(list.memory);
+		out_metrics.free_space = state->free_space;
+		out_metrics.hole_count = state->hole_count;
+		out_metrics.largest_free_block = 0;
+
+		if (state->first_level_bitmap) {
+			// Only the blocks of the highest non empty bin can be the largest one
+			uint first_level = binned_bit_scan_reverse(state->first_level_bitmap);
+			uint second_level = binned_bit_scan_reverse(state->second_level_bitmaps[first_level]);
+			uint index = state->bins[first_level][second_level];
+			while (index != INVALID_ID) {
+				if (state->nodes[index].size > out_metrics.largest_free_block) {
+					out_metrics.largest_free_block = state->nodes[index].size;
+				}
+				index = state->nodes[index].bin_next;
+			}
+		}
+	}
 }
\ No newline at end of file
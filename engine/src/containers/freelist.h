@@ -4,19 +4,38 @@
 
 namespace caliope {
 
+	typedef enum freelist_type {
+		// Offset sorted linked list. Allocate and free are linear in the number of holes.
+		FREELIST_TYPE_LINKED_LIST = 0,
+		// Free blocks binned by size plus a tree ordered by offset to coalesce. Allocate is constant time and free is logarithmic in the number of holes.
+		FREELIST_TYPE_BINNED
+	} freelist_type;
+
 	typedef struct freelist {
+		freelist_type type;
 		void* memory;
 	} freelist;
 
-	void freelist_create(uint64 total_size, uint64& memory_requirement, void* memory, freelist& out_list);
-	void freelist_destroy(freelist& list);
+	typedef struct freelist_metrics {
+		uint64 free_space;
+		uint64 largest_free_block;
+		uint64 hole_count;
+	} freelist_metrics;
+
+	CE_API void freelist_create(uint64 total_size, freelist_type type, uint64& memory_requirement, void* memory, freelist& out_list);
+	CE_API void freelist_destroy(freelist& list);
+
+	CE_API bool freelist_allocate_block(freelist& list, uint64 size, uint64& out_offset);
+	CE_API bool freelist_free_block(freelist& list, uint64 size, uint64 offset);
 
-	bool freelist_allocate_block(freelist& list, uint64 size, uint64& out_offset);
-	bool freelist_free_block(freelist& list, uint64 size, uint64 offset);
+	CE_API bool freelist_resize(freelist& list, uint64& memory_requirement, void* new_memory, uint64 new_size, void*& out_old_memory);
 
-	bool freelist_resize(freelist& list, uint64& memory_requirement, void* new_memory, uint64 new_size, void*& out_old_memory);
+	CE_API void freelist_clear(freelist& list);
 
-	void freelist_clear(freelist& list);
+	CE_API uint64 freelist_free_space(freelist& list);
 
-	uint64 freelist_free_space(freelist& list);
-}
\ No newline at end of file
+	/*
+	 * @brief Gets the fragmentation of the list, the largest free block compared with the free space tells how fragmented it is.
+	 */
+	CE_API void freelist_get_metrics(freelist& list, freelist_metrics& out_metrics);
+}
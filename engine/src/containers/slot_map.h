@@ -0,0 +1,277 @@
+#pragma once
+#include "defines.h"
+#include "core/cememory.h"
+
+#include <new>
+#include <utility>
+
+namespace caliope {
+
+	// The low bits of a handle are the slot and the high bits the generation of the slot when the handle was given
+	#define SLOT_MAP_INDEX_BITS 24
+	#define SLOT_MAP_INDEX_MASK ((1u << SLOT_MAP_INDEX_BITS) - 1)
+	#define SLOT_MAP_GENERATION_MASK ((1u << (32 - SLOT_MAP_INDEX_BITS)) - 1)
+	// The last slot is never used so INVALID_ID is never a valid handle
+	#define SLOT_MAP_MAX_SLOTS SLOT_MAP_INDEX_MASK
+	#define SLOT_MAP_MIN_CAPACITY 16
+
+	/**
+	 * @brief Handle of a value of a slot_map. It stays valid until the value is removed, then the map detects it as stale.
+	 */
+	typedef uint slot_map_handle;
+
+	typedef struct slot_map_slot {
+		// Position of the value in the dense array while the slot is used, next slot of the free list while it is free
+		uint index;
+		uint generation;
+	} slot_map_slot;
+
+	/**
+	 * @brief Stores the values packed in a dense array and gives generational handles to them. Insert, remove and lookup are O(1),
+	 * removing moves the last value to the hole so the values can always be iterated as a contiguous array.
+	 * @note The generation has 8 bits, the free slots are reused in FIFO order so a stale handle only aliases a new value after its slot has been reused 256 times.
+	 * The values move when other values are removed or the map grows, keep the handle instead of the pointer.
+	 * Not thread safe. It must be created with slot_map_create and destroyed with slot_map_destroy.
+	 */
+	template<typename T>
+	struct slot_map {
+		T* values;
+		// Handle of each dense value, used to fix the slot of the value moved by a remove
+		slot_map_handle* handles;
+		uint count;
+		// Capacity of the dense array and of the slots
+		uint capacity;
+
+		slot_map_slot* slots;
+		// Slots that have been used at least once, the rest of the capacity has never been given
+		uint slot_count;
+		uint free_head;
+		uint free_tail;
+	};
+
+	// Internal helpers
+	namespace slot_map_internal {
+		inline uint handle_index(slot_map_handle handle) {
+			return handle & SLOT_MAP_INDEX_MASK;
+		}
+
+		inline uint handle_generation(slot_map_handle handle) {
+			return handle >> SLOT_MAP_INDEX_BITS;
+		}
+
+		inline slot_map_handle make_handle(uint index, uint generation) {
+			return (generation << SLOT_MAP_INDEX_BITS) | index;
+		}
+
+		// Gets the slot of the handle, nullptr if the handle is stale or has never been given
+		template<typename T>
+		slot_map_slot* find_slot(const slot_map<T>& map, slot_map_handle handle) {
+			uint index = handle_index(handle);
+			if (index >= map.slot_count) {
+				return nullptr;
+			}
+
+			slot_map_slot* slot = &map.slots[index];
+			if (slot->generation != handle_generation(handle) || slot->index >= map.count || map.handles[slot->index] != handle) {
+				return nullptr;
+			}
+			return slot;
+		}
+
+		template<typename T>
+		void grow(slot_map<T>& map, uint new_capacity) {
+			T* values = (T*)allocate_memory_aligned(MEMORY_TAG_SLOT_MAP, sizeof(T) * new_capacity, alignof(T));
+			slot_map_handle* handles = (slot_map_handle*)allocate_memory_uninitialized(MEMORY_TAG_SLOT_MAP, sizeof(slot_map_handle) * new_capacity);
+			slot_map_slot* slots = (slot_map_slot*)allocate_memory_uninitialized(MEMORY_TAG_SLOT_MAP, sizeof(slot_map_slot) * new_capacity);
+
+			for (uint i = 0; i < map.count; ++i) {
+				new (&values[i]) T(std::move(map.values[i]));
+				map.values[i].~T();
+			}
+
+			if (map.capacity) {
+				copy_memory(handles, map.handles, sizeof(slot_map_handle) * map.count);
+				copy_memory(slots, map.slots, sizeof(slot_map_slot) * map.slot_count);
+				free_memory_aligned(MEMORY_TAG_SLOT_MAP, map.values, sizeof(T) * map.capacity, alignof(T));
+				free_memory(MEMORY_TAG_SLOT_MAP, map.handles, sizeof(slot_map_handle) * map.capacity);
+				free_memory(MEMORY_TAG_SLOT_MAP, map.slots, sizeof(slot_map_slot) * map.capacity);
+			}
+
+			map.values = values;
+			map.handles = handles;
+			map.slots = slots;
+			map.capacity = new_capacity;
+		}
+
+		// Frees the slot of the value at dense_index and fills the hole with the last value
+		template<typename T>
+		void remove_dense(slot_map<T>& map, uint dense_index) {
+			uint index = handle_index(map.handles[dense_index]);
+			uint last = map.count - 1;
+			if (dense_index != last) {
+				map.values[dense_index] = std::move(map.values[last]);
+				map.handles[dense_index] = map.handles[last];
+				map.slots[handle_index(map.handles[dense_index])].index = dense_index;
+			}
+			map.values[last].~T();
+			map.count--;
+
+			// Bumping the generation makes the handles of the removed value stale
+			slot_map_slot& slot = map.slots[index];
+			slot.generation = (slot.generation + 1) & SLOT_MAP_GENERATION_MASK;
+			slot.index = INVALID_ID;
+			if (map.free_head == INVALID_ID) {
+				map.free_head = index;
+			}
+			else {
+				map.slots[map.free_tail].index = index;
+			}
+			map.free_tail = index;
+		}
+	}
+
+	/**
+	 * @note capacity is the number of values that fit before the first grow, 0 allocates on the first insert.
+	 */
+	template<typename T>
+	void slot_map_create(slot_map<T>& out_map, uint capacity = 0) {
+		out_map.values = nullptr;
+		out_map.handles = nullptr;
+		out_map.count = 0;
+		out_map.capacity = 0;
+		out_map.slots = nullptr;
+		out_map.slot_count = 0;
+		out_map.free_head = INVALID_ID;
+		out_map.free_tail = INVALID_ID;
+
+		if (capacity) {
+			slot_map_internal::grow(out_map, capacity < SLOT_MAP_MAX_SLOTS ? capacity : SLOT_MAP_MAX_SLOTS);
+		}
+	}
+
+	/**
+	 * @brief Removes every value, all the handles given by the map become stale. The memory is kept for the next inserts.
+	 */
+	template<typename T>
+	void slot_map_clear(slot_map<T>& map) {
+		while (map.count) {
+			slot_map_internal::remove_dense(map, map.count - 1);
+		}
+	}
+
+	template<typename T>
+	void slot_map_destroy(slot_map<T>& map) {
+		for (uint i = 0; i < map.count; ++i) {
+			map.values[i].~T();
+		}
+
+		if (map.capacity) {
+			free_memory_aligned(MEMORY_TAG_SLOT_MAP, map.values, sizeof(T) * map.capacity, alignof(T));
+			free_memory(MEMORY_TAG_SLOT_MAP, map.handles, sizeof(slot_map_handle) * map.capacity);
+			free_memory(MEMORY_TAG_SLOT_MAP, map.slots, sizeof(slot_map_slot) * map.capacity);
+		}
+		slot_map_create(map);
+	}
+
+	/**
+	 * @brief Grows the map so capacity values fit without growing again.
+	 */
+	template<typename T>
+	void slot_map_reserve(slot_map<T>& map, uint capacity) {
+		if (capacity > map.capacity) {
+			slot_map_internal::grow(map, capacity < SLOT_MAP_MAX_SLOTS ? capacity : SLOT_MAP_MAX_SLOTS);
+		}
+	}
+
+	/**
+	 * @brief Inserts the value and returns its handle, INVALID_ID if the map already has SLOT_MAP_MAX_SLOTS values.
+	 */
+	template<typename T, typename U>
+	slot_map_handle slot_map_insert(slot_map<T>& map, U&& value) {
+		uint index;
+		if (map.free_head != INVALID_ID) {
+			index = map.free_head;
+			map.free_head = map.slots[index].index;
+			if (map.free_head == INVALID_ID) {
+				map.free_tail = INVALID_ID;
+			}
+		}
+		else {
+			if (map.slot_count == SLOT_MAP_MAX_SLOTS) {
+				return INVALID_ID;
+			}
+
+			// The free list is empty so every slot is used, count == slot_count
+			if (map.slot_count == map.capacity) {
+				uint new_capacity = map.capacity ? map.capacity * 2 : SLOT_MAP_MIN_CAPACITY;
+				slot_map_internal::grow(map, new_capacity < SLOT_MAP_MAX_SLOTS ? new_capacity : SLOT_MAP_MAX_SLOTS);
+			}
+			index = map.slot_count++;
+			map.slots[index].generation = 0;
+		}
+
+		slot_map_slot& slot = map.slots[index];
+		slot.index = map.count;
+		slot_map_handle handle = slot_map_internal::make_handle(index, slot.generation);
+
+		new (&map.values[map.count]) T(std::forward<U>(value));
+		map.handles[map.count] = handle;
+		map.count++;
+		return handle;
+	}
+
+	/**
+	 * @brief Removes the value of the handle, returns false if the handle is stale.
+	 * @note The last value is moved to the position of the removed one.
+	 */
+	template<typename T>
+	bool slot_map_remove(slot_map<T>& map, slot_map_handle handle) {
+		slot_map_slot* slot = slot_map_internal::find_slot(map, handle);
+		if (!slot) {
+			return false;
+		}
+
+		slot_map_internal::remove_dense(map, slot->index);
+		return true;
+	}
+
+	/**
+	 * @brief Gets the value of the handle, nullptr if the handle is stale. The pointer is valid until the next insert or remove.
+	 */
+	template<typename T>
+	T* slot_map_get(const slot_map<T>& map, slot_map_handle handle) {
+		slot_map_slot* slot = slot_map_internal::find_slot(map, handle);
+		return slot ? &map.values[slot->index] : nullptr;
+	}
+
+	template<typename T>
+	bool slot_map_contains(const slot_map<T>& map, slot_map_handle handle) {
+		return slot_map_internal::find_slot(map, handle) != nullptr;
+	}
+
+	template<typename T>
+	uint slot_map_size(const slot_map<T>& map) {
+		return map.count;
+	}
+
+	/**
+	 * @brief Gets the handle of the value at a position of the dense array, index must be smaller than slot_map_size.
+	 */
+	template<typename T>
+	slot_map_handle slot_map_handle_at(const slot_map<T>& map, uint index) {
+		return map.handles[index];
+	}
+
+	/**
+	 * @brief The values can be iterated with a range for over the dense array, for (T& value : map). The map can't be modified while iterating.
+	 */
+	template<typename T>
+	T* begin(const slot_map<T>& map) {
+		return map.values;
+	}
+
+	template<typename T>
+	T* end(const slot_map<T>& map) {
+		return map.values + map.count;
+	}
+}
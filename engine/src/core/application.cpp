@@ -4,7 +4,10 @@
 
 #include "core/logger.h"
 #include "core/cememory.h"
+#include "memory/frame_allocator.h"
+#include "memory/stack_allocator.h"
 #include "core/event.h"
+#include "core/name_id.h"
 #include "core/input.h"
 
 #include "renderer/renderer_frontend.h"
@@ -21,6 +24,7 @@
 #include "systems/camera_system.h"
 #include "systems/sprite_animation_system.h"
 #include "systems/ecs_system.h"
+#include "systems/ecs_scheduler.h"
 #include "systems/audio_system.h"
 #include "systems/scene_system.h"
 #include "systems/ui_system.h"
@@ -55,12 +59,29 @@ namespace caliope {
 		CE_LOG_INFO("Creating application");
 
 		memory_system_configuration memory_config = {};
-		memory_config.total_alloc_size = GIBIBYTES(1);
+		memory_config.total_alloc_size = config.memory_region_size ? config.memory_region_size : MEBIBYTES(256);
+		memory_config.max_alloc_size = config.maximum_memory_size ? config.maximum_memory_size : GIBIBYTES(1);
+		memory_config.reserve_address_space = true;
+		memory_config.allocator_freelist_type = FREELIST_TYPE_BINNED;
+		memory_config.track_callsites = false;
 		if (!memory_system_initialize(memory_config)) {
 			CE_LOG_FATAL("Failed to initialize memory system; shutting down");
 			return false;
 		}
 
+		// The job threads create their own scratch stacks when they start
+		if (!stack_allocator_create_thread_scratch(MEBIBYTES(8))) {
+			CE_LOG_FATAL("Failed to create the scratch stack of the main thread; shutting down");
+			return false;
+		}
+
+		frame_allocator_configuration frame_allocator_config;
+		frame_allocator_config.frame_size = MEBIBYTES(16);
+		if (!frame_allocator_initialize(frame_allocator_config)) {
+			CE_LOG_FATAL("Failed to initialize frame allocator; shutting down");
+			return false;
+		}
+
 		state_ptr = std::make_unique<application_state>();
 		state_ptr->program_config = std::make_shared<program_config>(config);
 		state_ptr->is_running = true;
@@ -70,6 +91,11 @@ namespace caliope {
 			return false;
 		}
 
+		if (!name_id_system_initialize()) {
+			CE_LOG_FATAL("Failed to initialize name id system; shutting down");
+			return false;
+		}
+
 		if (!event_system_initialize()) {
 			CE_LOG_FATAL("Failed to initialize platform; shutting down");
 			return false;
@@ -231,6 +257,11 @@ namespace caliope {
 			return false;
 		}
 
+		if (!ecs_scheduler_initialize()) {
+			CE_LOG_FATAL("Failed to initialize ecs scheduler; shutting down");
+			return false;
+		}
+
 		if (!audio_system_initialize()) {
 			CE_LOG_FATAL("Failed to initialize audio system; shutting down");
 			return false;
@@ -280,7 +311,7 @@ namespace caliope {
 
 
 		CE_LOG_INFO(get_memory_stats().c_str());
-		CE_LOG_INFO("Total usage of memory: %.2fMb/%.2fMb", get_memory_usage() / 1024.0 / 1024.0, memory_config.total_alloc_size / 1024.0 / 1024.0);
+		CE_LOG_INFO("Total usage of memory: %.2fMb/%.2fMb", get_memory_usage() / 1024.0 / 1024.0, memory_config.max_alloc_size / 1024.0 / 1024.0);
 
 		return true;
 	}
@@ -298,6 +329,8 @@ namespace caliope {
 				float delta_time = current_time - state_ptr->last_frame_time;
 				state_ptr->last_frame_time = current_time;
 
+				memory_system_begin_frame();
+
 				// Update the job system
 				job_system_update();
 				
@@ -305,7 +338,17 @@ namespace caliope {
 					CE_LOG_ERROR("Failed to update the program;");
 				}
 
-				std::vector<renderer_view_packet> packets;
+				// Sync point of the ECS, the structural changes recorded during the last frame are applied before the systems run
+				ecs_system_apply_frame_commands();
+
+				// Everything built for the render packets is released here when its arena comes back around
+				frame_allocator_begin_frame();
+
+				// The ECS systems run on the job threads, their outputs live on the frame arena until the render packets are built
+				ecs_scheduler_update(delta_time);
+
+				frame_vector<renderer_view_packet> packets;
+				packets.reserve(4);
 				scene_system_populate_render_packet(packets, state_ptr->program_config->game_state.world_camera, delta_time);
 				ui_system_populate_render_packet(packets, state_ptr->program_config->game_state.ui_camera, delta_time);
 
@@ -333,6 +376,8 @@ namespace caliope {
 
 		audio_system_shutdown();
 
+		ecs_scheduler_shutdown();
+
 		ecs_system_shutdown();
 
 		camera_system_shutdown();
@@ -363,8 +408,14 @@ namespace caliope {
 
 		event_system_shutdown();
 
+		name_id_system_shutdown();
+
 		logger_system_shutdown();
 
+		frame_allocator_shutdown();
+
+		stack_allocator_destroy_thread_scratch();
+
 		memory_system_shutdown();
 
 		return true;
@@ -4,44 +4,220 @@
 #include "platform/platform.h"
 
 #include "memory/dynamic_allocator.h"
+#include "memory/pool_allocator.h"
+
+#include <mutex>
+#include <atomic>
+#include <new>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MEMORY_CALLSITE() _ReturnAddress()
+#else
+#define MEMORY_CALLSITE() __builtin_return_address(0)
+#endif
 
 namespace caliope {
+	// Size classes served by the pools, power of two sizes from 16B to 4KiB. Bigger requests go straight to the dynamic allocator.
+	#define MEMORY_POOL_MIN_BLOCK_SIZE 16
+	#define MEMORY_POOL_MAX_BLOCK_SIZE 4096
+	#define MEMORY_POOL_CLASS_COUNT 9
+	#define MEMORY_POOL_CHUNK_SIZE KIBIBYTES(64)
+
+	// Every thread keeps a few free blocks of each size class, taken from and given back to the shared pools in batches.
+	#define MEMORY_THREAD_CACHE_BATCH_SIZE KIBIBYTES(8)
+	#define MEMORY_THREAD_CACHE_MIN_BATCH 2
+	#define MEMORY_THREAD_CACHE_MAX_BATCH 64
+
+	typedef struct memory_tag_counters {
+		std::atomic<uint64> live_bytes;
+		std::atomic<uint64> peak_bytes;
+		std::atomic<uint64> allocation_count;
+		std::atomic<uint64> free_count;
+		std::atomic<uint64> frame_allocation_count;
+		std::atomic<uint64> frame_allocated_bytes;
+		std::atomic<uint64> size_histogram[MEMORY_SIZE_HISTOGRAM_BUCKETS];
+
+		// Copied from the frame counters on memory_system_begin_frame
+		uint64 last_frame_allocation_count;
+		uint64 last_frame_allocated_bytes;
+	} memory_tag_counters;
+
+	typedef struct memory_allocation_record {
+		void* callsite;
+		uint64 size;
+		memory_tag tag;
+	} memory_allocation_record;
+
+	// The callsite tracking can't use the engine allocator, it would track itself
+	template<typename T>
+	struct memory_tracking_allocator {
+		typedef T value_type;
+
+		memory_tracking_allocator() = default;
+		template<typename U>
+		memory_tracking_allocator(const memory_tracking_allocator<U>&) {}
+
+		T* allocate(size_t count) {
+			return static_cast<T*>(platform_system_allocate_memory(count * sizeof(T)));
+		}
+
+		void deallocate(T* block, size_t count) {
+			platform_system_free_memory(block);
+		}
+
+		template<typename U>
+		bool operator==(const memory_tracking_allocator<U>&) const { return true; }
+		template<typename U>
+		bool operator!=(const memory_tracking_allocator<U>&) const { return false; }
+	};
+
+	typedef std::unordered_map<void*, memory_allocation_record, std::hash<void*>, std::equal_to<void*>,
+		memory_tracking_allocator<std::pair<void* const, memory_allocation_record>>> memory_allocation_map;
+
 	typedef struct memory_system_state {
 		memory_system_configuration config;
-		uint64 alloc_count;
+		std::atomic<uint64> alloc_count;
 		uint64 allocator_memory_requirement;
 		dynamic_allocator allocator;
 		void* allocator_block;
 
-		int memory_stats[MAX_MEMORY_TAGS];
+		// Guards the dynamic allocator and the pools, the threads only reach them to refill or flush their caches and for big blocks.
+		std::mutex allocator_mutex;
+		pool_allocator pools[MEMORY_POOL_CLASS_COUNT];
+		uint pool_batch_counts[MEMORY_POOL_CLASS_COUNT];
+
+		memory_tag_counters tag_counters[MAX_MEMORY_TAGS];
 
-		uint64 total_usage;
+		std::atomic<uint64> total_usage;
+		std::atomic<uint64> peak_usage;
+
+		std::mutex tracking_mutex;
+		memory_allocation_map live_allocations;
 	} memory_system_state;
 
 	static memory_system_state* state_ptr;
 
+	typedef struct memory_thread_cache {
+		// The memory system the blocks were taken from, a cache left from a previous one is discarded.
+		memory_system_state* owner;
+		// Free blocks linked through their own memory, like in the pools.
+		void* blocks[MEMORY_POOL_CLASS_COUNT];
+		uint block_counts[MEMORY_POOL_CLASS_COUNT];
+
+		~memory_thread_cache();
+	} memory_thread_cache;
+
+	static thread_local memory_thread_cache thread_cache;
+
+	void thread_cache_flush(memory_thread_cache& cache, uint class_index, uint keep_count);
+	void report_leaks();
+
+	uint get_pool_class_index(uint64 size) {
+		uint index = 0;
+		uint64 class_size = MEMORY_POOL_MIN_BLOCK_SIZE;
+		while (class_size < size) {
+			class_size <<= 1;
+			++index;
+		}
+
+		return index;
+	}
+
+	memory_thread_cache& get_thread_cache() {
+		if (thread_cache.owner != state_ptr) {
+			zero_memory(&thread_cache, sizeof(memory_thread_cache));
+			thread_cache.owner = state_ptr;
+		}
+
+		return thread_cache;
+	}
+
+	void* thread_cache_allocate(uint class_index) {
+		memory_thread_cache& cache = get_thread_cache();
+		if (!cache.blocks[class_index]) {
+			std::lock_guard<std::mutex> lock(state_ptr->allocator_mutex);
+			for (uint i = 0; i < state_ptr->pool_batch_counts[class_index]; ++i) {
+				void* block = pool_allocator_allocate(state_ptr->pools[class_index]);
+				if (!block) {
+					break;
+				}
+				*(void**)block = cache.blocks[class_index];
+				cache.blocks[class_index] = block;
+				cache.block_counts[class_index]++;
+			}
+
+			if (!cache.blocks[class_index]) {
+				return nullptr;
+			}
+		}
+
+		void* block = cache.blocks[class_index];
+		cache.blocks[class_index] = *(void**)block;
+		cache.block_counts[class_index]--;
+		return block;
+	}
+
+	void thread_cache_free(uint class_index, void* block) {
+		memory_thread_cache& cache = get_thread_cache();
+		*(void**)block = cache.blocks[class_index];
+		cache.blocks[class_index] = block;
+		cache.block_counts[class_index]++;
+
+		// Keeps one batch, so a thread freeing what another one allocates does not hoard the blocks
+		if (cache.block_counts[class_index] >= state_ptr->pool_batch_counts[class_index] * 2) {
+			thread_cache_flush(cache, class_index, state_ptr->pool_batch_counts[class_index]);
+		}
+	}
+
+	void thread_cache_flush(memory_thread_cache& cache, uint class_index, uint keep_count) {
+		std::lock_guard<std::mutex> lock(state_ptr->allocator_mutex);
+		while (cache.block_counts[class_index] > keep_count) {
+			void* block = cache.blocks[class_index];
+			cache.blocks[class_index] = *(void**)block;
+			cache.block_counts[class_index]--;
+			pool_allocator_free(state_ptr->pools[class_index], block);
+		}
+	}
+
+	memory_thread_cache::~memory_thread_cache() {
+		// The thread is exiting, its blocks go back to the pools while the memory system is alive
+		if (owner && owner == state_ptr) {
+			for (uint i = 0; i < MEMORY_POOL_CLASS_COUNT; ++i) {
+				thread_cache_flush(*this, i, 0);
+			}
+		}
+	}
+
 	bool memory_system_initialize(memory_system_configuration config) {
 		uint64 state_memory_requirement = sizeof(memory_system_state);
 
+		dynamic_allocator_configuration allocator_config;
+		allocator_config.total_size = config.total_alloc_size;
+		allocator_config.max_size = config.max_alloc_size;
+		allocator_config.list_type = config.allocator_freelist_type;
+		allocator_config.backing = config.reserve_address_space ? DYNAMIC_ALLOCATOR_BACKING_VIRTUAL : DYNAMIC_ALLOCATOR_BACKING_INLINE;
+
 		uint64 alloc_requirement = 0;
-		dynamic_allocator_create(config.total_alloc_size, alloc_requirement, 0, state_ptr->allocator);
+		dynamic_allocator requirement_allocator;
+		dynamic_allocator_create(allocator_config, alloc_requirement, 0, requirement_allocator);
 
 		void* block = platform_system_allocate_memory(state_memory_requirement + alloc_requirement);
 		if (!block) {
 			CE_LOG_FATAL("Memory system allocation failed and the system cannot continue.");
 		}
 
-		state_ptr = (memory_system_state*)block;
+		// NOTE: Placement new, the state has a mutex and atomics that must be constructed
+		state_ptr = new (block) memory_system_state();
 		state_ptr->config = config;
 		state_ptr->total_usage = 0;
 		state_ptr->alloc_count = 0;
 		state_ptr->allocator_memory_requirement = alloc_requirement;
 
 		state_ptr->allocator_block = (((char*)(void*)block) + state_memory_requirement);
-		zero_memory(state_ptr->memory_stats, sizeof(int) * MAX_MEMORY_TAGS);
 
 		if (!dynamic_allocator_create(
-			config.total_alloc_size,
+			allocator_config,
 			state_ptr->allocator_memory_requirement,
 			state_ptr->allocator_block,
 			state_ptr->allocator
@@ -50,27 +226,133 @@ namespace caliope {
 			return false;
 		}
 
-		CE_LOG_INFO("Memory system successfully allocated %llu bytes.", config.total_alloc_size);
+		uint64 class_size = MEMORY_POOL_MIN_BLOCK_SIZE;
+		for (uint i = 0; i < MEMORY_POOL_CLASS_COUNT; ++i) {
+			pool_allocator_create(class_size, MEMORY_POOL_CHUNK_SIZE / class_size, &state_ptr->allocator, state_ptr->pools[i]);
+
+			uint64 batch_count = MEMORY_THREAD_CACHE_BATCH_SIZE / class_size;
+			batch_count = batch_count < MEMORY_THREAD_CACHE_MIN_BATCH ? MEMORY_THREAD_CACHE_MIN_BATCH : batch_count;
+			state_ptr->pool_batch_counts[i] = (uint)(batch_count > MEMORY_THREAD_CACHE_MAX_BATCH ? MEMORY_THREAD_CACHE_MAX_BATCH : batch_count);
+			class_size <<= 1;
+		}
+
+		if (config.reserve_address_space) {
+			CE_LOG_INFO("Memory system successfully reserved %llu bytes.", config.total_alloc_size);
+		}
+		else {
+			CE_LOG_INFO("Memory system successfully allocated %llu bytes.", config.total_alloc_size);
+		}
 		return true;
 	}
 
 	void memory_system_shutdown() {
 		CE_LOG_INFO(get_memory_stats().c_str());
-		CE_LOG_INFO("Total usage of memory: %.2fMb/%.2fMb", get_memory_usage() / 1024.0 / 1024.0, state_ptr->config.total_alloc_size / 1024.0 / 1024.0);
-
 		if (state_ptr) {
+			CE_LOG_INFO("Total usage of memory: %.2fMb/%.2fMb", get_memory_usage() / 1024.0 / 1024.0, dynamic_allocator_reserved_size(state_ptr->allocator) / 1024.0 / 1024.0);
+
+			if (state_ptr->config.track_callsites) {
+				report_leaks();
+			}
+
+			// NOTE: The job threads must be joined before this point, only the caller's cache can be given back
+			memory_thread_cache& cache = get_thread_cache();
+			for (uint i = 0; i < MEMORY_POOL_CLASS_COUNT; ++i) {
+				thread_cache_flush(cache, i, 0);
+			}
+
+			for (uint i = 0; i < MEMORY_POOL_CLASS_COUNT; ++i) {
+				pool_allocator_destroy(state_ptr->pools[i]);
+			}
 			dynamic_allocator_destroy(state_ptr->allocator);
+			state_ptr->~memory_system_state();
 			platform_system_free_memory(state_ptr);
 		}
 		state_ptr = nullptr;
 	}
 
-	void* allocate_memory(memory_tag tag, uint64 size) {
+	void update_peak(std::atomic<uint64>& peak, uint64 value) {
+		uint64 current_peak = peak.load(std::memory_order_relaxed);
+		while (value > current_peak && !peak.compare_exchange_weak(current_peak, value, std::memory_order_relaxed)) {
+		}
+	}
+
+	uint get_size_histogram_bucket(uint64 size) {
+		uint bucket = 0;
+		while (size > 1 && bucket < MEMORY_SIZE_HISTOGRAM_BUCKETS - 1) {
+			size >>= 1;
+			++bucket;
+		}
+
+		return bucket;
+	}
+
+	void record_allocation(memory_tag tag, uint64 size) {
+		memory_tag_counters& counters = state_ptr->tag_counters[tag];
+		update_peak(counters.peak_bytes, counters.live_bytes.fetch_add(size, std::memory_order_relaxed) + size);
+		update_peak(state_ptr->peak_usage, state_ptr->total_usage.fetch_add(size, std::memory_order_relaxed) + size);
+		counters.allocation_count.fetch_add(1, std::memory_order_relaxed);
+		counters.frame_allocation_count.fetch_add(1, std::memory_order_relaxed);
+		counters.frame_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+		counters.size_histogram[get_size_histogram_bucket(size)].fetch_add(1, std::memory_order_relaxed);
+		state_ptr->alloc_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void record_free(memory_tag tag, uint64 size) {
+		memory_tag_counters& counters = state_ptr->tag_counters[tag];
+		counters.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+		counters.free_count.fetch_add(1, std::memory_order_relaxed);
+		state_ptr->total_usage.fetch_sub(size, std::memory_order_relaxed);
+	}
+
+	void report_leaks() {
+		struct leak_summary {
+			void* callsite;
+			memory_tag tag;
+			uint64 count;
+			uint64 bytes;
+		};
+
+		std::lock_guard<std::mutex> lock(state_ptr->tracking_mutex);
+		if (state_ptr->live_allocations.empty()) {
+			return;
+		}
+
+		// NOTE: The summaries use the SO memory, the engine allocator is being shut down
+		std::vector<leak_summary, memory_tracking_allocator<leak_summary>> summaries;
+		for (auto& [block, record] : state_ptr->live_allocations) {
+			auto it = std::find_if(summaries.begin(), summaries.end(), [&record](const leak_summary& summary) {
+				return summary.callsite == record.callsite && summary.tag == record.tag;
+			});
+
+			if (it == summaries.end()) {
+				summaries.push_back({ record.callsite, record.tag, 1, record.size });
+			}
+			else {
+				it->count++;
+				it->bytes += record.size;
+			}
+		}
+
+		std::sort(summaries.begin(), summaries.end(), [](const leak_summary& a, const leak_summary& b) {
+			return a.bytes > b.bytes;
+		});
+
+		CE_LOG_WARNING("memory_system_shutdown found %llu blocks not freed from %llu callsites:", (uint64)state_ptr->live_allocations.size(), (uint64)summaries.size());
+		for (const leak_summary& summary : summaries) {
+			CE_LOG_WARNING("  0x%p: %llu blocks, %lluB (tag %u)", summary.callsite, summary.count, summary.bytes, (uint)summary.tag);
+		}
+	}
+
+	void* allocate_memory_with_callsite(memory_tag tag, uint64 size, void* callsite, bool zero) {
 		void* block = 0;
 		if (state_ptr != nullptr) {
-			state_ptr->total_usage += size;
-			state_ptr->memory_stats[tag] += size;
-			block = dynamic_allocator_allocate(state_ptr->allocator, size);
+			if (size <= MEMORY_POOL_MAX_BLOCK_SIZE) {
+				block = thread_cache_allocate(get_pool_class_index(size));
+			}
+			else {
+				std::lock_guard<std::mutex> lock(state_ptr->allocator_mutex);
+				block = dynamic_allocator_allocate(state_ptr->allocator, size);
+			}
 		}
 		else {
 			CE_LOG_WARNING("allocate_memory called when the memory system is uninitialize, calling SO to allocate.");
@@ -78,7 +360,17 @@ namespace caliope {
 		}
 
 		if (block) {
-			platform_system_zero_memory(block, size);
+			if (state_ptr != nullptr) {
+				record_allocation(tag, size);
+				if (state_ptr->config.track_callsites) {
+					std::lock_guard<std::mutex> lock(state_ptr->tracking_mutex);
+					state_ptr->live_allocations[block] = { callsite, size, tag };
+				}
+			}
+
+			if (zero) {
+				platform_system_zero_memory(block, size);
+			}
 			return block;
 		}
 
@@ -86,14 +378,83 @@ namespace caliope {
 		return nullptr;
 	}
 
+	// The blocks with a bigger alignment than the default one are allocated with room to align them.
+	// The header before the aligned block keeps the size asked for and the distance to the real block.
+	typedef struct memory_aligned_header {
+		uint64 size;
+		uint64 offset;
+	} memory_aligned_header;
+
+	void* allocate_memory_aligned_with_callsite(memory_tag tag, uint64 size, uint64 alignment, void* callsite, bool zero) {
+		if (alignment <= MEMORY_DEFAULT_ALIGNMENT) {
+			return allocate_memory_with_callsite(tag, size, callsite, zero);
+		}
+
+		// NOTE: The real block is aligned to MEMORY_DEFAULT_ALIGNMENT, so there are always at least that many bytes for the header
+		void* block = allocate_memory_with_callsite(tag, size + alignment, callsite, false);
+		if (!block) {
+			return nullptr;
+		}
+
+		uint64 aligned_address = ((uint64)block + alignment) & ~(alignment - 1);
+		memory_aligned_header* header = ((memory_aligned_header*)aligned_address) - 1;
+		header->size = size;
+		header->offset = aligned_address - (uint64)block;
+
+		if (zero) {
+			platform_system_zero_memory((void*)aligned_address, size);
+		}
+		return (void*)aligned_address;
+	}
+
+	void free_memory_aligned_block(memory_tag tag, void* block, uint64 alignment) {
+		memory_aligned_header* header = ((memory_aligned_header*)block) - 1;
+		free_memory(tag, ((char*)block) - header->offset, header->size + alignment);
+	}
+
+	CE_NOINLINE void* allocate_memory(memory_tag tag, uint64 size) {
+		return allocate_memory_with_callsite(tag, size, MEMORY_CALLSITE(), true);
+	}
+
+	CE_NOINLINE void* allocate_memory_uninitialized(memory_tag tag, uint64 size) {
+		return allocate_memory_with_callsite(tag, size, MEMORY_CALLSITE(), false);
+	}
+
+	CE_NOINLINE void* allocate_memory_aligned(memory_tag tag, uint64 size, uint64 alignment) {
+		return allocate_memory_aligned_with_callsite(tag, size, alignment, MEMORY_CALLSITE(), true);
+	}
+
+	void free_memory_aligned(memory_tag tag, void* block, uint64 size, uint64 alignment) {
+		if (alignment <= MEMORY_DEFAULT_ALIGNMENT) {
+			free_memory(tag, block, size);
+			return;
+		}
+
+		if (block) {
+			free_memory_aligned_block(tag, block, alignment);
+		}
+	}
+
 	void free_memory(memory_tag tag, void* block, uint64 size) {
-		if (state_ptr != nullptr) {
-			state_ptr->total_usage -= size;
-			state_ptr->memory_stats[tag] -= size;
-			bool result = dynamic_allocator_free(state_ptr->allocator, block, size);
-			if (!result) {
-				platform_system_free_memory(block);
+		if (state_ptr != nullptr && dynamic_allocator_owns_block(state_ptr->allocator, block)) {
+			record_free(tag, size);
+			if (state_ptr->config.track_callsites) {
+				std::lock_guard<std::mutex> lock(state_ptr->tracking_mutex);
+				state_ptr->live_allocations.erase(block);
 			}
+
+			// NOTE: The size must be the same used to allocate the block, it is what tells which pool owns it
+			if (size <= MEMORY_POOL_MAX_BLOCK_SIZE) {
+				thread_cache_free(get_pool_class_index(size), block);
+			}
+			else {
+				std::lock_guard<std::mutex> lock(state_ptr->allocator_mutex);
+				dynamic_allocator_free(state_ptr->allocator, block, size);
+			}
+		}
+		else if (state_ptr != nullptr) {
+			// Allocated by the SO before the memory system was initialized
+			platform_system_free_memory(block);
 		}
 		else {
 			CE_LOG_WARNING("free_memory called when the memory system is uninitialize, calling SO to free.");
@@ -122,33 +483,177 @@ namespace caliope {
 			"MEMORY_TAG_ECS             ",
 			"MEMORY_TAG_LOADERS         ",
 			"MEMORY_TAG_RING_QUEUE      ",
-			"MEMORY_TAG_JOB             "
+			"MEMORY_TAG_JOB             ",
+			"MEMORY_TAG_LINEAR_ALLOCATOR ",
+			"MEMORY_TAG_STACK_ALLOCATOR ",
+			"MEMORY_TAG_HASH_MAP        ",
+			"MEMORY_TAG_SLOT_MAP        ",
+			"MEMORY_TAG_AUDIO           "
 		};
 
 		for (int i = 0; i < MAX_MEMORY_TAGS; ++i) {
-			stats += (string_tags[i] + std::to_string(state_ptr->memory_stats[i] / 1024.0 / 1024.0) + "Mb \n");
+			memory_tag_stats tag_stats;
+			get_memory_tag_stats((memory_tag)i, tag_stats);
+			stats += (string_tags[i] + std::to_string(tag_stats.live_bytes / 1024.0 / 1024.0) + "Mb (peak " + std::to_string(tag_stats.peak_bytes / 1024.0 / 1024.0) + "Mb, " +
+				std::to_string(tag_stats.allocation_count) + " allocs, " + std::to_string(tag_stats.free_count) + " frees, " + std::to_string(tag_stats.frame_allocation_count) + " allocs last frame) \n");
 		}
 
+		freelist_metrics metrics;
+		uint64 committed_size = 0;
+		uint64 reserved_size = 0;
+		{
+			std::lock_guard<std::mutex> lock(state_ptr->allocator_mutex);
+			dynamic_allocator_get_metrics(state_ptr->allocator, metrics);
+			committed_size = dynamic_allocator_committed_size(state_ptr->allocator);
+			reserved_size = dynamic_allocator_reserved_size(state_ptr->allocator);
+		}
+		stats += "Heap free blocks: " + std::to_string(metrics.hole_count) + ", largest free block: " + std::to_string(metrics.largest_free_block / 1024.0 / 1024.0) + "Mb/" + std::to_string(metrics.free_space / 1024.0 / 1024.0) + "Mb \n";
+		stats += "Heap committed: " + std::to_string(committed_size / 1024.0 / 1024.0) + "Mb/" + std::to_string(reserved_size / 1024.0 / 1024.0) + "Mb \n";
+
 		return stats;
 	}
 
+	void memory_system_begin_frame() {
+		if (!state_ptr) {
+			return;
+		}
+
+		for (uint i = 0; i < MAX_MEMORY_TAGS; ++i) {
+			memory_tag_counters& counters = state_ptr->tag_counters[i];
+			counters.last_frame_allocation_count = counters.frame_allocation_count.exchange(0, std::memory_order_relaxed);
+			counters.last_frame_allocated_bytes = counters.frame_allocated_bytes.exchange(0, std::memory_order_relaxed);
+		}
+	}
+
+	void get_memory_tag_stats(memory_tag tag, memory_tag_stats& out_stats) {
+		zero_memory(&out_stats, sizeof(memory_tag_stats));
+		if (!state_ptr) {
+			return;
+		}
+
+		memory_tag_counters& counters = state_ptr->tag_counters[tag];
+		out_stats.live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+		out_stats.peak_bytes = counters.peak_bytes.load(std::memory_order_relaxed);
+		out_stats.allocation_count = counters.allocation_count.load(std::memory_order_relaxed);
+		out_stats.free_count = counters.free_count.load(std::memory_order_relaxed);
+		out_stats.frame_allocation_count = counters.last_frame_allocation_count;
+		out_stats.frame_allocated_bytes = counters.last_frame_allocated_bytes;
+		for (uint i = 0; i < MEMORY_SIZE_HISTOGRAM_BUCKETS; ++i) {
+			out_stats.size_histogram[i] = counters.size_histogram[i].load(std::memory_order_relaxed);
+		}
+	}
+
 	uint64 get_memory_usage() {
-		return state_ptr->total_usage;
+		return state_ptr->total_usage.load(std::memory_order_relaxed);
+	}
+
+	uint64 get_memory_peak_usage() {
+		if (state_ptr) {
+			return state_ptr->peak_usage.load(std::memory_order_relaxed);
+		}
+
+		return 0;
+	}
+
+	void get_memory_heap_metrics(freelist_metrics& out_metrics) {
+		zero_memory(&out_metrics, sizeof(freelist_metrics));
+		if (!state_ptr) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(state_ptr->allocator_mutex);
+		dynamic_allocator_get_metrics(state_ptr->allocator, out_metrics);
 	}
 
 	uint64 get_memory_alloc_count() {
 		if (state_ptr) {
-			return state_ptr->alloc_count;
+			return state_ptr->alloc_count.load(std::memory_order_relaxed);
 		}
 		
 		return 0;
 	}
 }
 
+// The blocks of operator new keep their size in a header, the unsized deletes need it to give the block back to its pool.
+// NOTE: The header takes MEMORY_DEFAULT_ALIGNMENT bytes so the objects keep the default alignment
+static void* allocate_new_operator_block(size_t size, void* callsite) {
+	// NOTE: The objects are constructed right after, so the blocks are not zeroed
+	uint64* block = (uint64*)caliope::allocate_memory_with_callsite(caliope::MEMORY_TAG_NEW_OPERATOR, size + MEMORY_DEFAULT_ALIGNMENT, callsite, false);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+
+	*block = size + MEMORY_DEFAULT_ALIGNMENT;
+	return ((char*)block) + MEMORY_DEFAULT_ALIGNMENT;
+}
+
+static void free_new_operator_block(void* memory) {
+	if (!memory) {
+		return;
+	}
+
+	uint64* block = (uint64*)(((char*)memory) - MEMORY_DEFAULT_ALIGNMENT);
+	caliope::free_memory(caliope::MEMORY_TAG_NEW_OPERATOR, block, *block);
+}
+
 void* operator new (size_t size) {
-	return caliope::allocate_memory(caliope::MEMORY_TAG_NEW_OPERATOR, size);
+	return allocate_new_operator_block(size, MEMORY_CALLSITE());
+}
+
+void* operator new[](size_t size) {
+	return allocate_new_operator_block(size, MEMORY_CALLSITE());
+}
+
+void* operator new (size_t size, std::align_val_t alignment) {
+	void* block = caliope::allocate_memory_aligned_with_callsite(caliope::MEMORY_TAG_NEW_OPERATOR, size, (uint64)alignment, MEMORY_CALLSITE(), false);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	return block;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	void* block = caliope::allocate_memory_aligned_with_callsite(caliope::MEMORY_TAG_NEW_OPERATOR, size, (uint64)alignment, MEMORY_CALLSITE(), false);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	return block;
+}
+
+void operator delete(void* memory) noexcept {
+	free_new_operator_block(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	free_new_operator_block(memory);
+}
+
+// The size of the sized deletes doesn't count the header, the one stored in the block is used
+void operator delete(void* memory, size_t size) noexcept {
+	free_new_operator_block(memory);
 }
 
-void operator delete(void* memory, size_t size) {
-	caliope::free_memory(caliope::MEMORY_TAG_NEW_OPERATOR, memory, size);
-}
\ No newline at end of file
+void operator delete[](void* memory, size_t size) noexcept {
+	free_new_operator_block(memory);
+}
+
+void operator delete(void* memory, size_t size, std::align_val_t alignment) noexcept {
+	caliope::free_memory_aligned(caliope::MEMORY_TAG_NEW_OPERATOR, memory, size, (uint64)alignment);
+}
+
+void operator delete[](void* memory, size_t size, std::align_val_t alignment) noexcept {
+	caliope::free_memory_aligned(caliope::MEMORY_TAG_NEW_OPERATOR, memory, size, (uint64)alignment);
+}
+
+// The aligned new is only used for alignments bigger than the default one, so these blocks always have the header with the size
+void operator delete(void* memory, std::align_val_t alignment) noexcept {
+	if (memory) {
+		caliope::free_memory_aligned_block(caliope::MEMORY_TAG_NEW_OPERATOR, memory, (uint64)alignment);
+	}
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept {
+	if (memory) {
+		caliope::free_memory_aligned_block(caliope::MEMORY_TAG_NEW_OPERATOR, memory, (uint64)alignment);
+	}
+}
@@ -2,6 +2,8 @@
 
 #include "defines.h"
 
+#include "containers/freelist.h"
+
 namespace caliope {
 
 	typedef enum memory_tag {
@@ -11,6 +13,11 @@ namespace caliope {
 		MEMORY_TAG_LOADER,
 		MEMORY_TAG_RING_QUEUE,
 		MEMORY_TAG_JOB,
+		MEMORY_TAG_LINEAR_ALLOCATOR,
+		MEMORY_TAG_STACK_ALLOCATOR,
+		MEMORY_TAG_HASH_MAP,
+		MEMORY_TAG_SLOT_MAP,
+		MEMORY_TAG_AUDIO,
 
 
 		MAX_MEMORY_TAGS
@@ -19,19 +26,72 @@ namespace caliope {
 
 	typedef struct memory_system_configuration {
 		uint64 total_alloc_size;
+		// When it is bigger than total_alloc_size, the heap grows with regions of total_alloc_size up to this size
+		uint64 max_alloc_size;
+		// Reserves the address space and commits the pages as they are used, instead of allocating the whole size up front
+		bool reserve_address_space;
+		freelist_type allocator_freelist_type;
+		// Records where every live block was allocated, to report the leaks on shutdown. Every allocation takes a lock, so it is meant for debugging.
+		bool track_callsites;
 	}memory_system_configuration;
 
-	bool memory_system_initialize(memory_system_configuration config);
-	void memory_system_shutdown();
+	#define MEMORY_SIZE_HISTOGRAM_BUCKETS 32
+
+	typedef struct memory_tag_stats {
+		uint64 live_bytes;
+		uint64 peak_bytes;
+		uint64 allocation_count;
+		uint64 free_count;
+
+		// Allocations done during the last completed frame
+		uint64 frame_allocation_count;
+		uint64 frame_allocated_bytes;
+
+		// Bucket i counts the allocations with a size in [2^i, 2^(i+1)), the last bucket also counts the bigger ones
+		uint64 size_histogram[MEMORY_SIZE_HISTOGRAM_BUCKETS];
+	} memory_tag_stats;
+
+	CE_API bool memory_system_initialize(memory_system_configuration config);
+	CE_API void memory_system_shutdown();
+
+	// Every block from allocate_memory and allocate_memory_uninitialized is aligned to it
+	#define MEMORY_DEFAULT_ALIGNMENT 16
+
+	/**
+	 * @note allocate_memory and free_memory can be called from any thread. The memory system must outlive the threads using it.
+	 */
+	CE_API void* allocate_memory(memory_tag tag, uint64 size);
+	CE_API void free_memory(memory_tag tag, void* block, uint64 size);
+
+	/**
+	 * @brief Same as allocate_memory without zeroing the block, for blocks that are overwritten right away.
+	 */
+	CE_API void* allocate_memory_uninitialized(memory_tag tag, uint64 size);
+
+	/**
+	 * @brief Allocates a zeroed block aligned to alignment, that must be a power of two.
+	 * @note The block must be freed with free_memory_aligned using the same size and alignment.
+	 */
+	CE_API void* allocate_memory_aligned(memory_tag tag, uint64 size, uint64 alignment);
+	CE_API void free_memory_aligned(memory_tag tag, void* block, uint64 size, uint64 alignment);
+	CE_API void* zero_memory(void* block, uint64 size);
+	CE_API void* copy_memory(void* dest, const void* source, uint64 size);
+	CE_API void* set_memory(void* dest, int value, uint64 size);
+
+	/**
+	 * @brief Closes the per-frame counters of the current frame, call it once at the beginning of every frame.
+	 */
+	CE_API void memory_system_begin_frame();
 
-	void* allocate_memory(memory_tag tag, uint64 size);
-	void free_memory(memory_tag tag, void* block, uint64 size);
-	void* zero_memory(void* block, uint64 size);
-	void* copy_memory(void* dest, const void* source, uint64 size);
-	void* set_memory(void* dest, int value, uint64 size);
+	CE_API std::string get_memory_stats();
+	CE_API void get_memory_tag_stats(memory_tag tag, memory_tag_stats& out_stats);
+	CE_API uint64 get_memory_usage();
+	CE_API uint64 get_memory_peak_usage();
+	CE_API uint64 get_memory_alloc_count();
 
-	std::string get_memory_stats();
-	uint64 get_memory_usage();
-	uint64 get_memory_alloc_count();
+	/**
+	 * @brief Gets the free blocks of the heap behind the big allocations, the pools are not included.
+	 */
+	CE_API void get_memory_heap_metrics(freelist_metrics& out_metrics);
 
 }
\ No newline at end of file
@@ -19,10 +19,19 @@ namespace caliope {
 			return false;
 		}
 
+		return strings_equali(str1->c_str(), str2->c_str());
+	}
+
+	bool strings_equali(const char* str1, const char* str2)
+	{
+		if (!str1 || !str2) {
+			return false;
+		}
+
 #if defined __GNUC__	
-		return strcasecmp(str1.c_str(), str2.c_str()) == 0;
+		return strcasecmp(str1, str2) == 0;
 #elif defined _MSC_VER
-		return strcmpi(str1->c_str(), str2->c_str()) == 0;
+		return strcmpi(str1, str2) == 0;
 #endif
 	}
 	
@@ -76,32 +85,59 @@ namespace caliope {
 	}
 	
 	bool string_to_vec4(std::string* str, glm::vec4* out_vec)
+	{
+		if (!str) {
+			return false;
+		}
+
+		return string_to_vec4(str->c_str(), out_vec);
+	}
+
+	bool string_to_vec4(const char* str, glm::vec4* out_vec)
 	{
 		if (!str || !out_vec) {
 			return false;
 		}
 
-		int result = std::sscanf(str->c_str(), "%f %f %f %f", &out_vec->x, &out_vec->y, &out_vec->z, &out_vec->w);
+		int result = std::sscanf(str, "%f %f %f %f", &out_vec->x, &out_vec->y, &out_vec->z, &out_vec->w);
 		return result != -1;
 	}
 	
 	bool string_to_vec3(std::string* str, glm::vec3* out_vec)
+	{
+		if (!str) {
+			return false;
+		}
+
+		return string_to_vec3(str->c_str(), out_vec);
+	}
+
+	bool string_to_vec3(const char* str, glm::vec3* out_vec)
 	{
 		if (!str || !out_vec) {
 			return false;
 		}
 
-		int result = std::sscanf(str->c_str(), "%f %f %f", &out_vec->x, &out_vec->y, &out_vec->z);
+		int result = std::sscanf(str, "%f %f %f", &out_vec->x, &out_vec->y, &out_vec->z);
 		return result != -1;
 	}
 	
 	bool string_to_vec2(std::string* str, glm::vec2* out_vec)
+	{
+		if (!str) {
+			return false;
+		}
+
+		return string_to_vec2(str->c_str(), out_vec);
+	}
+
+	bool string_to_vec2(const char* str, glm::vec2* out_vec)
 	{
 		if (!str || !out_vec) {
 			return false;
 		}
 
-		int result = std::sscanf(str->c_str(), "%f %f", &out_vec->x, &out_vec->y);
+		int result = std::sscanf(str, "%f %f", &out_vec->x, &out_vec->y);
 		return result != -1;
 	}
 	
@@ -166,12 +202,21 @@ namespace caliope {
 	}
 	
 	bool string_to_uint(std::string* str, uint* out_value)
+	{
+		if (!str) {
+			return false;
+		}
+
+		return string_to_uint(str->c_str(), out_value);
+	}
+
+	bool string_to_uint(const char* str, uint* out_value)
 	{
 		if (!str || !out_value) {
 			return false;
 		}
 
-		int result = std::sscanf(str->c_str(), "%u", out_value);
+		int result = std::sscanf(str, "%u", out_value);
 		return result != -1;
 	}
 	
@@ -186,12 +231,21 @@ namespace caliope {
 	}
 	
 	bool string_to_float(std::string* str, float* out_value)
+	{
+		if (!str) {
+			return false;
+		}
+
+		return string_to_float(str->c_str(), out_value);
+	}
+
+	bool string_to_float(const char* str, float* out_value)
 	{
 		if (!str || !out_value) {
 			return false;
 		}
 
-		int result = std::sscanf(str->c_str(), "%f", out_value);
+		int result = std::sscanf(str, "%f", out_value);
 		return result != -1;
 	}
 	
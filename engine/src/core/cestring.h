@@ -9,6 +9,7 @@
 namespace caliope {
 	CE_API bool strings_equal(std::string* str1, std::string* str2);
 	CE_API bool strings_equali(std::string* str1, std::string* str2);
+	CE_API bool strings_equali(const char* str1, const char* str2);
 
 	CE_API void string_format(std::string* str_format, char(&out_buffer)[2048], ...);
 	CE_API void string_trim_character(std::string* str, char character);
@@ -20,6 +21,13 @@ namespace caliope {
 	CE_API bool string_to_vec3(std::string* str, glm::vec3* out_vec);
 	CE_API bool string_to_vec2(std::string* str, glm::vec2* out_vec);
 
+	// Overloads for null terminated strings, to parse in place without building a std::string
+	CE_API bool string_to_vec4(const char* str, glm::vec4* out_vec);
+	CE_API bool string_to_vec3(const char* str, glm::vec3* out_vec);
+	CE_API bool string_to_vec2(const char* str, glm::vec2* out_vec);
+	CE_API bool string_to_uint(const char* str, uint* out_value);
+	CE_API bool string_to_float(const char* str, float* out_value);
+
 	CE_API bool string_to_char(std::string* str, char* out_value);
 	CE_API bool string_to_int16(std::string* str, int16* out_value);
 	CE_API bool string_to_int(std::string* str, int* out_value);
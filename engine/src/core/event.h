@@ -24,6 +24,8 @@ namespace caliope {
 		EVENT_CODE_ON_UI_BUTTON_UNHOVER = 0X1D,
 		EVENT_CODE_ON_UI_BUTTON_CLICKED = 0X1E,
 
+		EVENT_CODE_ON_ECS_SNAPSHOT_RESTORED = 0X20,
+
 		MAX_EVENT_CODE = 0XFF
 	}event_system_code;
 	
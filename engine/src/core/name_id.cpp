@@ -0,0 +1,76 @@
+#include "name_id.h"
+
+#include "cepch.h"
+#include "core/logger.h"
+
+#include <mutex>
+
+namespace caliope {
+
+	typedef struct name_id_system_state {
+		// The strings are never removed, the pointers given by name_id_get_string stay valid
+		std::unordered_map<name_id, std::string> interned_strings;
+		std::mutex interned_strings_mutex;
+	} name_id_system_state;
+
+	static std::unique_ptr<name_id_system_state> state_ptr;
+
+	bool name_id_system_initialize() {
+		state_ptr = std::make_unique<name_id_system_state>();
+
+		if (state_ptr == nullptr) {
+			return false;
+		}
+
+		CE_LOG_INFO("Name id system initialized.");
+		return true;
+	}
+
+	void name_id_system_shutdown() {
+		if (state_ptr) {
+			state_ptr->interned_strings.clear();
+			state_ptr.reset();
+		}
+	}
+
+	name_id name_id_intern(const char* string) {
+		if (string == nullptr) {
+			return INVALID_NAME_ID;
+		}
+
+		uint64 length = strlen(string);
+		name_id id = name_id_hash(string, length);
+		if (id == INVALID_NAME_ID || !state_ptr) {
+			return id;
+		}
+
+		std::lock_guard<std::mutex> lock(state_ptr->interned_strings_mutex);
+		auto it = state_ptr->interned_strings.find(id);
+		if (it == state_ptr->interned_strings.end()) {
+			state_ptr->interned_strings.insert({ id, std::string(string, length) });
+		}
+		else if (it->second.size() != length || it->second.compare(0, length, string) != 0) {
+			CE_LOG_ERROR("name_id_intern the names %s and %s have the same id %llu", it->second.c_str(), string, id);
+		}
+
+		return id;
+	}
+
+	const char* name_id_get_string(name_id id) {
+		if (id == INVALID_NAME_ID) {
+			return "";
+		}
+
+		if (!state_ptr) {
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> lock(state_ptr->interned_strings_mutex);
+		auto it = state_ptr->interned_strings.find(id);
+		if (it == state_ptr->interned_strings.end()) {
+			return nullptr;
+		}
+
+		return it->second.c_str();
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.h"
+
+#include <type_traits>
+
+namespace caliope {
+
+	/**
+	 * @brief Stable 64-bit identifier of a name, the FNV-1a hash of the string. The same string always gets the same id, in every run.
+	 */
+	typedef uint64 name_id;
+
+	// Id of the empty string, used as the invalid id
+	#define INVALID_NAME_ID 0ULL
+
+	constexpr name_id name_id_hash(const char* string, uint64 length) {
+		if (length == 0) {
+			return INVALID_NAME_ID;
+		}
+
+		name_id hash = 14695981039346656037ULL;
+		for (uint64 i = 0; i < length; ++i) {
+			hash ^= (uchar)string[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	/** @brief Gets the id of a string literal at compile time, i.e. NAME_ID("Builtin.UIShader") */
+	#define NAME_ID(literal) std::integral_constant<caliope::name_id, caliope::name_id_hash(literal, sizeof(literal) - 1)>::value
+
+	bool name_id_system_initialize();
+	void name_id_system_shutdown();
+
+	/**
+	 * @brief Gets the id of the string and stores the string so the id can be turned back into it.
+	 * @note It can be called from any thread. The systems intern the names once when the resources are loaded, not every frame.
+	 */
+	CE_API name_id name_id_intern(const char* string);
+
+	/**
+	 * @brief Gets the interned string of the id, nullptr if the string was never interned.
+	 * @note The pointer is valid until the system shutdown.
+	 */
+	CE_API const char* name_id_get_string(name_id id);
+}
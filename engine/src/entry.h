@@ -11,7 +11,7 @@ extern bool create_program(caliope::program_config& out_config);
  */
 int main(void){
 
-    caliope::program_config config;
+    caliope::program_config config = {};
 
     if(!create_program(config)){
         return -1;
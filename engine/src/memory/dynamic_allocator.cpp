@@ -3,49 +3,86 @@
 #include "core/logger.h"
 #include "core/cememory.h"
 #include "containers/freelist.h"
+#include "platform/platform.h"
 
+#include <atomic>
 
 namespace caliope {
-	typedef struct dynamic_allocator_state {
+	#define DYNAMIC_ALLOCATOR_MAX_REGIONS 32
+	// Every block size is rounded up to it, with the regions aligned every offset handed out is aligned too
+	#define DYNAMIC_ALLOCATOR_ALIGNMENT 16
+	// The pages of a virtual backing are committed in steps of this size to not call the OS on every allocation
+	#define DYNAMIC_ALLOCATOR_COMMIT_GRANULARITY KIBIBYTES(256)
+
+	typedef struct dynamic_allocator_region {
 		uint64 total_size;
+		uint64 committed_size;
 		freelist list;
 		void* freelist_block;
 		void* memory_block;
+		// Set when the region and its freelist were allocated by the allocator instead of given on create
+		bool owns_freelist_block;
+	} dynamic_allocator_region;
+
+	typedef struct dynamic_allocator_state {
+		dynamic_allocator_configuration config;
+		uint64 page_size;
+		uint64 reserved_size;
+		// Published after the region is set up, so owns_block can read the regions without the caller's lock
+		std::atomic<uint> region_count;
+		dynamic_allocator_region regions[DYNAMIC_ALLOCATOR_MAX_REGIONS];
 	} dynamic_allocator_state;
 
+	bool dynamic_allocator_create_region(dynamic_allocator_state* state, uint64 size, void* freelist_block, dynamic_allocator_region& out_region);
+	void dynamic_allocator_destroy_region(dynamic_allocator_state* state, dynamic_allocator_region& region);
+	bool dynamic_allocator_commit(dynamic_allocator_state* state, dynamic_allocator_region& region, uint64 end_offset);
 
-	bool dynamic_allocator_create(uint64 total_size, uint64& memory_requirement, void* memory, dynamic_allocator& out_allocator) {
-		if (total_size < 1) {
+	bool dynamic_allocator_create(const dynamic_allocator_configuration& config, uint64& memory_requirement, void* memory, dynamic_allocator& out_allocator) {
+		if (config.total_size < 1) {
 			CE_LOG_ERROR("dynamic_allocator_create cannot have a total_size of 0. Create failed.");
 			return false;
 		}
 
 		uint64 freelist_requirement = 0;
-		dynamic_allocator_state* state = nullptr;
-		freelist_create(total_size, freelist_requirement, 0, state->list);
+		freelist requirement_list;
+		freelist_create(config.total_size, config.list_type, freelist_requirement, 0, requirement_list);
+
+		memory_requirement = sizeof(dynamic_allocator_state) + freelist_requirement;
+		if (config.backing == DYNAMIC_ALLOCATOR_BACKING_INLINE) {
+			memory_requirement += config.total_size + DYNAMIC_ALLOCATOR_ALIGNMENT;
+		}
 
-		memory_requirement = freelist_requirement + sizeof(dynamic_allocator_state) + total_size;
 		if (!memory) {
 			return true;
 		}
 
+		// NOTE: Placement new, the region count is atomic
 		out_allocator.memory = memory;
-		state = static_cast<dynamic_allocator_state*>(out_allocator.memory);
-		state->total_size = total_size;
-		state->freelist_block = (void*)(((char*)out_allocator.memory) + sizeof(dynamic_allocator_state));
-		state->memory_block = (void*)(((char*)state->freelist_block) + freelist_requirement);
+		dynamic_allocator_state* state = new (memory) dynamic_allocator_state();
+		state->config = config;
+		state->page_size = platform_system_get_page_size();
 
-		freelist_create(total_size, freelist_requirement, state->freelist_block, state->list);
+		void* freelist_block = (void*)(((char*)out_allocator.memory) + sizeof(dynamic_allocator_state));
+		if (!dynamic_allocator_create_region(state, config.total_size, freelist_block, state->regions[0])) {
+			CE_LOG_ERROR("dynamic_allocator_create couldn't setup the first region of %lluB. Create failed.", config.total_size);
+			state->~dynamic_allocator_state();
+			out_allocator.memory = 0;
+			return false;
+		}
 
-		zero_memory(state->memory_block, total_size);
+		state->reserved_size = config.total_size;
+		state->region_count.store(1, std::memory_order_release);
 		return true;
 	}
 
 	bool dynamic_allocator_destroy(dynamic_allocator& allocator) {
 		dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
-		freelist_destroy(state->list);
-		zero_memory(state->memory_block, state->total_size);
-		state->total_size = 0;
+		uint region_count = state->region_count.load(std::memory_order_acquire);
+		for (uint i = 0; i < region_count; ++i) {
+			dynamic_allocator_destroy_region(state, state->regions[i]);
+		}
+
+		state->~dynamic_allocator_state();
 		allocator.memory = 0;
 		return true;
 	}
@@ -53,17 +90,43 @@ namespace caliope {
 	void* dynamic_allocator_allocate(dynamic_allocator& allocator, uint64 size) {
 		if (size) {
 			dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
+			size = (size + DYNAMIC_ALLOCATOR_ALIGNMENT - 1) & ~((uint64)DYNAMIC_ALLOCATOR_ALIGNMENT - 1);
 			uint64 offset = 0;
-			if (freelist_allocate_block(state->list, size, offset)) {
-				void* block = (void*)(((char*)state->memory_block) + offset);
-				return block;
+			uint region_count = state->region_count.load(std::memory_order_relaxed);
+			for (uint i = 0; i < region_count; ++i) {
+				dynamic_allocator_region& region = state->regions[i];
+				if (freelist_free_space(region.list) < size || !freelist_allocate_block(region.list, size, offset)) {
+					continue;
+				}
+
+				if (!dynamic_allocator_commit(state, region, offset + size)) {
+					freelist_free_block(region.list, size, offset);
+					return nullptr;
+				}
+
+				return (void*)(((char*)region.memory_block) + offset);
 			}
-			else {
-				CE_LOG_ERROR("dynamic_allocator_allocate no blocks of memory large enough to allocate from.");
-				uint64 available = freelist_free_space(state->list);
-				CE_LOG_ERROR("Requestd size: %llu, total space available: %llu", size, available);
-				return 0;
+
+			// Every region is full, grows with a new one if the configuration allows it
+			uint64 region_size = size > state->config.total_size ? size : state->config.total_size;
+			region_size = (region_size + state->page_size - 1) & ~(state->page_size - 1);
+			if (region_count < DYNAMIC_ALLOCATOR_MAX_REGIONS && state->reserved_size + region_size <= state->config.max_size) {
+				dynamic_allocator_region& region = state->regions[region_count];
+				if (dynamic_allocator_create_region(state, region_size, 0, region)) {
+					state->reserved_size += region_size;
+					state->region_count.store(region_count + 1, std::memory_order_release);
+					CE_LOG_INFO("dynamic_allocator_allocate added a region of %lluB (%lluB reserved in %u regions).", region_size, state->reserved_size, region_count + 1);
+
+					if (freelist_allocate_block(region.list, size, offset) && dynamic_allocator_commit(state, region, offset + size)) {
+						return (void*)(((char*)region.memory_block) + offset);
+					}
+				}
 			}
+
+			CE_LOG_ERROR("dynamic_allocator_allocate no blocks of memory large enough to allocate from.");
+			uint64 available = dynamic_allocator_free_space(allocator);
+			CE_LOG_ERROR("Requestd size: %llu, total space available: %llu", size, available);
+			return 0;
 		}
 		
 		CE_LOG_ERROR("dynamic_allocator_allocate requires a valid allocator and size.");
@@ -77,23 +140,152 @@ namespace caliope {
 		}
 
 		dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
-		if (block < state->memory_block || block > ((char*)state->memory_block) + state->total_size) {
-			void* end_of_block = (void*)(((char*)state->memory_block) + state->total_size);
-			CE_LOG_ERROR("dynamic_allocator_free trying to release block (0x%p) outside of allocator range (0x%p)-(0x%p)", block, state->memory_block, end_of_block);
-			return false;
-		}
+		size = (size + DYNAMIC_ALLOCATOR_ALIGNMENT - 1) & ~((uint64)DYNAMIC_ALLOCATOR_ALIGNMENT - 1);
+		uint region_count = state->region_count.load(std::memory_order_acquire);
+		for (uint i = 0; i < region_count; ++i) {
+			dynamic_allocator_region& region = state->regions[i];
+			if (block < region.memory_block || block >= (void*)(((char*)region.memory_block) + region.total_size)) {
+				continue;
+			}
 
-		uint64 offset = (((char*)block) - state->memory_block);
-		if (!freelist_free_block(state->list, size, offset)) {
-			CE_LOG_ERROR("dynamic_allocator_free failed.");
-			return false;
+			uint64 offset = (((char*)block) - ((char*)region.memory_block));
+			if (!freelist_free_block(region.list, size, offset)) {
+				CE_LOG_ERROR("dynamic_allocator_free failed.");
+				return false;
+			}
+
+			return true;
 		}
 
-		return true;
+		CE_LOG_ERROR("dynamic_allocator_free trying to release block (0x%p) outside of allocator regions", block);
+		return false;
 	}
 
 	uint64 dynamic_allocator_free_space(dynamic_allocator& allocator) {
 		dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
-		return freelist_free_space(state->list);
+		uint64 free_space = 0;
+		uint region_count = state->region_count.load(std::memory_order_acquire);
+		for (uint i = 0; i < region_count; ++i) {
+			free_space += freelist_free_space(state->regions[i].list);
+		}
+
+		return free_space;
+	}
+
+	void dynamic_allocator_get_metrics(dynamic_allocator& allocator, freelist_metrics& out_metrics) {
+		dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
+		zero_memory(&out_metrics, sizeof(freelist_metrics));
+
+		uint region_count = state->region_count.load(std::memory_order_acquire);
+		for (uint i = 0; i < region_count; ++i) {
+			freelist_metrics region_metrics;
+			freelist_get_metrics(state->regions[i].list, region_metrics);
+			out_metrics.free_space += region_metrics.free_space;
+			out_metrics.hole_count += region_metrics.hole_count;
+			if (region_metrics.largest_free_block > out_metrics.largest_free_block) {
+				out_metrics.largest_free_block = region_metrics.largest_free_block;
+			}
+		}
+	}
+
+	bool dynamic_allocator_owns_block(dynamic_allocator& allocator, void* block) {
+		dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
+		uint region_count = state->region_count.load(std::memory_order_acquire);
+		for (uint i = 0; i < region_count; ++i) {
+			dynamic_allocator_region& region = state->regions[i];
+			if (block >= region.memory_block && block < (void*)(((char*)region.memory_block) + region.total_size)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	uint64 dynamic_allocator_reserved_size(dynamic_allocator& allocator) {
+		dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
+		return state->reserved_size;
+	}
+
+	uint64 dynamic_allocator_committed_size(dynamic_allocator& allocator) {
+		dynamic_allocator_state* state = static_cast<dynamic_allocator_state*>(allocator.memory);
+		uint64 committed_size = 0;
+		uint region_count = state->region_count.load(std::memory_order_acquire);
+		for (uint i = 0; i < region_count; ++i) {
+			committed_size += state->regions[i].committed_size;
+		}
+
+		return committed_size;
+	}
+
+	bool dynamic_allocator_create_region(dynamic_allocator_state* state, uint64 size, void* freelist_block, dynamic_allocator_region& out_region) {
+		uint64 freelist_requirement = 0;
+		freelist_create(size, state->config.list_type, freelist_requirement, 0, out_region.list);
+
+		out_region.total_size = size;
+		out_region.committed_size = 0;
+		out_region.owns_freelist_block = freelist_block == nullptr;
+
+		if (state->config.backing == DYNAMIC_ALLOCATOR_BACKING_VIRTUAL) {
+			out_region.memory_block = platform_system_reserve_memory(size);
+			if (!out_region.memory_block) {
+				CE_LOG_ERROR("dynamic_allocator_create_region couldn't reserve %lluB of address space.", size);
+				return false;
+			}
+		}
+		else if (freelist_block) {
+			// The memory comes right after the freelist in the block given on create
+			uint64 memory_address = (uint64)(((char*)freelist_block) + freelist_requirement);
+			out_region.memory_block = (void*)((memory_address + DYNAMIC_ALLOCATOR_ALIGNMENT - 1) & ~((uint64)DYNAMIC_ALLOCATOR_ALIGNMENT - 1));
+			out_region.committed_size = size;
+		}
+		else {
+			out_region.memory_block = platform_system_allocate_memory(size);
+			if (!out_region.memory_block) {
+				CE_LOG_ERROR("dynamic_allocator_create_region couldn't allocate %lluB.", size);
+				return false;
+			}
+			out_region.committed_size = size;
+		}
+
+		out_region.freelist_block = freelist_block ? freelist_block : platform_system_allocate_memory(freelist_requirement);
+		freelist_create(size, state->config.list_type, freelist_requirement, out_region.freelist_block, out_region.list);
+		return true;
+	}
+
+	void dynamic_allocator_destroy_region(dynamic_allocator_state* state, dynamic_allocator_region& region) {
+		freelist_destroy(region.list);
+
+		if (state->config.backing == DYNAMIC_ALLOCATOR_BACKING_VIRTUAL) {
+			platform_system_release_memory(region.memory_block);
+		}
+		else if (region.owns_freelist_block) {
+			platform_system_free_memory(region.memory_block);
+		}
+
+		if (region.owns_freelist_block) {
+			platform_system_free_memory(region.freelist_block);
+		}
+
+		zero_memory(&region, sizeof(dynamic_allocator_region));
+	}
+
+	bool dynamic_allocator_commit(dynamic_allocator_state* state, dynamic_allocator_region& region, uint64 end_offset) {
+		if (end_offset <= region.committed_size) {
+			return true;
+		}
+
+		// NOTE: The freelists split the free blocks from their start, so the used offsets grow from the beginning
+		// of the region and committing up to the highest one handed out keeps the committed size close to the used one.
+		uint64 granularity = DYNAMIC_ALLOCATOR_COMMIT_GRANULARITY > state->page_size ? DYNAMIC_ALLOCATOR_COMMIT_GRANULARITY : state->page_size;
+		uint64 new_committed_size = (end_offset + granularity - 1) / granularity * granularity;
+		new_committed_size = new_committed_size < region.total_size ? new_committed_size : region.total_size;
+
+		if (!platform_system_commit_memory(((char*)region.memory_block) + region.committed_size, new_committed_size - region.committed_size)) {
+			CE_LOG_ERROR("dynamic_allocator_commit couldn't commit %lluB, the system is out of memory.", new_committed_size - region.committed_size);
+			return false;
+		}
+
+		region.committed_size = new_committed_size;
+		return true;
 	}
-}
\ No newline at end of file
+}
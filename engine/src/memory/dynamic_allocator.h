@@ -2,15 +2,45 @@
 
 #include "defines.h"
 
+#include "containers/freelist.h"
+
 namespace caliope {
+	typedef enum dynamic_allocator_backing {
+		// The memory is part of the block given on create, right after the allocator state
+		DYNAMIC_ALLOCATOR_BACKING_INLINE = 0,
+		// Address space is reserved on create and the pages are committed as the freelist hands them out
+		DYNAMIC_ALLOCATOR_BACKING_VIRTUAL
+	} dynamic_allocator_backing;
+
+	typedef struct dynamic_allocator_configuration {
+		uint64 total_size;
+		freelist_type list_type;
+		dynamic_allocator_backing backing;
+		// When it is bigger than total_size, new regions of at least total_size are added when the current ones are full, up to this size in total
+		uint64 max_size;
+	} dynamic_allocator_configuration;
+
 	typedef struct dynamic_allocator {
 		void* memory;
 	} dynamic_allocator;
 
-	bool dynamic_allocator_create(uint64 total_size, uint64& memory_requirement, void* memory, dynamic_allocator& out_allocator);
-	bool dynamic_allocator_destroy(dynamic_allocator& allocator);
+	CE_API bool dynamic_allocator_create(const dynamic_allocator_configuration& config, uint64& memory_requirement, void* memory, dynamic_allocator& out_allocator);
+	CE_API bool dynamic_allocator_destroy(dynamic_allocator& allocator);
+
+	/**
+	 * @note Every block returned is aligned to 16 bytes.
+	 */
+	CE_API void* dynamic_allocator_allocate(dynamic_allocator& allocator, uint64 size);
+	CE_API bool dynamic_allocator_free(dynamic_allocator& allocator, void* block, uint64 size);
+	CE_API uint64 dynamic_allocator_free_space(dynamic_allocator& allocator);
+	CE_API void dynamic_allocator_get_metrics(dynamic_allocator& allocator, freelist_metrics& out_metrics);
+
+	/**
+	 * @note It can be called while other thread allocates or frees, the regions are never removed until destroy.
+	 */
+	CE_API bool dynamic_allocator_owns_block(dynamic_allocator& allocator, void* block);
 
-	void* dynamic_allocator_allocate(dynamic_allocator& allocator, uint64 size);
-	bool dynamic_allocator_free(dynamic_allocator& allocator, void* block, uint64 size);
-	uint64 dynamic_allocator_free_space(dynamic_allocator& allocator);
-}
\ No newline at end of file
+	/** @brief Gets the size of all the regions, the committed part with a virtual backing. */
+	CE_API uint64 dynamic_allocator_reserved_size(dynamic_allocator& allocator);
+	CE_API uint64 dynamic_allocator_committed_size(dynamic_allocator& allocator);
+}
@@ -0,0 +1,83 @@
+#include "frame_allocator.h"
+
+#include "core/logger.h"
+#include "core/cememory.h"
+#include "memory/linear_allocator.h"
+
+namespace caliope {
+
+	typedef struct frame_allocator_state {
+		linear_allocator arenas[FRAME_ALLOCATOR_FRAMES_IN_FLIGHT];
+		uint current_arena;
+		bool overflow_reported;
+	} frame_allocator_state;
+
+	static std::unique_ptr<frame_allocator_state> state_ptr;
+
+	bool frame_allocator_initialize(frame_allocator_configuration& config) {
+		state_ptr = std::make_unique<frame_allocator_state>();
+
+		if (state_ptr == nullptr) {
+			return false;
+		}
+
+		for (uint i = 0; i < FRAME_ALLOCATOR_FRAMES_IN_FLIGHT; ++i) {
+			if (!linear_allocator_create(config.frame_size, nullptr, state_ptr->arenas[i])) {
+				CE_LOG_ERROR("frame_allocator_initialize couldn't create the arena %u", i);
+				return false;
+			}
+		}
+		state_ptr->current_arena = 0;
+		state_ptr->overflow_reported = false;
+
+		CE_LOG_INFO("Frame allocator initialized.");
+
+		return true;
+	}
+
+	void frame_allocator_shutdown() {
+		for (uint i = 0; i < FRAME_ALLOCATOR_FRAMES_IN_FLIGHT; ++i) {
+			linear_allocator_destroy(state_ptr->arenas[i]);
+		}
+
+		state_ptr.reset();
+		state_ptr = nullptr;
+	}
+
+	void frame_allocator_begin_frame() {
+		state_ptr->current_arena = (state_ptr->current_arena + 1) % FRAME_ALLOCATOR_FRAMES_IN_FLIGHT;
+		linear_allocator_free_all(state_ptr->arenas[state_ptr->current_arena]);
+	}
+
+	void* frame_allocator_allocate(uint64 size, uint64 alignment) {
+		if (state_ptr) {
+			linear_allocator& arena = state_ptr->arenas[state_ptr->current_arena];
+			if (arena.allocated + size + alignment <= arena.total_size) {
+				return linear_allocator_allocate(arena, size, alignment);
+			}
+
+			if (!state_ptr->overflow_reported) {
+				CE_LOG_WARNING("frame_allocator_allocate arena of %lluB exhausted, falling back to the engine heap. Consider increasing the frame size.", arena.total_size);
+				state_ptr->overflow_reported = true;
+			}
+		}
+
+		return allocate_memory(MEMORY_TAG_LINEAR_ALLOCATOR, size);
+	}
+
+	void frame_allocator_free(void* block, uint64 size) {
+		if (!block) {
+			return;
+		}
+
+		if (state_ptr) {
+			for (uint i = 0; i < FRAME_ALLOCATOR_FRAMES_IN_FLIGHT; ++i) {
+				if (linear_allocator_owns_block(state_ptr->arenas[i], block)) {
+					return;
+				}
+			}
+		}
+
+		free_memory(MEMORY_TAG_LINEAR_ALLOCATOR, block, size);
+	}
+}
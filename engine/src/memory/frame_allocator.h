@@ -0,0 +1,54 @@
+#pragma once
+
+#include "defines.h"
+
+namespace caliope {
+
+	// Number of arenas kept alive at once, one per frame that can be in flight.
+	#define FRAME_ALLOCATOR_FRAMES_IN_FLIGHT 2
+
+	typedef struct frame_allocator_configuration {
+		uint64 frame_size;
+	} frame_allocator_configuration;
+
+	bool frame_allocator_initialize(frame_allocator_configuration& config);
+	void frame_allocator_shutdown();
+
+	/**
+	 * @brief Moves to the arena of the next frame and releases everything that was allocated on it. Must be called once per frame, before building the render packets.
+	 * @note The arenas are not thread safe, only the main thread must allocate from them.
+	 */
+	void frame_allocator_begin_frame();
+
+	CE_API void* frame_allocator_allocate(uint64 size, uint64 alignment);
+	// Only releases blocks that did not fit in the arena and came from the engine heap, arena blocks are released on frame_allocator_begin_frame.
+	CE_API void frame_allocator_free(void* block, uint64 size);
+
+	/*
+	 * Stateless allocator to use the STL containers with the frame arena, everything allocated through it only lives until the arena is reused.
+	 */
+	template<typename T>
+	struct frame_stl_allocator {
+		typedef T value_type;
+
+		frame_stl_allocator() noexcept {}
+		template<typename U> frame_stl_allocator(const frame_stl_allocator<U>&) noexcept {}
+
+		T* allocate(size_t count) {
+			return static_cast<T*>(frame_allocator_allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* block, size_t count) noexcept {
+			frame_allocator_free(block, count * sizeof(T));
+		}
+
+		template<typename U> bool operator==(const frame_stl_allocator<U>&) const noexcept { return true; }
+		template<typename U> bool operator!=(const frame_stl_allocator<U>&) const noexcept { return false; }
+	};
+
+	template<typename T>
+	using frame_vector = std::vector<T, frame_stl_allocator<T>>;
+
+	template<typename K, typename V>
+	using frame_unordered_map = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, frame_stl_allocator<std::pair<const K, V>>>;
+}
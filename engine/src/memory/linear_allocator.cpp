@@ -0,0 +1,62 @@
+#include "linear_allocator.h"
+
+#include "core/logger.h"
+#include "core/cememory.h"
+
+namespace caliope {
+
+	bool linear_allocator_create(uint64 total_size, void* memory, linear_allocator& out_allocator) {
+		if (total_size < 1) {
+			CE_LOG_ERROR("linear_allocator_create cannot have a total_size of 0. Create failed.");
+			return false;
+		}
+
+		out_allocator.total_size = total_size;
+		out_allocator.allocated = 0;
+		if (memory) {
+			out_allocator.owns_memory = false;
+			out_allocator.memory = memory;
+		}
+		else {
+			out_allocator.owns_memory = true;
+			out_allocator.memory = allocate_memory(MEMORY_TAG_LINEAR_ALLOCATOR, total_size);
+		}
+
+		return out_allocator.memory != nullptr;
+	}
+
+	void linear_allocator_destroy(linear_allocator& allocator) {
+		if (allocator.owns_memory && allocator.memory) {
+			free_memory(MEMORY_TAG_LINEAR_ALLOCATOR, allocator.memory, allocator.total_size);
+		}
+
+		zero_memory(&allocator, sizeof(linear_allocator));
+	}
+
+	void* linear_allocator_allocate(linear_allocator& allocator, uint64 size, uint64 alignment) {
+		if (!allocator.memory || !size) {
+			CE_LOG_ERROR("linear_allocator_allocate requires a valid allocator and size.");
+			return nullptr;
+		}
+
+		uint64 base = (uint64)allocator.memory;
+		uint64 aligned_offset = ((base + allocator.allocated + (alignment - 1)) & ~(alignment - 1)) - base;
+		if (aligned_offset + size > allocator.total_size) {
+			uint64 remaining = allocator.total_size - allocator.allocated;
+			CE_LOG_ERROR("linear_allocator_allocate tried to allocate %lluB, only %lluB remaining.", size, remaining);
+			return nullptr;
+		}
+
+		allocator.allocated = aligned_offset + size;
+		return (void*)(((char*)allocator.memory) + aligned_offset);
+	}
+
+	void linear_allocator_free_all(linear_allocator& allocator) {
+		// NOTE: The memory is not zeroed on purpose, the blocks are overwritten by their users every frame.
+		allocator.allocated = 0;
+	}
+
+	bool linear_allocator_owns_block(linear_allocator& allocator, void* block) {
+		return block >= allocator.memory && block < (void*)(((char*)allocator.memory) + allocator.total_size);
+	}
+}
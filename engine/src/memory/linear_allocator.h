@@ -0,0 +1,27 @@
+#pragma once
+
+#include "defines.h"
+
+namespace caliope {
+	typedef struct linear_allocator {
+		uint64 total_size;
+		uint64 allocated;
+		void* memory;
+		bool owns_memory;
+	} linear_allocator;
+
+	/**
+	 * @note If memory is null the allocator takes its block from the engine heap and releases it on destroy.
+	 */
+	bool linear_allocator_create(uint64 total_size, void* memory, linear_allocator& out_allocator);
+	void linear_allocator_destroy(linear_allocator& allocator);
+
+	/**
+	 * @brief Bumps the allocator by size bytes. The returned block is aligned to alignment, which must be a power of two.
+	 * @note The block is not zeroed, individual blocks cannot be freed, use linear_allocator_free_all.
+	 */
+	void* linear_allocator_allocate(linear_allocator& allocator, uint64 size, uint64 alignment);
+	void linear_allocator_free_all(linear_allocator& allocator);
+
+	bool linear_allocator_owns_block(linear_allocator& allocator, void* block);
+}
@@ -0,0 +1,101 @@
+#include "pool_allocator.h"
+
+#include "core/logger.h"
+#include "core/cememory.h"
+#include "memory/dynamic_allocator.h"
+
+namespace caliope {
+	#define POOL_ALLOCATOR_ALIGNMENT 16
+
+	// Stored at the beginning of every chunk, so the chunks can be given back on destroy.
+	typedef struct pool_chunk_header {
+		pool_chunk_header* next;
+		void* raw_block;
+		uint64 raw_size;
+	} pool_chunk_header;
+
+	bool pool_allocator_grow(pool_allocator& allocator);
+
+	bool pool_allocator_create(uint64 block_size, uint64 blocks_per_chunk, dynamic_allocator* backing_allocator, pool_allocator& out_allocator) {
+		if (block_size == 0 || blocks_per_chunk == 0 || !backing_allocator) {
+			CE_LOG_ERROR("pool_allocator_create requires a valid block size, number of blocks and backing allocator. Create failed.");
+			return false;
+		}
+
+		// The free list is stored inside the blocks, so they must be able to hold a pointer
+		block_size = block_size < sizeof(void*) ? sizeof(void*) : block_size;
+		out_allocator.block_size = (block_size + (POOL_ALLOCATOR_ALIGNMENT - 1)) & ~((uint64)POOL_ALLOCATOR_ALIGNMENT - 1);
+		out_allocator.blocks_per_chunk = blocks_per_chunk;
+		out_allocator.free_list = nullptr;
+		out_allocator.chunks = nullptr;
+		out_allocator.chunk_count = 0;
+		out_allocator.free_blocks = 0;
+		out_allocator.backing_allocator = backing_allocator;
+
+		return true;
+	}
+
+	void pool_allocator_destroy(pool_allocator& allocator) {
+		pool_chunk_header* chunk = (pool_chunk_header*)allocator.chunks;
+		while (chunk) {
+			pool_chunk_header* next = chunk->next;
+			dynamic_allocator_free(*allocator.backing_allocator, chunk->raw_block, chunk->raw_size);
+			chunk = next;
+		}
+
+		zero_memory(&allocator, sizeof(pool_allocator));
+	}
+
+	void* pool_allocator_allocate(pool_allocator& allocator) {
+		if (!allocator.free_list && !pool_allocator_grow(allocator)) {
+			return nullptr;
+		}
+
+		void* block = allocator.free_list;
+		allocator.free_list = *(void**)block;
+		allocator.free_blocks--;
+		return block;
+	}
+
+	void pool_allocator_free(pool_allocator& allocator, void* block) {
+		if (!block) {
+			return;
+		}
+
+		*(void**)block = allocator.free_list;
+		allocator.free_list = block;
+		allocator.free_blocks++;
+	}
+
+	uint64 pool_allocator_used_space(pool_allocator& allocator) {
+		return (allocator.chunk_count * allocator.blocks_per_chunk - allocator.free_blocks) * allocator.block_size;
+	}
+
+	bool pool_allocator_grow(pool_allocator& allocator) {
+		// The header is padded to keep the first block aligned, plus the slack to align the raw block from the dynamic allocator
+		uint64 header_size = (sizeof(pool_chunk_header) + (POOL_ALLOCATOR_ALIGNMENT - 1)) & ~((uint64)POOL_ALLOCATOR_ALIGNMENT - 1);
+		uint64 raw_size = header_size + allocator.block_size * allocator.blocks_per_chunk + POOL_ALLOCATOR_ALIGNMENT;
+
+		void* raw_block = dynamic_allocator_allocate(*allocator.backing_allocator, raw_size);
+		if (!raw_block) {
+			CE_LOG_ERROR("pool_allocator_grow couldn't get a new chunk of %lluB for blocks of %lluB.", raw_size, allocator.block_size);
+			return false;
+		}
+
+		uint64 aligned_address = ((uint64)raw_block + (POOL_ALLOCATOR_ALIGNMENT - 1)) & ~((uint64)POOL_ALLOCATOR_ALIGNMENT - 1);
+		pool_chunk_header* chunk = (pool_chunk_header*)aligned_address;
+		chunk->raw_block = raw_block;
+		chunk->raw_size = raw_size;
+		chunk->next = (pool_chunk_header*)allocator.chunks;
+		allocator.chunks = chunk;
+		allocator.chunk_count++;
+
+		// Links the new blocks in address order, so consecutive allocations are contiguous
+		char* first_block = ((char*)chunk) + header_size;
+		for (uint64 i = allocator.blocks_per_chunk; i > 0; --i) {
+			pool_allocator_free(allocator, first_block + (i - 1) * allocator.block_size);
+		}
+
+		return true;
+	}
+}
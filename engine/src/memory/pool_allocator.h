@@ -0,0 +1,32 @@
+#pragma once
+
+#include "defines.h"
+
+namespace caliope {
+	struct dynamic_allocator;
+
+	/*
+	 * Fixed size block allocator. The free blocks are linked through their own memory, so allocate and free are O(1).
+	 * When it runs out of blocks it takes a new chunk from the backing dynamic allocator.
+	 */
+	typedef struct pool_allocator {
+		uint64 block_size;
+		uint64 blocks_per_chunk;
+		void* free_list;
+		void* chunks;
+		uint64 chunk_count;
+		uint64 free_blocks;
+		dynamic_allocator* backing_allocator;
+	} pool_allocator;
+
+	/**
+	 * @note block_size is rounded up to a multiple of 16 bytes, every block returned is aligned to 16 bytes.
+	 */
+	bool pool_allocator_create(uint64 block_size, uint64 blocks_per_chunk, dynamic_allocator* backing_allocator, pool_allocator& out_allocator);
+	void pool_allocator_destroy(pool_allocator& allocator);
+
+	void* pool_allocator_allocate(pool_allocator& allocator);
+	void pool_allocator_free(pool_allocator& allocator, void* block);
+
+	uint64 pool_allocator_used_space(pool_allocator& allocator);
+}
@@ -0,0 +1,84 @@
+#include "stack_allocator.h"
+
+#include "core/logger.h"
+#include "core/cememory.h"
+
+namespace caliope {
+
+	static thread_local stack_allocator thread_scratch;
+
+	bool stack_allocator_create(uint64 total_size, void* memory, stack_allocator& out_allocator) {
+		if (total_size < 1) {
+			CE_LOG_ERROR("stack_allocator_create cannot have a total_size of 0. Create failed.");
+			return false;
+		}
+
+		// NOTE: The block is taken here instead of by the linear allocator to keep it uninitialized and under its own tag
+		void* block = memory ? memory : allocate_memory_uninitialized(MEMORY_TAG_STACK_ALLOCATOR, total_size);
+		if (!block) {
+			return false;
+		}
+
+		out_allocator.peak_allocated = 0;
+		out_allocator.owns_memory = memory == nullptr;
+		return linear_allocator_create(total_size, block, out_allocator.linear);
+	}
+
+	void stack_allocator_destroy(stack_allocator& allocator) {
+		if (allocator.linear.allocated) {
+			CE_LOG_WARNING("stack_allocator_destroy called with %lluB still allocated, a scope was not closed.", allocator.linear.allocated);
+		}
+
+		if (allocator.owns_memory && allocator.linear.memory) {
+			free_memory(MEMORY_TAG_STACK_ALLOCATOR, allocator.linear.memory, allocator.linear.total_size);
+		}
+
+		linear_allocator_destroy(allocator.linear);
+		zero_memory(&allocator, sizeof(stack_allocator));
+	}
+
+	void* stack_allocator_allocate(stack_allocator& allocator, uint64 size, uint64 alignment) {
+		void* block = linear_allocator_allocate(allocator.linear, size, alignment);
+		if (block) {
+			allocator.peak_allocated = allocator.linear.allocated > allocator.peak_allocated ? allocator.linear.allocated : allocator.peak_allocated;
+		}
+
+		return block;
+	}
+
+	uint64 stack_allocator_get_free_space(stack_allocator& allocator) {
+		return allocator.linear.total_size - allocator.linear.allocated;
+	}
+
+	stack_allocator_marker stack_allocator_get_marker(stack_allocator& allocator) {
+		return allocator.linear.allocated;
+	}
+
+	void stack_allocator_free_to_marker(stack_allocator& allocator, stack_allocator_marker marker) {
+		if (marker > allocator.linear.allocated) {
+			CE_LOG_ERROR("stack_allocator_free_to_marker marker (%llu) above the top of the stack (%llu), the scopes were closed out of order.", marker, allocator.linear.allocated);
+			return;
+		}
+
+		allocator.linear.allocated = marker;
+	}
+
+	bool stack_allocator_create_thread_scratch(uint64 total_size) {
+		if (thread_scratch.linear.memory) {
+			CE_LOG_WARNING("stack_allocator_create_thread_scratch the thread already has a scratch stack.");
+			return true;
+		}
+
+		return stack_allocator_create(total_size, nullptr, thread_scratch);
+	}
+
+	void stack_allocator_destroy_thread_scratch() {
+		if (thread_scratch.linear.memory) {
+			stack_allocator_destroy(thread_scratch);
+		}
+	}
+
+	stack_allocator* stack_allocator_get_thread_scratch() {
+		return thread_scratch.linear.memory ? &thread_scratch : nullptr;
+	}
+}
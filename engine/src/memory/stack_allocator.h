@@ -0,0 +1,59 @@
+#pragma once
+
+#include "defines.h"
+
+#include "memory/linear_allocator.h"
+
+namespace caliope {
+	// A linear allocator that can also be rolled back to a marker
+	typedef struct stack_allocator {
+		linear_allocator linear;
+		uint64 peak_allocated;
+		bool owns_memory;
+	} stack_allocator;
+
+	// The top of the stack, freeing to it releases everything allocated after it was taken
+	typedef uint64 stack_allocator_marker;
+
+	/**
+	 * @note If memory is null the allocator takes its block from the engine heap and releases it on destroy.
+	 */
+	bool stack_allocator_create(uint64 total_size, void* memory, stack_allocator& out_allocator);
+	void stack_allocator_destroy(stack_allocator& allocator);
+
+	/**
+	 * @brief Pushes size bytes on the stack. The returned block is aligned to alignment, which must be a power of two.
+	 * @note The block is not zeroed. It returns null when the stack is full.
+	 */
+	void* stack_allocator_allocate(stack_allocator& allocator, uint64 size, uint64 alignment);
+	uint64 stack_allocator_get_free_space(stack_allocator& allocator);
+
+	stack_allocator_marker stack_allocator_get_marker(stack_allocator& allocator);
+	void stack_allocator_free_to_marker(stack_allocator& allocator, stack_allocator_marker marker);
+
+	/*
+	 * Frees everything allocated in the stack during its lifetime.
+	 */
+	typedef struct stack_allocator_scope {
+		stack_allocator& allocator;
+		stack_allocator_marker marker;
+
+		stack_allocator_scope(stack_allocator& allocator) : allocator(allocator), marker(stack_allocator_get_marker(allocator)) {}
+		~stack_allocator_scope() { stack_allocator_free_to_marker(allocator, marker); }
+
+		stack_allocator_scope(const stack_allocator_scope&) = delete;
+		stack_allocator_scope& operator=(const stack_allocator_scope&) = delete;
+	} stack_allocator_scope;
+
+	/**
+	 * @brief Creates the scratch stack of the calling thread, meant for temporary data like the one built by the loaders.
+	 * @note Every thread that uses a scratch stack creates its own: the main thread in application_create and each job thread when it starts.
+	 */
+	bool stack_allocator_create_thread_scratch(uint64 total_size);
+	void stack_allocator_destroy_thread_scratch();
+
+	/**
+	 * @brief Gets the scratch stack of the calling thread, null if the thread has not created one.
+	 */
+	CE_API stack_allocator* stack_allocator_get_thread_scratch();
+}
@@ -83,6 +83,22 @@ namespace caliope {
 		return false;
 	}
 
+	bool file_system_read_all_bytes(file_handle& handle, void* out_buffer, uint64 buffer_size, uint64& out_bytes_read) {
+		if (handle.is_valid) {
+			uint64 file_size = platform_system_file_size(handle.handle);
+			if (file_size > buffer_size) {
+				out_bytes_read = 0;
+				return false;
+			}
+
+			out_bytes_read = file_size ? platform_system_file_read_bytes(handle.handle, file_size, (uchar*)out_buffer) : 0;
+
+			return out_bytes_read == file_size;
+		}
+
+		return false;
+	}
+
 	bool file_system_read_all_text(file_handle& handle, std::string& out_text, uint64& out_bytes_read) {
 		if (handle.is_valid) {
 			uint64 file_size = platform_system_file_size(handle.handle);
@@ -32,6 +32,8 @@ namespace caliope {
 	CE_API bool file_system_write_bytes(file_handle& handle, uint64 size, void* data);
 
 	CE_API bool file_system_read_all_bytes(file_handle& handle, std::vector<uchar>& out_bytes, uint64& out_bytes_read);
+	// Reads the whole file into out_buffer, it fails if the file is bigger than buffer_size
+	CE_API bool file_system_read_all_bytes(file_handle& handle, void* out_buffer, uint64 buffer_size, uint64& out_bytes_read);
 
 	CE_API bool file_system_read_all_text(file_handle& handle, std::string& out_text, uint64& out_bytes_read);
 	CE_API bool file_system_read_text_line(file_handle& handle, std::string& out_text, uint64& out_bytes_read);
@@ -23,6 +23,14 @@ namespace caliope {
 	void* platform_system_copy_memory(void* dest, const void* source, uint64 size);
 	void* platform_system_set_memory(void* dest, int value, uint64 size);
 
+	/**
+	 * @brief Reserves address space without backing it with memory. The pages must be committed before using them and the committed pages are zeroed.
+	 */
+	void* platform_system_reserve_memory(uint64 size);
+	bool platform_system_commit_memory(void* block, uint64 size);
+	void platform_system_release_memory(void* block);
+	uint64 platform_system_get_page_size();
+
 
 	bool platform_system_open_file(const char* path, std::any& handle, int mode);
 	void platform_system_close_file(std::any& handle);
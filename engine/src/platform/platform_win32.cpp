@@ -148,6 +148,24 @@ namespace caliope {
 		return memset(dest, value, size);
 	}
 
+	void* platform_system_reserve_memory(uint64 size) {
+		return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+	}
+
+	bool platform_system_commit_memory(void* block, uint64 size) {
+		return VirtualAlloc(block, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+	}
+
+	void platform_system_release_memory(void* block) {
+		VirtualFree(block, 0, MEM_RELEASE);
+	}
+
+	uint64 platform_system_get_page_size() {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+	}
+
 
 	bool platform_system_open_file(const char* path, std::any& handle, int mode) {
 
@@ -18,6 +18,8 @@ namespace caliope {
 		int height;
 		unsigned int maximum_number_entities_per_frame; // Maximum number of entities that the renderer can render each frame
 		unsigned int maximum_number_textures_per_frame; // Maximum number of textures that the renderer can use each frame
+		unsigned long long memory_region_size; // Size of each region of the engine heap, 0 uses the default
+		unsigned long long maximum_memory_size; // Maximum size the engine heap can grow to, 0 uses the default
 
 		bool (*initialize) (game_state& game_state);
 		bool (*update) (game_state& game_state, float delta_time);
@@ -174,7 +174,7 @@ namespace caliope{
 		}
 	}
 
-	bool renderer_draw_frame(std::vector<renderer_view_packet>& packets, float delta_time) {
+	bool renderer_draw_frame(frame_vector<renderer_view_packet>& packets, float delta_time) {
 		
 		if (state_ptr->backend.begin_frame(delta_time)) {
 
@@ -27,7 +27,7 @@ namespace caliope {
 
 	void renderer_on_resized(uint16 width, uint16 height);
 
-	bool renderer_draw_frame(std::vector<renderer_view_packet>& packets, float delta_time);
+	bool renderer_draw_frame(frame_vector<renderer_view_packet>& packets, float delta_time);
 
 	void renderer_texture_create(texture& texture, uchar* pixels);
 	void renderer_texture_create_writeable(texture& texture);
@@ -3,6 +3,7 @@
 #include "defines.h"
 #include "cepch.h"
 #include "resources/resources_types.inl"
+#include "memory/frame_allocator.h"
 
 
 namespace caliope {
@@ -78,6 +79,9 @@ namespace caliope {
 		};
 	};
 
+	// NOTE: The render packets only live during the frame, so their containers are allocated from the frame arena.
+	typedef std::priority_queue<quad_instance_definition, frame_vector<quad_instance_definition>, z_order_comparator> quad_instance_queue;
+
 	typedef struct render_target {
 		std::vector<std::shared_ptr<std::any>> attachments;
 		std::any internal_framebuffer;
@@ -194,20 +198,20 @@ namespace caliope {
 		float delta_time;
 		camera* world_camera;
 		glm::vec4 ambient_color;
-		std::vector<point_light_definition> point_light_definitions;
-		std::unordered_map <std::string, std::priority_queue<quad_instance_definition, std::vector<quad_instance_definition>, z_order_comparator>> sprite_definitions; // Key : shader name, Value: vector of materials
+		frame_vector<point_light_definition> point_light_definitions;
+		frame_unordered_map<name_id, quad_instance_queue> sprite_definitions; // Key : shader id, Value: vector of materials
 	};
 
 	typedef struct render_view_ui_packet {
 		float delta_time;
 		camera* ui_camera;
-		std::unordered_map <std::string, std::priority_queue<quad_instance_definition, std::vector<quad_instance_definition>, z_order_comparator >> quad_definitions; // Key : shader name, Value: vector of materials
+		frame_unordered_map<name_id, quad_instance_queue> quad_definitions; // Key : shader id, Value: vector of materials
 	};
 
 	typedef struct render_view_object_pick_packet {
 		float delta_time;
 		camera* pick_camera;
-		std::unordered_map <std::string, std::priority_queue<quad_instance_definition, std::vector<quad_instance_definition>, z_order_comparator>> sprite_definitions; // Key : shader name, Value: vector of materials
+		frame_unordered_map<name_id, quad_instance_queue> sprite_definitions; // Key : shader id, Value: vector of materials
 	}render_view_object_pick_packet;
 
 	typedef struct render_view {
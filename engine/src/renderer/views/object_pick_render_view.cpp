@@ -32,7 +32,7 @@ namespace caliope {
 		uint binded_textures_count;
 		uint max_textures_per_batch;
 
-		std::string pick_shader;
+		name_id pick_shader;
 
 		uint texture_id;
 
@@ -72,6 +72,8 @@ namespace caliope {
 
 		state_ptr->view_data.at(self.type).regenerate_projection = true;
 
+		// NOTE: 1 is VIEW_TYPE_WORLD_OBJECT_PICK, TODO: Remove this hardcoded line by detecting wich shader use based on the package
+		state_ptr->view_data.at(self.type).pick_shader = name_id_intern((int)self.type == 1 ? "Builtin.WorldObjectPickShader" : "Builtin.UIObjectPickShader");
 	}
 
 	void object_pick_render_view_on_destroy(render_view& self) {
@@ -96,7 +98,7 @@ namespace caliope {
 	}
 
 	bool object_pick_render_view_on_build_package(render_view& self, renderer_view_packet& out_packet, std::vector<std::any>& variadic_data) {
-		std::vector<quad_instance_definition>& quads = std::any_cast<std::vector<quad_instance_definition>>(variadic_data[0]);
+		frame_vector<quad_instance_definition>& quads = *std::any_cast<frame_vector<quad_instance_definition>*>(variadic_data[0]);
 		camera* cam = std::any_cast<camera*>(variadic_data[1]);
 		float delta_time = std::any_cast<float>(variadic_data[2]);
 
@@ -104,21 +106,21 @@ namespace caliope {
 		object_pick_packet.delta_time = delta_time;
 		object_pick_packet.pick_camera = cam;
 		
-		state_ptr->view_data.at(self.type).pick_shader = (int)out_packet.view_type == 1 ? "Builtin.WorldObjectPickShader" : "Builtin.UIObjectPickShader"; // TODO: Remove this hardcoded line by detecting wich shader use based on the package. Note 1 correspond to VIEW_TYPE_WORLD_OBJECT_PICK
-
-		for (uint index = 0; index < quads.size(); ++index) {
-			object_pick_packet.sprite_definitions.insert({ state_ptr->view_data.at(self.type).pick_shader , {} });
-			object_pick_packet.sprite_definitions.at(state_ptr->view_data.at(self.type).pick_shader).push(quads[index]);
+		if (!quads.empty()) {
+			quad_instance_queue& pick_sprites = object_pick_packet.sprite_definitions[state_ptr->view_data.at(self.type).pick_shader];
+			for (uint index = 0; index < quads.size(); ++index) {
+				pick_sprites.push(quads[index]);
+			}
 		}
 
-		out_packet.view_packet = object_pick_packet;
+		out_packet.view_packet = std::move(object_pick_packet);
 
 		return true;
 	}
 
 	bool object_pick_render_view_on_render(render_view& self, std::any& packet, uint render_target_index) {
 
-		render_view_object_pick_packet& object_pick_packet = std::any_cast<render_view_object_pick_packet>(packet);
+		render_view_object_pick_packet& object_pick_packet = std::any_cast<render_view_object_pick_packet&>(packet);
 
 
 
@@ -141,11 +143,11 @@ namespace caliope {
 			state_ptr->view_data.at(self.type).regenerate_projection = false;
 		}
 
-		shader* shader = shader_system_adquire(std::string(state_ptr->view_data.at(self.type).pick_shader));
+		shader* shader = shader_system_adquire(state_ptr->view_data.at(self.type).pick_shader);
 		
 		// Groups the materials and transforms by shader. This is to batch maximum information in a single drawcall
 		//for (auto [shader_name, material_name] : packet.quad_materials) {
-		for (auto [shader_name, sprites] : object_pick_packet.sprite_definitions) {
+		for (auto& [shader_id, sprites] : object_pick_packet.sprite_definitions) {
 
 			renderer_shader_use(*shader);
 			uint number_of_instances = 0;
@@ -186,9 +188,8 @@ namespace caliope {
 				uint diffuse_id = 0;
 		
 
-				// TODO: INSTEAD OF COMPARE NAMES COMPARE RANDOM NUMBERS OR HASHED NAMES FOR BETTER PERFORMANCE
 				// TODO: DRY
-				if (state_ptr->view_data.at(self.type).batch_textures[aux_diffuse_texture->pick_render_batch_index] && state_ptr->view_data.at(self.type).batch_textures[aux_diffuse_texture->pick_render_batch_index]->name == aux_diffuse_texture->name) {
+				if (state_ptr->view_data.at(self.type).batch_textures[aux_diffuse_texture->pick_render_batch_index] && state_ptr->view_data.at(self.type).batch_textures[aux_diffuse_texture->pick_render_batch_index]->id == aux_diffuse_texture->id) {
 					diffuse_id = aux_diffuse_texture->pick_render_batch_index;
 				}
 				else {
@@ -226,7 +227,6 @@ namespace caliope {
 			
 			renderer_set_descriptor_ssbo(state_ptr->view_data.at(self.type).pick_objects.data(), sizeof(shader_pick_quad_properties)* number_of_instances, 1, *shader, 1);
 			
-			std::vector<texture*> batch_textures = state_ptr->view_data.at(self.type).batch_textures;
 			renderer_set_descriptor_sampler(state_ptr->view_data.at(self.type).batch_textures, 2, *shader);// TODO: Reuse the already existing textures from the world view, to avoid to do the internal for loop of this function
 
 
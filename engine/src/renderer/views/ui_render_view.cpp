@@ -72,7 +72,7 @@ namespace caliope {
 
 	bool ui_render_view_on_build_package(render_view& self, renderer_view_packet& out_packet, std::vector<std::any>& variadic_data) {
 
-		std::vector<quad_instance_definition>& quads = std::any_cast<std::vector<quad_instance_definition>>(variadic_data[0]);
+		frame_vector<quad_instance_definition>& quads = *std::any_cast<frame_vector<quad_instance_definition>*>(variadic_data[0]);
 		camera* cam = std::any_cast<camera*>(variadic_data[1]);
 		float delta_time = std::any_cast<float>(variadic_data[2]);
 
@@ -82,20 +82,17 @@ namespace caliope {
 		ui_packet.ui_camera = cam;
 
 		for (uint index = 0; index < quads.size(); ++index) {
-			ui_packet.quad_definitions.insert({ quads[index].shader->name, {}});
-			ui_packet.quad_definitions.at(
-				quads[index].shader->name
-			).push(quads[index]);
+			ui_packet.quad_definitions[quads[index].shader->id].push(quads[index]);
 		}
 		
 		
-		out_packet.view_packet = ui_packet;
+		out_packet.view_packet = std::move(ui_packet);
 
 		return true;
 	}
 
 	bool ui_render_view_on_render(render_view& self, std::any& packet, uint render_target_index) {
-		render_view_ui_packet& ui_packet = std::any_cast<render_view_ui_packet>(packet);
+		render_view_ui_packet& ui_packet = std::any_cast<render_view_ui_packet&>(packet);
 
 		if (!renderer_renderpass_begin(self.renderpass, render_target_index, glm::vec2(), glm::vec2())) {
 			CE_LOG_ERROR("ui_render_view_on_render failed renderpass begin. Application shutting down");
@@ -109,9 +106,9 @@ namespace caliope {
 
 		// Groups the materials and transforms by shader. This is to batch maximum information in a single drawcall
 		//for (auto [shader_name, material_name] : packet.quad_materials) {
-		for (auto [shader_name, sprites] : ui_packet.quad_definitions) {
+		for (auto& [shader_id, sprites] : ui_packet.quad_definitions) {
 
-			shader* shader = shader_system_adquire(std::string(shader_name));
+			shader* shader = shader_system_adquire(shader_id);
 			renderer_shader_use(*shader);
 
 			uint number_of_instances = 0;
@@ -122,7 +119,7 @@ namespace caliope {
 				texture* aux_diffuse_texture =  sprite.diffuse_texture ?  sprite.diffuse_texture : material_system_get_default()->diffuse_texture;
 				uint diffuse_id = 0;
 
-				if (state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index]->name == aux_diffuse_texture->name) {
+				if (state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index]->id == aux_diffuse_texture->id) {
 					diffuse_id = aux_diffuse_texture->normal_render_batch_index;
 				}
 				else {
@@ -77,8 +77,8 @@ namespace caliope {
 
 	bool world_render_view_on_build_package(render_view& self, renderer_view_packet& out_packet, std::vector<std::any>& variadic_data) {
 
-		std::vector<quad_instance_definition>& quads = std::any_cast<std::vector<quad_instance_definition>>(variadic_data[0]);
-		std::vector<point_light_definition>& lights = std::any_cast<std::vector<point_light_definition>>(variadic_data[1]);
+		frame_vector<quad_instance_definition>& quads = *std::any_cast<frame_vector<quad_instance_definition>*>(variadic_data[0]);
+		frame_vector<point_light_definition>& lights = *std::any_cast<frame_vector<point_light_definition>*>(variadic_data[1]);
 		camera* cam = std::any_cast<camera*>(variadic_data[2]);
 		float delta_time = std::any_cast<float>(variadic_data[3]);
 
@@ -89,10 +89,7 @@ namespace caliope {
 		world_packet.world_camera = cam;
 
 		for (uint index = 0; index < quads.size(); ++index) {
-			world_packet.sprite_definitions.insert({ quads[index].shader->name, {}});
-			world_packet.sprite_definitions.at(
-				quads[index].shader->name
-			).push(quads[index]);
+			world_packet.sprite_definitions[quads[index].shader->id].push(quads[index]);
 		}
 
 		for (uint index = 0; index < lights.size(); ++index) {
@@ -102,14 +99,14 @@ namespace caliope {
 			}
 		}
 
-		out_packet.view_packet = world_packet;
+		out_packet.view_packet = std::move(world_packet);
 
 		return true;
 	}
 
 	bool world_render_view_on_render(render_view& self, std::any& packet, uint render_target_index) {
 
-		render_view_world_packet& world_packet = std::any_cast<render_view_world_packet>(packet);
+		render_view_world_packet& world_packet = std::any_cast<render_view_world_packet&>(packet);
 
 		if (!renderer_renderpass_begin(self.renderpass, render_target_index, glm::vec2(), glm::vec2())) {
 			CE_LOG_ERROR("world_render_view_on_render failed renderpass begin. Application shutting down");
@@ -125,9 +122,9 @@ namespace caliope {
 
 		// Groups the materials and transforms by shader. This is to batch maximum information in a single drawcall
 		//for (auto [shader_name, material_name] : packet.quad_materials) {
-		for (auto [shader_name, sprites] : world_packet.sprite_definitions) {
+		for (auto& [shader_id, sprites] : world_packet.sprite_definitions) {
 
-			shader* shader = shader_system_adquire(std::string(shader_name));
+			shader* shader = shader_system_adquire(shader_id);
 			renderer_shader_use(*shader);
 
 			uint number_of_instances = 0;
@@ -172,9 +169,8 @@ namespace caliope {
 				uint specula_id = 0;
 				uint normal_id = 0;
 
-				// TODO: INSTEAD OF COMPARE NAMES COMPARE RANDOM NUMBERS OR HASHED NAMES FOR BETTER PERFORMANCE
 				// TODO: DRY
-				if (state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index]->name == aux_diffuse_texture->name) {
+				if (state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_diffuse_texture->normal_render_batch_index]->id == aux_diffuse_texture->id) {
 					diffuse_id = aux_diffuse_texture->normal_render_batch_index;
 				}
 				else {
@@ -190,7 +186,7 @@ namespace caliope {
 					state_ptr->texture_id++;
 				}
 
-				if (state_ptr->batch_textures[aux_specular_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_specular_texture->normal_render_batch_index]->name == aux_specular_texture->name) {
+				if (state_ptr->batch_textures[aux_specular_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_specular_texture->normal_render_batch_index]->id == aux_specular_texture->id) {
 					specula_id = aux_specular_texture->normal_render_batch_index;
 				}
 				else {
@@ -206,7 +202,7 @@ namespace caliope {
 					state_ptr->texture_id++;
 				}
 
-				if (state_ptr->batch_textures[aux_normal_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_normal_texture->normal_render_batch_index]->name == aux_normal_texture->name) {
+				if (state_ptr->batch_textures[aux_normal_texture->normal_render_batch_index] && state_ptr->batch_textures[aux_normal_texture->normal_render_batch_index]->id == aux_normal_texture->id) {
 					normal_id = aux_normal_texture->normal_render_batch_index;
 				}
 				else {
@@ -257,8 +253,6 @@ namespace caliope {
 				ubo_frag.point_lights[i] = world_packet.point_light_definitions[i];
 			}
 			renderer_set_descriptor_ubo(&ubo_frag, sizeof(uniform_fragment_buffer_object), 3, *shader, 1);
-			std::vector<texture*> batch_textures = state_ptr->batch_textures;
-			std::vector<shader_world_quad_properties> d = state_ptr->quads;
 			renderer_apply_descriptors(*shader);
 			renderer_draw_geometry(number_of_instances, *geometry_system_get_quad());
 
@@ -4,58 +4,155 @@
 #include "core/logger.h"
 #include "core/cememory.h"
 #include "core/cestring.h"
+#include "memory/stack_allocator.h"
 #include "systems/resource_system.h"
 #include "platform/file_system.h"
 
 namespace caliope {
 
+	// The components are staged one after the other in the scratch stack of the thread,
+	// when it runs out they are moved to a heap block that grows until the whole file is parsed
+	typedef struct entity_loader_staging {
+		char* begin;
+		uint64 size;
+		uint64 capacity;
+		bool on_heap;
+	} entity_loader_staging;
+
+	#define ENTITY_LOADER_STAGING_MIN_CAPACITY KIBIBYTES(64)
+
+	static char* staging_push(stack_allocator* scratch, entity_loader_staging& staging, uint64 size) {
+		// NOTE: The scratch blocks are aligned the same way, so the offsets do not change when the components move to the heap
+		uint64 offset = (staging.size + (MEMORY_DEFAULT_ALIGNMENT - 1)) & ~(MEMORY_DEFAULT_ALIGNMENT - 1);
+		if (!staging.on_heap && scratch && stack_allocator_get_free_space(*scratch) >= size + MEMORY_DEFAULT_ALIGNMENT) {
+			char* block = (char*)stack_allocator_allocate(*scratch, size, MEMORY_DEFAULT_ALIGNMENT);
+			staging.begin = staging.begin ? staging.begin : block;
+			staging.size = offset + size;
+			return block;
+		}
+
+		if (offset + size > staging.capacity) {
+			uint64 capacity = staging.capacity ? staging.capacity : ENTITY_LOADER_STAGING_MIN_CAPACITY;
+			while (capacity < offset + size) {
+				capacity *= 2;
+			}
+
+			char* block = (char*)allocate_memory_uninitialized(MEMORY_TAG_LOADER, capacity);
+			if (!block) {
+				return nullptr;
+			}
+			if (staging.size) {
+				copy_memory(block, staging.begin, staging.size);
+			}
+			if (staging.on_heap) {
+				free_memory(MEMORY_TAG_LOADER, staging.begin, staging.capacity);
+			}
+			staging.begin = block;
+			staging.capacity = capacity;
+			staging.on_heap = true;
+		}
+
+		staging.size = offset + size;
+		return staging.begin + offset;
+	}
+
 	bool entity_loader_load(std::string* file, resource* out_resource) {
 		file_handle text_file;
 		if (!file_system_open(*file, FILE_MODE_READ, text_file)) {
 			CE_LOG_ERROR("Couldnt open %s", file->c_str());
 			return false;
 		}
-		scene_resource_data scene_config = {};
-		std::string text;
-		uint64 read_bytes;
-		file_system_read_all_text(text_file, text, read_bytes);
 
-		std::istringstream stream(text.c_str());
-		std::string line;
+		// NOTE: The text and the component data are built in the scratch stack of the thread when it has room,
+		// only the final block with the data of every component is always taken from the heap.
+		stack_allocator* scratch = stack_allocator_get_thread_scratch();
+		stack_allocator_marker scratch_marker = scratch ? stack_allocator_get_marker(*scratch) : 0;
 
-		sprite_frame_resource_data sprite_frame_data;
+		uint64 file_size = 0;
+		uint64 read_bytes = 0;
+		file_system_size(text_file, file_size);
+		bool text_on_heap = !scratch || stack_allocator_get_free_space(*scratch) < file_size + 1;
+		char* text = text_on_heap ? (char*)allocate_memory_uninitialized(MEMORY_TAG_LOADER, file_size + 1) : (char*)stack_allocator_allocate(*scratch, file_size + 1, 1);
+		if (!text || !file_system_read_all_bytes(text_file, text, file_size, read_bytes)) {
+			CE_LOG_ERROR("entity_loader_load couldnt read %s", file->c_str());
+			if (text && text_on_heap) {
+				free_memory(MEMORY_TAG_LOADER, text, file_size + 1);
+			}
+			if (scratch) {
+				stack_allocator_free_to_marker(*scratch, scratch_marker);
+			}
+			file_system_close(text_file);
+			return false;
+		}
+		text[read_bytes] = '\0';
+		file_system_close(text_file);
+
+		scene_resource_data scene_config = {};
 
 		uint entity_index = -1;
-		uint component_index = 0;
 		uint compt_id = 0;
 		uint component_size = 0;
 		uint offset_component_data = 0;
 
-		while (std::getline(stream, line)) {//TODO: Use the function read file by line instead of store the whole text
-			if (line == "" || line.begin()[0] == '#') {
+		// components_data keeps the offsets from the first staged component until the final block exists
+		entity_loader_staging staging = {};
+		char* component_data = nullptr;
+		bool loaded = true;
+
+		char* cursor = text;
+		while (*cursor) {
+			// Splits the text in place, the line ends where the next one begins
+			char* line = cursor;
+			char* line_end = strchr(line, '\n');
+			if (line_end) {
+				*line_end = '\0';
+				cursor = line_end + 1;
+			}
+			else {
+				cursor = line + strlen(line);
+			}
+
+			while (*line == ' ' || *line == '\t') {
+				++line;
+			}
+			if (*line == '\0' || *line == '#' || *line == '\r') {
 				continue;
 			}
-			string_trim_character(&line, '\r');
 
-			std::string field, value;
-			string_split(&line, &field, &value, '=');
-			string_trim_character(&field, ' ');
-			string_trim_character(&field, '\t');
+			char* line_last = line + strlen(line);
+			while (line_last > line && (line_last[-1] == '\r' || line_last[-1] == ' ' || line_last[-1] == '\t')) {
+				*--line_last = '\0';
+			}
+
+			char* field = line;
+			char* value = strchr(line, '=');
+			if (value) {
+				*value++ = '\0';
+			}
+			else {
+				value = line_last;
+			}
+
+			char* field_last = field + strlen(field);
+			while (field_last > field && (field_last[-1] == ' ' || field_last[-1] == '\t')) {
+				*--field_last = '\0';
+			}
 
-			if (strings_equali(&field, &std::string("name"))) {
-				copy_memory(&scene_config.name, value.c_str(), sizeof(char) * MAX_NAME_LENGTH);
+			if (strings_equali(field, "name")) {
+				uint64 name_length = strlen(value);
+				name_length = name_length < MAX_NAME_LENGTH - 1 ? name_length : MAX_NAME_LENGTH - 1;
+				copy_memory(scene_config.name.data(), value, sizeof(char) * name_length);
 			}
-			else if (strings_equali(&field, &std::string("entity_id")))
+			else if (strings_equali(field, "entity_id"))
 			{
 				uint entity_id;
-				string_to_uint(&value, &entity_id);
+				string_to_uint(value, &entity_id);
 				scene_config.entity_ids.push_back(entity_id);
 			}
-			else if (strings_equali(&field, &std::string("archetype_id")))
+			else if (strings_equali(field, "archetype_id"))
 			{
 				uint archetype_id;
-				component_index = 0;
-				string_to_uint(&value, &archetype_id);
+				string_to_uint(value, &archetype_id);
 				scene_config.archetypes.push_back((archetype)archetype_id);
 				scene_config.components.push_back(std::vector<component_id>());
 				scene_config.components_data_types.push_back(std::vector<std::vector<component_data_type>>());
@@ -63,102 +160,131 @@ namespace caliope {
 				entity_index++;
 
 			}
-			else if (strings_equali(&field, &std::string("component_id")))
+			else if (strings_equali(field, "component_id"))
 			{
-				string_to_uint(&value, &compt_id);
+				string_to_uint(value, &compt_id);
 				scene_config.components[entity_index].push_back((component_id)compt_id);
 
 				scene_config.components_data_types[entity_index].push_back(std::vector<component_data_type>());
 
 			}
-			else if (strings_equali(&field, &std::string("component_size")))
+			else if (strings_equali(field, "component_size"))
 			{
-				
-				string_to_uint(&value, &component_size);
+				string_to_uint(value, &component_size);
 				scene_config.components_sizes[(component_id)compt_id] = component_size;
 
-				scene_config.components_data[entity_index].push_back(allocate_memory(MEMORY_TAG_LOADER, component_size));
+				component_data = staging_push(scratch, staging, component_size);
+				if (!component_data) {
+					CE_LOG_ERROR("entity_loader_load run out of memory loading %s", file->c_str());
+					loaded = false;
+					break;
+				}
+				zero_memory(component_data, component_size);
+
+				scene_config.components_data[entity_index].push_back((void*)(component_data - staging.begin));
 			}
-			else if (strings_equali(&field, &std::string("end_component")))
+			else if (strings_equali(field, "end_component"))
 			{
-				component_index++;
 				offset_component_data = 0;
 			}
-			else if (strings_equali(&field, &std::string("string")))
+			else if (strings_equali(field, "string"))
 			{
-				char* memory_dir = (char*)scene_config.components_data[entity_index][component_index];
-				copy_memory(memory_dir + offset_component_data, value.c_str(), sizeof(char) * MAX_NAME_LENGTH);
+				uint64 string_length = strlen(value);
+				string_length = string_length < MAX_NAME_LENGTH - 1 ? string_length : MAX_NAME_LENGTH - 1;
+				copy_memory(component_data + offset_component_data, value, sizeof(char) * string_length);
 				offset_component_data += sizeof(char) * MAX_NAME_LENGTH;
 
-				scene_config.components_data_types[entity_index][component_index].push_back(COMPONENT_DATA_TYPE_STRING);
+				scene_config.components_data_types[entity_index].back().push_back(COMPONENT_DATA_TYPE_STRING);
 			}
-			else if (strings_equali(&field, &std::string("vector4")))
+			else if (strings_equali(field, "vector4"))
 			{
 				glm::vec4 vec4;
-				string_to_vec4(&value, &vec4);
-				char* memory_dir = (char*)scene_config.components_data[entity_index][component_index];
-				copy_memory(memory_dir + offset_component_data, &vec4, sizeof(glm::vec4));
+				string_to_vec4(value, &vec4);
+				copy_memory(component_data + offset_component_data, &vec4, sizeof(glm::vec4));
 				offset_component_data += sizeof(glm::vec4);
 
-				scene_config.components_data_types[entity_index][component_index].push_back(COMPONENT_DATA_TYPE_VEC4);
+				scene_config.components_data_types[entity_index].back().push_back(COMPONENT_DATA_TYPE_VEC4);
 
 			}
-			else if (strings_equali(&field, &std::string("vector3")))
+			else if (strings_equali(field, "vector3"))
 			{
 				glm::vec3 vec3;
-				string_to_vec3(&value, &vec3);
-				char* memory_dir = (char*)scene_config.components_data[entity_index][component_index];
-				copy_memory(memory_dir + offset_component_data, &vec3, sizeof(glm::vec3));
+				string_to_vec3(value, &vec3);
+				copy_memory(component_data + offset_component_data, &vec3, sizeof(glm::vec3));
 				offset_component_data += sizeof(glm::vec3);
 
-				scene_config.components_data_types[entity_index][component_index].push_back(COMPONENT_DATA_TYPE_VEC3);
+				scene_config.components_data_types[entity_index].back().push_back(COMPONENT_DATA_TYPE_VEC3);
 			}
-			else if (strings_equali(&field, &std::string("vector2")))
+			else if (strings_equali(field, "vector2"))
 			{
 				glm::vec2 vec2;
-				string_to_vec2(&value, &vec2);
-				char* memory_dir = (char*)scene_config.components_data[entity_index][component_index];
-				copy_memory(memory_dir + offset_component_data, &vec2, sizeof(glm::vec2));
+				string_to_vec2(value, &vec2);
+				copy_memory(component_data + offset_component_data, &vec2, sizeof(glm::vec2));
 				offset_component_data += sizeof(glm::vec2);
 
-				scene_config.components_data_types[entity_index][component_index].push_back(COMPONENT_DATA_TYPE_VEC2);
+				scene_config.components_data_types[entity_index].back().push_back(COMPONENT_DATA_TYPE_VEC2);
 			}
-			else if (strings_equali(&field, &std::string("float")))
+			else if (strings_equali(field, "float"))
 			{
 				float f;
-				string_to_float(&value, &f);
-				char* memory_dir = (char*)scene_config.components_data[entity_index][component_index];
-				copy_memory(memory_dir + offset_component_data, &f, sizeof(float));
+				string_to_float(value, &f);
+				copy_memory(component_data + offset_component_data, &f, sizeof(float));
 				offset_component_data += sizeof(float);
 
-				scene_config.components_data_types[entity_index][component_index].push_back(COMPONENT_DATA_TYPE_FLOAT);
+				scene_config.components_data_types[entity_index].back().push_back(COMPONENT_DATA_TYPE_FLOAT);
 			}
-			else if (strings_equali(&field, &std::string("integer")))
+			else if (strings_equali(field, "integer"))
 			{
 				uint i;
-				string_to_uint(&value, &i);
-				char* memory_dir = (char*)scene_config.components_data[entity_index][component_index];
-				copy_memory(memory_dir + offset_component_data, &i, sizeof(uint));
+				string_to_uint(value, &i);
+				copy_memory(component_data + offset_component_data, &i, sizeof(uint));
 				offset_component_data += sizeof(uint);
 
-				scene_config.components_data_types[entity_index][component_index].push_back(COMPONENT_DATA_TYPE_UINT);
+				scene_config.components_data_types[entity_index].back().push_back(COMPONENT_DATA_TYPE_UINT);
 			}
 		}
 
-		out_resource->data = scene_config;
-		file_system_close(text_file);
+		if (text_on_heap) {
+			free_memory(MEMORY_TAG_LOADER, text, file_size + 1);
+		}
 
+		// Moves the staged components to their own block, unless they already are in one, and turns the offsets into pointers
+		if (loaded && staging.begin) {
+			if (staging.on_heap) {
+				scene_config.components_block = staging.begin;
+				scene_config.components_block_size = staging.capacity;
+			}
+			else {
+				scene_config.components_block_size = staging.size;
+				scene_config.components_block = allocate_memory_uninitialized(MEMORY_TAG_LOADER, scene_config.components_block_size);
+				copy_memory(scene_config.components_block, staging.begin, scene_config.components_block_size);
+			}
+
+			for (uint i = 0; i < scene_config.components_data.size(); ++i) {
+				for (uint j = 0; j < scene_config.components_data[i].size(); ++j) {
+					scene_config.components_data[i][j] = ((char*)scene_config.components_block) + (uint64)scene_config.components_data[i][j];
+				}
+			}
+		}
+		else if (staging.on_heap) {
+			free_memory(MEMORY_TAG_LOADER, staging.begin, staging.capacity);
+		}
 
-		return true;
+		if (scratch) {
+			stack_allocator_free_to_marker(*scratch, scratch_marker);
+		}
+
+		if (loaded) {
+			out_resource->data = scene_config;
+		}
+
+		return loaded;
 	}
 
 	void entity_loader_unload(resource* resource) {
-		scene_resource_data scene_data = std::any_cast<scene_resource_data>(resource->data);
-		for (uint i = 0; i < scene_data.components_data.size(); ++i) {
-			for (uint j = 0; j < scene_data.components_data[i].size(); ++j) {
-				uint component_size = scene_data.components_sizes[scene_data.components[i][j]];
-				free_memory(MEMORY_TAG_LOADER, scene_data.components_data[i][j], component_size);
-			}
+		scene_resource_data& scene_data = std::any_cast<scene_resource_data&>(resource->data);
+		if (scene_data.components_block) {
+			free_memory(MEMORY_TAG_LOADER, scene_data.components_block, scene_data.components_block_size);
 		}
 
 		resource->data.reset();
@@ -28,6 +28,10 @@ namespace caliope {
 
 		for (uint entity_index = 0; entity_index < scene_data->entities.size(); ++entity_index) {
 			uint entity = scene_data->entities[entity_index];
+			if (!ecs_system_is_entity_alive(entity)) {
+				CE_LOG_WARNING("entity_parser_write skipping the stale entity %u", entity);
+				continue;
+			}
 			file_system_write_text(text_file, "entity_id=" + std::to_string(entity) + "\n");
 			file_system_write_text(text_file, "archetype_id=" + std::to_string(ecs_system_get_entity_archetype(entity)) + "\n");
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "defines.h"
+#include "core/name_id.h"
 #include "math/transform.h"
 #include "systems/ecs_system.h"// TODO: Move archetypes to other place, avoid to include the whole system
 #include "components/components.inl"
@@ -129,9 +130,12 @@ namespace caliope {
 		std::vector<archetype> archetypes;
 		std::vector<std::vector<component_id>> components;
 		std::vector< std::vector<std::vector<component_data_type>>> components_data_types; // Note: entity_id < component_id < data_type > > >
-		std::vector<std::vector<void*>> components_data;
+		std::vector<std::vector<void*>> components_data; // Note: Points inside components_block
 
 		std::unordered_map<component_id, uint> components_sizes;
+
+		void* components_block;
+		uint64 components_block_size;
 	}scene_resource_data;
 
 	typedef struct text_font_resource_data {
@@ -165,6 +169,7 @@ namespace caliope {
 
 	typedef struct texture {
 		std::string name;
+		name_id id;
 		uint normal_render_batch_index; // Position that occupies into the render world batch texture array
 		uint pick_render_batch_index; // Position that occupies into the render ui batch texture array
 		uint width;
@@ -178,11 +183,13 @@ namespace caliope {
 
 	typedef struct shader {
 		std::string name;
+		name_id id;
 		std::any internal_data;
 	} shader;
 
 	typedef struct material {
 		std::string name;
+		name_id id;
 		glm::vec3 diffuse_color;
 		float shininess_intensity;
 		float shininess_sharpness;
@@ -195,11 +202,13 @@ namespace caliope {
 
 	typedef struct sprite_frame {
 		std::string material_name;
+		name_id material_id;
 		std::array<glm::vec2, 4> texture_region;
 	};
 
 	typedef struct sprite_animation {
 		std::string name;
+		name_id id;
 		std::vector<sprite_frame> frames;
 		bool is_looping;
 		bool is_playing;
@@ -27,7 +27,7 @@ namespace caliope {
 		resource r;
 		if (!resource_system_load(name, RESOURCE_TYPE_AUDIO, r)) {
 			CE_LOG_ERROR("audio_system_create_emmiter couldnt load file audio clip");
-			return 0; // TODO: Devolver un audio por defecto? osea un audio que siempre esta cargado en el 0
+			return INVALID_ID; // TODO: Devolver un audio por defecto?
 		}
 		audio_clip_resource_data clip_data = std::any_cast<audio_clip_resource_data>(r.data);
 		
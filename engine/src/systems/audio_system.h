@@ -8,6 +8,7 @@ namespace caliope {
 	void audio_system_shutdown();
 
 	// Load a audio file returns and id. The name must be only the asset name
+	// The id of a destroyed emmiter is stale, the other functions ignore it. Returns INVALID_ID if the emmiter couldn't be created
 	CE_API uint audio_system_create_emmiter(std::string& name);
 	CE_API void audio_system_destroy_emmiter(uint emmiter_id);
 
@@ -0,0 +1,263 @@
+#include "ecs_command_buffer.h"
+#include "core/cememory.h"
+#include "core/logger.h"
+
+#include <algorithm>
+
+namespace caliope {
+
+	// The payloads are padded so the header of the next component of a spawn is aligned
+	#define ECS_COMMAND_DATA_ALIGNMENT 4
+
+	typedef struct ecs_command_spawn_component {
+		component_id component;
+		uint size;
+	} ecs_command_spawn_component;
+
+	typedef struct ecs_command_sort_entry {
+		// 0 for the spawns, 1 for the commands of the existing entities
+		uint group;
+		uint archetype;
+		uint entity;
+		uint command;
+	} ecs_command_sort_entry;
+
+	static uint align_data_size(uint size) {
+		return (size + ECS_COMMAND_DATA_ALIGNMENT - 1) & ~(ECS_COMMAND_DATA_ALIGNMENT - 1);
+	}
+
+	// Must be called with the mutex of the buffer locked, returns where the payload starts
+	static uint reserve_data(ecs_command_buffer& buffer, uint size) {
+		uint offset = (uint)buffer.data.size();
+		buffer.data.resize(offset + align_data_size(size));
+		return offset;
+	}
+
+	static void push_command(ecs_command_buffer& buffer, ecs_command_type type, uint entity, uint argument, const void* data, uint data_size) {
+		ecs_command command;
+		command.type = type;
+		command.entity = entity;
+		command.argument = argument;
+		command.data_offset = 0;
+		command.data_size = data_size;
+
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		if (data_size) {
+			command.data_offset = reserve_data(buffer, data_size);
+			copy_memory(buffer.data.data() + command.data_offset, data, data_size);
+		}
+		buffer.commands.push_back(command);
+	}
+
+	// Spawns the entries [first, last), all spawns of the same archetype, with one ecs_system_spawn_batch. Every component given by any of them gets a column, zeroed for the spawns that don't give it
+	static void spawn_batch(std::vector<ecs_command>& commands, std::vector<uchar>& data, std::vector<ecs_command_sort_entry>& entries, uint first, uint last) {
+		archetype arch = (archetype)entries[first].archetype;
+		uint count = last - first;
+
+		std::vector<component_id> components;
+		std::vector<std::vector<uchar>> columns;
+		for (uint i = first; i < last; ++i) {
+			ecs_command& command = commands[entries[i].command];
+			uchar* payload = data.data() + command.data_offset;
+			uchar* payload_end = payload + command.data_size;
+			while (payload < payload_end) {
+				ecs_command_spawn_component header;
+				copy_memory(&header, payload, sizeof(ecs_command_spawn_component));
+				payload += sizeof(ecs_command_spawn_component);
+
+				ecs_column column = ecs_system_get_column(arch, header.component);
+				if (column.index != INVALID_ID) {
+					uint component_index = (uint)(std::find(components.begin(), components.end(), header.component) - components.begin());
+					if (component_index == components.size()) {
+						components.push_back(header.component);
+						columns.push_back(std::vector<uchar>((uint64)column.component_size * count, 0));
+					}
+
+					uint size = header.size < column.component_size ? header.size : column.component_size;
+					copy_memory(columns[component_index].data() + (uint64)column.component_size * (i - first), payload, size);
+				}
+				payload += align_data_size(header.size);
+			}
+		}
+
+		std::vector<const void*> components_data(columns.size());
+		for (uint i = 0; i < columns.size(); ++i) {
+			components_data[i] = columns[i].data();
+		}
+		ecs_system_spawn_batch(arch, count, (uint)components.size(), components.data(), components_data.data(), nullptr);
+	}
+
+	// ecs_system_insert_data copies the whole column, a payload smaller than the component is copied to a zeroed one first
+	static void insert_payload(uint entity, component_id component, const uchar* payload, uint payload_size) {
+		ecs_column column = ecs_system_get_column(ecs_system_get_entity_archetype(entity), component);
+		if (column.index == INVALID_ID) {
+			return;
+		}
+
+		if (payload_size >= column.component_size) {
+			ecs_system_insert_data(entity, component, (void*)payload);
+			return;
+		}
+
+		std::vector<uchar> component_data(column.component_size, 0);
+		copy_memory(component_data.data(), payload, payload_size);
+		ecs_system_insert_data(entity, component, component_data.data());
+	}
+
+	void ecs_command_buffer_spawn_data(ecs_command_buffer& buffer, archetype archetype, uint component_count, const component_id* components, const uint* components_sizes, const void* const* components_data) {
+		uint data_size = 0;
+		for (uint i = 0; i < component_count; ++i) {
+			data_size += sizeof(ecs_command_spawn_component) + align_data_size(components_sizes[i]);
+		}
+
+		ecs_command command;
+		command.type = ECS_COMMAND_SPAWN;
+		command.entity = INVALID_ID;
+		command.argument = archetype;
+		command.data_size = data_size;
+
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		command.data_offset = reserve_data(buffer, data_size);
+
+		uchar* payload = buffer.data.data() + command.data_offset;
+		for (uint i = 0; i < component_count; ++i) {
+			ecs_command_spawn_component header;
+			header.component = components[i];
+			header.size = components_sizes[i];
+			copy_memory(payload, &header, sizeof(ecs_command_spawn_component));
+			payload += sizeof(ecs_command_spawn_component);
+
+			copy_memory(payload, components_data[i], components_sizes[i]);
+			payload += align_data_size(components_sizes[i]);
+		}
+		buffer.commands.push_back(command);
+	}
+
+	void ecs_command_buffer_change_archetype(ecs_command_buffer& buffer, uint entity, archetype archetype) {
+		push_command(buffer, ECS_COMMAND_CHANGE_ARCHETYPE, entity, archetype, nullptr, 0);
+	}
+
+	void ecs_command_buffer_add_component(ecs_command_buffer& buffer, uint entity, component_id component, const void* data, uint data_size) {
+		push_command(buffer, ECS_COMMAND_ADD_COMPONENT, entity, component, data, data ? data_size : 0);
+	}
+
+	void ecs_command_buffer_remove_component(ecs_command_buffer& buffer, uint entity, component_id component) {
+		push_command(buffer, ECS_COMMAND_REMOVE_COMPONENT, entity, component, nullptr, 0);
+	}
+
+	void ecs_command_buffer_insert_data(ecs_command_buffer& buffer, uint entity, component_id component, const void* data, uint data_size) {
+		if (!data || !data_size) {
+			CE_LOG_ERROR("ecs_command_buffer_insert_data the data of component %u is empty", component);
+			return;
+		}
+		push_command(buffer, ECS_COMMAND_INSERT_DATA, entity, component, data, data_size);
+	}
+
+	void ecs_command_buffer_enable(ecs_command_buffer& buffer, uint entity, bool enabled) {
+		push_command(buffer, ECS_COMMAND_ENABLE, entity, enabled, nullptr, 0);
+	}
+
+	void ecs_command_buffer_destroy(ecs_command_buffer& buffer, uint entity) {
+		push_command(buffer, ECS_COMMAND_DESTROY, entity, 0, nullptr, 0);
+	}
+
+	void ecs_command_buffer_apply(ecs_command_buffer& buffer) {
+		// Takes the commands out, so the commands recorded while applying go to the next apply
+		std::vector<ecs_command> commands;
+		std::vector<uchar> data;
+		{
+			std::lock_guard<std::mutex> lock(buffer.mutex);
+			commands.swap(buffer.commands);
+			data.swap(buffer.data);
+		}
+
+		if (commands.empty()) {
+			return;
+		}
+
+		// Groups the spawns by archetype and the rest of the commands by archetype and entity, so each archetype is touched in a row.
+		// The commands of each entity keep the order they were recorded, the commands of stale entities are dropped
+		std::vector<ecs_command_sort_entry> entries;
+		entries.reserve(commands.size());
+		for (uint i = 0; i < commands.size(); ++i) {
+			ecs_command& command = commands[i];
+
+			ecs_command_sort_entry entry;
+			entry.entity = command.entity;
+			entry.command = i;
+			if (command.type == ECS_COMMAND_SPAWN) {
+				entry.group = 0;
+				entry.archetype = command.argument;
+			}
+			else if (ecs_system_is_entity_alive(command.entity)) {
+				entry.group = 1;
+				entry.archetype = ecs_system_get_entity_archetype(command.entity);
+			}
+			else {
+				continue;
+			}
+			entries.push_back(entry);
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const ecs_command_sort_entry& a, const ecs_command_sort_entry& b) {
+			if (a.group != b.group) {
+				return a.group < b.group;
+			}
+			if (a.archetype != b.archetype) {
+				return a.archetype < b.archetype;
+			}
+			if (a.entity != b.entity) {
+				return a.entity < b.entity;
+			}
+			return a.command < b.command;
+		});
+
+		uint entry_index = 0;
+		while (entry_index < entries.size() && entries[entry_index].group == 0) {
+			uint batch_end = entry_index;
+			while (batch_end < entries.size() && entries[batch_end].group == 0 && entries[batch_end].archetype == entries[entry_index].archetype) {
+				++batch_end;
+			}
+			spawn_batch(commands, data, entries, entry_index, batch_end);
+			entry_index = batch_end;
+		}
+
+		for (; entry_index < entries.size(); ++entry_index) {
+			ecs_command& command = commands[entries[entry_index].command];
+			uchar* payload = data.data() + command.data_offset;
+
+			switch (command.type) {
+				case ECS_COMMAND_CHANGE_ARCHETYPE:
+					ecs_system_change_entity(command.entity, (archetype)command.argument);
+					break;
+				case ECS_COMMAND_ADD_COMPONENT:
+					if (ecs_system_add_component(command.entity, (component_id)command.argument, nullptr) && command.data_size) {
+						insert_payload(command.entity, (component_id)command.argument, payload, command.data_size);
+					}
+					break;
+				case ECS_COMMAND_REMOVE_COMPONENT:
+					ecs_system_remove_component(command.entity, (component_id)command.argument);
+					break;
+				case ECS_COMMAND_INSERT_DATA:
+					// Ignored if the entity lost the component in an earlier command of this same apply
+					insert_payload(command.entity, (component_id)command.argument, payload, command.data_size);
+					break;
+				case ECS_COMMAND_ENABLE:
+					ecs_system_enable_entity(command.entity, command.argument != 0);
+					break;
+				case ECS_COMMAND_DESTROY:
+					ecs_system_delete_entity(command.entity);
+					break;
+				default:
+					CE_LOG_ERROR("ecs_command_buffer_apply unknown command type %u", command.type);
+					break;
+			}
+		}
+	}
+
+	void ecs_command_buffer_clear(ecs_command_buffer& buffer) {
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		buffer.commands.clear();
+		buffer.data.clear();
+	}
+}
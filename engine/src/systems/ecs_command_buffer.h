@@ -0,0 +1,87 @@
+#pragma once
+#include "defines.h"
+#include "systems/ecs_system.h"
+#include "systems/ecs_query.h"
+
+#include <mutex>
+
+namespace caliope {
+
+	typedef enum ecs_command_type {
+		ECS_COMMAND_SPAWN = 0,
+		ECS_COMMAND_CHANGE_ARCHETYPE,
+		ECS_COMMAND_ADD_COMPONENT,
+		ECS_COMMAND_REMOVE_COMPONENT,
+		ECS_COMMAND_INSERT_DATA,
+		ECS_COMMAND_ENABLE,
+		ECS_COMMAND_DESTROY
+	} ecs_command_type;
+
+	typedef struct ecs_command {
+		ecs_command_type type;
+		// The archetype for the spawns
+		uint entity;
+		// Archetype, component or enabled, depending on the type
+		uint argument;
+		// Payload in the data of the buffer, the components of a spawn or the component of an add or an insert
+		uint data_offset;
+		uint data_size;
+	} ecs_command;
+
+	/**
+	 * @brief Records structural changes of the ECS to apply them later in one batched pass with ecs_command_buffer_apply. The commands can be recorded from any thread,
+	 * i.e. from the update of a system or while a query iterates, the changes are not visible until the buffer is applied.
+	 * @note The commands of an entity that is deleted before the buffer is applied are ignored. The entities of the scenes and the UI layouts must be destroyed through their systems,
+	 * so they are removed from their scene too.
+	 */
+	typedef struct ecs_command_buffer {
+		std::vector<ecs_command> commands;
+		std::vector<uchar> data;
+		std::mutex mutex;
+	} ecs_command_buffer;
+
+	/**
+	 * @brief Spawns an entity of archetype with the data of some of its components, the rest are zeroed.
+	 */
+	CE_API void ecs_command_buffer_spawn_data(ecs_command_buffer& buffer, archetype archetype, uint component_count, const component_id* components, const uint* components_sizes, const void* const* components_data);
+	CE_API void ecs_command_buffer_change_archetype(ecs_command_buffer& buffer, uint entity, archetype archetype);
+	// data can be nullptr to add the component zeroed
+	CE_API void ecs_command_buffer_add_component(ecs_command_buffer& buffer, uint entity, component_id component, const void* data, uint data_size);
+	CE_API void ecs_command_buffer_remove_component(ecs_command_buffer& buffer, uint entity, component_id component);
+	// data can't be nullptr, if data_size is smaller than the component the rest is zeroed
+	CE_API void ecs_command_buffer_insert_data(ecs_command_buffer& buffer, uint entity, component_id component, const void* data, uint data_size);
+	CE_API void ecs_command_buffer_enable(ecs_command_buffer& buffer, uint entity, bool enabled);
+	CE_API void ecs_command_buffer_destroy(ecs_command_buffer& buffer, uint entity);
+
+	/**
+	 * @brief Applies the commands on the main thread and clears the buffer. The spawns go first, one ecs_system_spawn_batch per archetype,
+	 * then the commands of the existing entities grouped by archetype and entity, the commands of each entity keep the order they were recorded.
+	 */
+	CE_API void ecs_command_buffer_apply(ecs_command_buffer& buffer);
+	CE_API void ecs_command_buffer_clear(ecs_command_buffer& buffer);
+
+	inline void ecs_command_buffer_spawn(ecs_command_buffer& buffer, archetype archetype) {
+		ecs_command_buffer_spawn_data(buffer, archetype, 0, nullptr, nullptr, nullptr);
+	}
+
+	/**
+	 * @brief ecs_command_buffer_spawn(buffer, ARCHETYPE_SPRITE, transform, material) with the component types known by ecs_query.
+	 */
+	template<typename... T>
+	void ecs_command_buffer_spawn(ecs_command_buffer& buffer, archetype archetype, const T&... components) {
+		component_id ids[] = { ecs_component_id<T>::value... };
+		uint sizes[] = { (uint)sizeof(T)... };
+		const void* data[] = { &components... };
+		ecs_command_buffer_spawn_data(buffer, archetype, sizeof...(T), ids, sizes, data);
+	}
+
+	template<typename T>
+	void ecs_command_buffer_add_component(ecs_command_buffer& buffer, uint entity, const T& component) {
+		ecs_command_buffer_add_component(buffer, entity, ecs_component_id<T>::value, &component, sizeof(T));
+	}
+
+	template<typename T>
+	void ecs_command_buffer_insert_data(ecs_command_buffer& buffer, uint entity, const T& component) {
+		ecs_command_buffer_insert_data(buffer, entity, ecs_component_id<T>::value, &component, sizeof(T));
+	}
+}
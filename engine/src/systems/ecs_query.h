@@ -0,0 +1,176 @@
+#pragma once
+#include "defines.h"
+#include "systems/ecs_system.h"
+
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+namespace caliope {
+
+	// Maps each component struct to its component_id, so the queries can be declared with the component types
+	template<typename T>
+	struct ecs_component_id;
+
+	#define ECS_COMPONENT_ID(type, id) template<> struct ecs_component_id<type> { static constexpr component_id value = id; }
+
+	// The queries take const components for the columns they only read
+	template<typename T>
+	struct ecs_component_id<const T> : ecs_component_id<T> {};
+
+	ECS_COMPONENT_ID(transform_component, TRANSFORM_COMPONENT);
+	ECS_COMPONENT_ID(material_component, MATERIAL_COMPONENT);
+	ECS_COMPONENT_ID(material_animation_component, MATERIAL_ANIMATION_COMPONENT);
+	ECS_COMPONENT_ID(sound_emmiter_component, SOUND_EMMITER_COMPONENT);
+	ECS_COMPONENT_ID(point_light_component, POINT_LIGHT_COMPONENT);
+	ECS_COMPONENT_ID(parent_component, PARENT_COMPONENT);
+	ECS_COMPONENT_ID(ui_transform_component, UI_TRANSFORM_COMPONENT);
+	ECS_COMPONENT_ID(ui_material_component, UI_MATERIAL_COMPONENT);
+	ECS_COMPONENT_ID(ui_dynamic_material_component, UI_DYNAMIC_MATERIAL_COMPONENT);
+	ECS_COMPONENT_ID(ui_events_component, UI_MOUSE_EVENTS_COMPONENT);
+	ECS_COMPONENT_ID(ui_text_component, UI_TEXT_COMPONENT);
+	ECS_COMPONENT_ID(ui_behaviour_component, UI_BEHAVIOUR_COMPONENT);
+	ECS_COMPONENT_ID(ui_container_component, UI_CONTAINER_COMPONENT);
+
+	template<typename... T>
+	constexpr uint ecs_signature() {
+		return (0u | ... | (1u << ecs_component_id<T>::value));
+	}
+
+	// Signature of the non const components
+	template<typename... T>
+	constexpr uint ecs_write_signature() {
+		return (0u | ... | (std::is_const<T>::value ? 0u : 1u << ecs_component_id<T>::value));
+	}
+
+	/**
+	 * @brief Chunk of an archetype matched by a query. The columns are contiguous arrays of entity_count components, in the same order as the components of the query.
+	 */
+	template<typename... T>
+	struct ecs_query_chunk {
+		archetype archetype;
+		uint entity_count;
+		uint* entities;
+		uint64* enabled_mask;
+		uint enabled_count;
+		std::tuple<T*...> columns;
+
+		// Position of the iteration, a zero initialized chunk starts from the first archetype
+		uint archetype_index;
+		uint next_chunk;
+		// Columns of the current archetype, resolved once when the iteration enters the archetype
+		ecs_column column_handles[sizeof...(T)];
+	};
+
+	namespace ecs_query_internal {
+		template<typename... T, size_t... I>
+		void set_columns(ecs_query_chunk<T...>& chunk, uint chunk_index, std::index_sequence<I...>) {
+			chunk.columns = std::tuple<T*...>((T*)ecs_system_get_chunk_column_data(chunk.column_handles[I], chunk_index)...);
+		}
+	}
+
+	/**
+	 * @brief Iterates every archetype that has the components T..., i.e. ecs_query<const transform_component, material_component>. The matching archetypes are cached by the ECS per signature,
+	 * so creating a query is a single lookup and it also iterates the archetypes built after its creation.
+	 * Every chunk given by the query is marked as changed for its non const components, declare const the components that are only read.
+	 */
+	template<typename... T>
+	struct ecs_query {
+		typedef ecs_query_chunk<T...> chunk_type;
+
+		uint signature;
+		uint exclude_signature;
+		uint write_signature;
+		std::vector<archetype>* archetypes;
+
+		// Only the chunks with changes of these components after changed_version are iterated, 0 iterates every chunk
+		uint changed_signature;
+		uint64 changed_version;
+	};
+
+	/**
+	 * @param exclude_signature The archetypes with any of these components are skipped, built with ecs_signature
+	 */
+	template<typename... T>
+	ecs_query<T...> ecs_query_create(uint exclude_signature = 0) {
+		ecs_query<T...> query;
+		query.signature = ecs_signature<T...>();
+		query.exclude_signature = exclude_signature;
+		query.write_signature = ecs_write_signature<T...>();
+		query.archetypes = &ecs_system_query_archetypes(query.signature, exclude_signature);
+		query.changed_signature = 0;
+		query.changed_version = 0;
+		return query;
+	}
+
+	/**
+	 * @brief Skips the chunks where the components of changed_signature and the entities haven't changed after version, usually the ecs_system_get_version of the last update of a cache.
+	 */
+	template<typename... T>
+	void ecs_query_set_changed_filter(ecs_query<T...>& query, uint changed_signature, uint64 version) {
+		query.changed_signature = changed_signature;
+		query.changed_version = version;
+	}
+
+	/**
+	 * @brief Moves chunk to the next chunk of the query, returns false when there are no more chunks. Iterates every entity, check enabled_mask with ecs_is_entity_enabled or ecs_for_each_enabled to skip the disabled ones.
+	 * @note The query can't add or delete entities of the iterated archetypes while iterating, record them on an ecs_command_buffer instead. Only the main thread can iterate the queries with non const components.
+	 */
+	template<typename... T>
+	bool ecs_query_next_chunk(const ecs_query<T...>& query, ecs_query_chunk<T...>& chunk) {
+		while (chunk.archetype_index < query.archetypes->size()) {
+			archetype arch = (*query.archetypes)[chunk.archetype_index];
+			if (chunk.next_chunk < ecs_system_get_chunk_count(arch)) {
+				if (chunk.next_chunk == 0) {
+					component_id components[] = { ecs_component_id<T>::value... };
+					for (uint i = 0; i < sizeof...(T); ++i) {
+						chunk.column_handles[i] = ecs_system_get_column(arch, components[i]);
+					}
+				}
+
+				uint chunk_index = chunk.next_chunk++;
+				if (query.changed_signature && !ecs_system_is_chunk_changed(arch, chunk_index, query.changed_signature, query.changed_version)) {
+					continue;
+				}
+
+				if (query.write_signature) {
+					ecs_system_mark_chunk_changed(arch, chunk_index, query.write_signature);
+				}
+
+				chunk.archetype = arch;
+				chunk.entity_count = ecs_system_get_chunk_entity_count(arch, chunk_index);
+				chunk.entities = ecs_system_get_chunk_entities(arch, chunk_index);
+				chunk.enabled_mask = ecs_system_get_chunk_enabled_mask(arch, chunk_index);
+				chunk.enabled_count = ecs_system_get_chunk_enabled_count(arch, chunk_index);
+				ecs_query_internal::set_columns(chunk, chunk_index, std::index_sequence_for<T...>{});
+				return true;
+			}
+
+			chunk.archetype_index++;
+			chunk.next_chunk = 0;
+		}
+
+		return false;
+	}
+
+	template<typename C, typename... T>
+	C* ecs_query_column(ecs_query_chunk<T...>& chunk) {
+		return std::get<C*>(chunk.columns);
+	}
+
+	/**
+	 * @brief Calls function(entity, T&... components) for every enabled entity of the query.
+	 */
+	template<typename... T, typename F>
+	void ecs_query_for_each(const ecs_query<T...>& query, F&& function) {
+		ecs_query_chunk<T...> chunk = {};
+		while (ecs_query_next_chunk(query, chunk)) {
+			if (chunk.enabled_count == 0) {
+				continue;
+			}
+			ecs_for_each_enabled(chunk.enabled_mask, chunk.entity_count, [&](uint i) {
+				function(chunk.entities[i], std::get<T*>(chunk.columns)[i]...);
+			});
+		}
+	}
+}
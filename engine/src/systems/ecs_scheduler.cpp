@@ -0,0 +1,167 @@
+#include "ecs_scheduler.h"
+#include "core/logger.h"
+#include "memory/frame_allocator.h"
+
+#include "job_system.h"
+
+namespace caliope {
+
+	typedef struct ecs_scheduled_system {
+		uint id;
+		ecs_system_config config;
+		std::vector<archetype>* archetypes;
+
+		// Stage of the system in the graph of the frame, the systems of the same stage run in parallel
+		uint stage;
+	} ecs_scheduled_system;
+
+	typedef struct ecs_scheduler_work {
+		ecs_scheduled_system* system;
+		ecs_system_chunk chunk;
+	} ecs_scheduler_work;
+
+	typedef struct ecs_scheduler_state {
+		// In registration order, it decides which system goes first when two of them touch the same components
+		std::vector<ecs_scheduled_system> systems;
+		uint next_system_id;
+	} ecs_scheduler_state;
+
+	static std::unique_ptr<ecs_scheduler_state> state_ptr;
+
+	static bool systems_conflict(const ecs_system_config& first, const ecs_system_config& second) {
+		return (first.write_signature & (second.read_signature | second.write_signature)) || (first.read_signature & second.write_signature);
+	}
+
+	static void run_works(uint begin, uint end, void* data) {
+		ecs_scheduler_work* works = (ecs_scheduler_work*)data;
+		for (uint i = begin; i < end; ++i) {
+			works[i].system->config.update(works[i].chunk, works[i].system->config.user_data);
+		}
+	}
+
+	bool ecs_scheduler_initialize() {
+		state_ptr = std::make_unique<ecs_scheduler_state>();
+
+		if (state_ptr == nullptr) {
+			return false;
+		}
+
+		state_ptr->next_system_id = 0;
+
+		CE_LOG_INFO("ECS scheduler initialized.");
+
+		return true;
+	}
+
+	void ecs_scheduler_shutdown() {
+		state_ptr.reset();
+		state_ptr = nullptr;
+	}
+
+	uint ecs_scheduler_register_system(ecs_system_config& config) {
+		if (config.update == nullptr) {
+			CE_LOG_ERROR("ecs_scheduler_register_system system %s has no update function", config.name);
+			return INVALID_ID;
+		}
+
+		ecs_scheduled_system system;
+		system.id = state_ptr->next_system_id++;
+		system.config = config;
+		system.archetypes = &ecs_system_query_archetypes(config.read_signature | config.write_signature, config.exclude_signature);
+		system.stage = 0;
+		state_ptr->systems.push_back(system);
+
+		CE_LOG_INFO("ECS system %s registered.", config.name);
+
+		return system.id;
+	}
+
+	void ecs_scheduler_unregister_system(uint system_id) {
+		for (uint i = 0; i < state_ptr->systems.size(); ++i) {
+			if (state_ptr->systems[i].id == system_id) {
+				state_ptr->systems.erase(state_ptr->systems.begin() + i);
+				return;
+			}
+		}
+
+		CE_LOG_WARNING("ecs_scheduler_unregister_system system %u is not registered", system_id);
+	}
+
+	void ecs_scheduler_update(float delta_time) {
+		std::vector<ecs_scheduled_system>& systems = state_ptr->systems;
+		if (systems.empty()) {
+			return;
+		}
+
+		// Builds the graph of the frame, each system goes to the stage after the last system it depends on
+		uint stage_count = 0;
+		for (uint i = 0; i < systems.size(); ++i) {
+			uint stage = 0;
+			for (uint j = 0; j < i; ++j) {
+				if (systems_conflict(systems[j].config, systems[i].config) && systems[j].stage + 1 > stage) {
+					stage = systems[j].stage + 1;
+				}
+			}
+			systems[i].stage = stage;
+			if (stage + 1 > stage_count) {
+				stage_count = stage + 1;
+			}
+		}
+
+		// NOTE: A growing frame_vector leaves its old blocks in the frame arena, it is sized once for the biggest stage
+		frame_vector<uint> stage_chunk_counts(stage_count, 0);
+		uint max_stage_chunk_count = 0;
+		for (ecs_scheduled_system& system : systems) {
+			for (archetype arch : *system.archetypes) {
+				stage_chunk_counts[system.stage] += ecs_system_get_chunk_count(arch);
+			}
+			if (stage_chunk_counts[system.stage] > max_stage_chunk_count) {
+				max_stage_chunk_count = stage_chunk_counts[system.stage];
+			}
+		}
+
+		frame_vector<ecs_scheduler_work> works;
+		works.reserve(max_stage_chunk_count);
+		for (uint stage = 0; stage < stage_count; ++stage) {
+			works.clear();
+
+			// One work per chunk of every system of the stage
+			for (ecs_scheduled_system& system : systems) {
+				if (system.stage != stage) {
+					continue;
+				}
+
+				uint output_count = 0;
+				for (archetype arch : *system.archetypes) {
+					uint chunk_count = ecs_system_get_chunk_count(arch);
+					for (uint chunk = 0; chunk < chunk_count; ++chunk) {
+						ecs_scheduler_work work;
+						work.system = &system;
+						work.chunk.archetype = arch;
+						work.chunk.chunk = chunk;
+						work.chunk.entity_count = ecs_system_get_chunk_entity_count(arch, chunk);
+						work.chunk.entities = ecs_system_get_chunk_entities(arch, chunk);
+						work.chunk.enabled_mask = ecs_system_get_chunk_enabled_mask(arch, chunk);
+						work.chunk.enabled_count = ecs_system_get_chunk_enabled_count(arch, chunk);
+						work.chunk.first_output = output_count;
+						work.chunk.delta_time = delta_time;
+						works.push_back(work);
+
+						if (system.config.write_signature) {
+							ecs_system_mark_chunk_changed(arch, chunk, system.config.write_signature);
+						}
+
+						output_count += work.chunk.enabled_count;
+					}
+				}
+
+				if (system.config.prepare) {
+					system.config.prepare(output_count, system.config.user_data);
+				}
+			}
+
+			// NOTE: The chunks are the batches, they are big enough to pay off the cost of taking one
+			job_system_parallel_for((uint)works.size(), 1, run_works, works.data());
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "defines.h"
+#include "systems/ecs_system.h"
+
+namespace caliope {
+
+	/**
+	 * @brief Chunk given to a system update, the components are taken with ecs_system_get_chunk_component_data or with the columns of the archetype.
+	 */
+	typedef struct ecs_system_chunk {
+		archetype archetype;
+		uint chunk;
+		uint entity_count;
+		uint* entities;
+		uint64* enabled_mask;
+		uint enabled_count;
+
+		// Enabled entities of the chunks of the system before this one, a system with one output per enabled entity writes them from here
+		uint first_output;
+		float delta_time;
+	} ecs_system_chunk;
+
+	// Called on the main thread before the chunks of the system are updated, output_count is the number of enabled entities the system is going to update
+	typedef void (*pfn_ecs_system_prepare)(uint output_count, void* user_data);
+
+	// Called from the job threads, one call per chunk. It can only touch the components declared by the system and its own outputs
+	typedef void (*pfn_ecs_system_update)(const ecs_system_chunk& chunk, void* user_data);
+
+	typedef struct ecs_system_config {
+		const char* name;
+		// Components read and written by the system, the system updates the archetypes that have all of them. The written columns are marked as changed on every update
+		uint read_signature;
+		uint write_signature;
+		uint exclude_signature;
+
+		// Optional
+		pfn_ecs_system_prepare prepare;
+		pfn_ecs_system_update update;
+		void* user_data;
+	} ecs_system_config;
+
+	bool ecs_scheduler_initialize();
+	void ecs_scheduler_shutdown();
+
+	/**
+	 * @brief Registers a system that is updated every frame by ecs_scheduler_update, returns its id to unregister it.
+	 * @note A system runs after every system registered before it that writes a component it reads or writes, or that reads a component it writes. The rest of the systems run in parallel.
+	 */
+	CE_API uint ecs_scheduler_register_system(ecs_system_config& config);
+	CE_API void ecs_scheduler_unregister_system(uint system_id);
+
+	/**
+	 * @brief Updates every registered system, the chunks of the systems that don't depend on each other are split between the job threads. Returns when every system is done.
+	 * @note The entities can't be added, deleted or enabled while the systems run, the systems record those changes on ecs_system_get_frame_commands.
+	 */
+	void ecs_scheduler_update(float delta_time);
+}
@@ -1,42 +1,489 @@
 #include "ecs_system.h"
 #include "core/cememory.h"
 #include "core/logger.h"
+#include "containers/slot_map.h"
+#include "containers/flat_hash_map.h"
+#include "systems/ecs_command_buffer.h"
+#include "memory/stack_allocator.h"
+#include "resources/resources_types.inl"
+#include "platform/file_system.h"
+#include "core/event.h"
 
 #include "cepch.h"
 
 namespace caliope {
 
 
+	// Each archetype stores its components in chunks of this size, with a contiguous column per component
+	#define ECS_CHUNK_SIZE (KIBIBYTES(16))
+	#define ECS_CHUNK_ALIGNMENT 64
+	#define ECS_COLUMN_ALIGNMENT 16
+
+	// Transitions of the archetype graph, an archetype with no transition for a component points to ECS_TRANSITION_NONE
+	#define ECS_TRANSITION_UNRESOLVED INVALID_ID
+	#define ECS_TRANSITION_NONE (INVALID_ID - 1)
+
 	typedef struct ecs_entity_entry {
 		archetype archetype;
-		uint component_index; // Index corresponding to their data on component_pool
-		bool is_enabled;
+		uint component_index; // Row of the entity in the archetype, the chunk is component_index / chunk_capacity
 	} ecs_entity_entry;
 
+	typedef struct ecs_chunk {
+		// Holds one column per component, then the entity column and the enabled bitmask
+		uchar* memory;
+		uint entity_count;
+		uint enabled_count;
+
+		// ECS version of the last write of each column, and of the last entity added, deleted, enabled or disabled in the chunk
+		std::array<uint64, ECS_MAX_COMPONENTS> column_versions;
+		uint64 structure_version;
+	} ecs_chunk;
+
 	typedef struct archetype_data {
-		std::vector<std::vector<void*>> component_pool;
+		std::vector<ecs_chunk> chunks;
 		std::vector<uint> component_sizes;
+		std::vector<uint> column_offsets; // Offset of the column of each component inside a chunk
 		std::vector<component_id> components_tracker; // Has the information about where is stored each component
+		std::array<uint, ECS_MAX_COMPONENTS> columns_by_component; // Column of each component id, INVALID_ID if the archetype doesn't have the component
+		uint signature; // Bit per component of the archetype
+		// Archetype reached by adding or removing each component, resolved the first time the migration is done
+		std::array<uint, ECS_MAX_COMPONENTS> add_transitions;
+		std::array<uint, ECS_MAX_COMPONENTS> remove_transitions;
+		uint entities_offset;
+		uint enabled_offset;
+		uint chunk_capacity; // Entities per chunk
+		uint chunk_size;
 		uint entity_count;
+		uint enabled_count;
+		bool is_built;
 	} archetype_data;
 
+	// Fields of the components that are not parsed and only hold runtime state, the snapshots don't keep them
+	typedef enum ecs_runtime_field_type {
+		// The id of the name at source_offset, derived by the ECS every time the component is spawned, inserted or restored
+		ECS_RUNTIME_FIELD_NAME_ID = 0,
+		// Only valid in the process that set it, reset to nullptr on restore
+		ECS_RUNTIME_FIELD_POINTER
+	} ecs_runtime_field_type;
+
+	typedef struct ecs_runtime_field {
+		ecs_runtime_field_type type;
+		uint offset;
+		uint source_offset;
+	} ecs_runtime_field;
+
 	typedef struct ecs_system_state {
 		std::vector<archetype_data> archetypes;
-		std::unordered_map<uint, ecs_entity_entry> entities_tracker; // Has the information about the archetype of the component and where is stored
-		std::unordered_map<archetype, std::vector<uint>> entites_grouped_by_archetypes;
-		std::unordered_map<archetype, std::vector<uint>> enabled_entites_grouped_by_archetypes;
+		// Has the information about the archetype of the component and where is stored. The entities are the handles of the slot map,
+		// so a deleted entity is detected as stale instead of reaching the entity that reused its slot
+		slot_map<ecs_entity_entry> entities_tracker;
 
 		std::unordered_map<component_id, std::vector<component_data_type>> components_data_types;
+		std::array<std::vector<ecs_runtime_field>, ECS_MAX_COMPONENTS> runtime_fields;
+
+		// Archetypes matched by each query, the key is the signature of the query and the excluded signature in the high bits
+		flat_hash_map<uint64, std::vector<archetype>> query_cache;
 
-		std::stack<uint> reusable_entities_pool;
-		uint system_entities_count;
+		// Increased on every write, the chunks keep the version of their last writes
+		uint64 version;
 
+		ecs_command_buffer frame_commands;
 	} ecs_system_state;
 
 	static std::unique_ptr<ecs_system_state> state_ptr;
 
-	//TODO: DRY the operation of delete from an vector, try to place the last element into the deleted space or make the vectors to static arrays and make the data without holes between data and iterate until a invalid data found
-	// or better, a vector but only increase its size when adding entities or deleting. The rest of operations would be threated as a static array ( and compact the data in the array)
+	#define ECS_SNAPSHOT_MAGIC 0x4E534543 // CESN
+	#define ECS_SNAPSHOT_FORMAT_VERSION 2
+
+	// The offsets are from the start of the snapshot
+	typedef struct ecs_snapshot_header {
+		uint magic;
+		uint format_version;
+		uint archetype_count;
+		uint entry_size; // Detects the snapshots of a build with another ecs_entity_entry
+
+		// State of the slot map of the entities
+		uint slot_count;
+		uint entity_count;
+		uint free_head;
+		uint free_tail;
+
+		uint64 size;
+		uint64 archetypes_offset;
+		uint64 slots_offset;
+		uint64 handles_offset;
+		uint64 entries_offset;
+	} ecs_snapshot_header;
+
+	typedef struct ecs_snapshot_archetype {
+		uint archetype;
+		uint component_count;
+		uint entity_count;
+		uint padding;
+		uint64 components_offset;
+		uint64 entities_offset;
+		uint64 enabled_offset; // Bit per entity of the archetype
+	} ecs_snapshot_archetype;
+
+	typedef struct ecs_snapshot_component {
+		uint component;
+		uint size;
+		uint data_type_count;
+		uint runtime_field_count;
+		uint64 data_types_offset;
+		uint64 runtime_fields_offset; // The runtime fields are zeroed in the column
+		uint64 column_offset; // entity_count components of the archetype, packed
+	} ecs_snapshot_component;
+
+	typedef struct ecs_snapshot_writer {
+		// nullptr only measures the snapshot
+		uchar* data;
+		uint64 size;
+	} ecs_snapshot_writer;
+
+	static uint align_offset(uint offset, uint alignment) {
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Places the columns of the archetype inside a chunk, returns the bytes used by a chunk of capacity entities
+	static uint layout_chunk(archetype_data& arch_data, uint capacity) {
+		uint offset = 0;
+		for (uint i = 0; i < arch_data.component_sizes.size(); ++i) {
+			offset = align_offset(offset, ECS_COLUMN_ALIGNMENT);
+			arch_data.column_offsets[i] = offset;
+			offset += arch_data.component_sizes[i] * capacity;
+		}
+
+		offset = align_offset(offset, ECS_COLUMN_ALIGNMENT);
+		arch_data.entities_offset = offset;
+		offset += sizeof(uint) * capacity;
+
+		// NOTE: The bits past the last entity of the chunk are always clear, so the mask can be scanned a word at a time
+		offset = align_offset(offset, sizeof(uint64));
+		arch_data.enabled_offset = offset;
+		offset += sizeof(uint64) * ((capacity + ECS_ENABLED_MASK_BITS - 1) / ECS_ENABLED_MASK_BITS);
+
+		return offset;
+	}
+
+	static uchar* get_component(archetype_data& arch_data, uint column, uint row) {
+		ecs_chunk& chunk = arch_data.chunks[row / arch_data.chunk_capacity];
+		return chunk.memory + arch_data.column_offsets[column] + arch_data.component_sizes[column] * (row % arch_data.chunk_capacity);
+	}
+
+	static uint* get_row_entity(archetype_data& arch_data, uint row) {
+		ecs_chunk& chunk = arch_data.chunks[row / arch_data.chunk_capacity];
+		return (uint*)(chunk.memory + arch_data.entities_offset) + row % arch_data.chunk_capacity;
+	}
+
+	static bool is_row_enabled(archetype_data& arch_data, uint row) {
+		ecs_chunk& chunk = arch_data.chunks[row / arch_data.chunk_capacity];
+		return ecs_is_entity_enabled((uint64*)(chunk.memory + arch_data.enabled_offset), row % arch_data.chunk_capacity);
+	}
+
+	// Sets the enabled bit of the row, returns false if it already had that value
+	static bool set_row_enabled(archetype_data& arch_data, uint row, bool enabled) {
+		ecs_chunk& chunk = arch_data.chunks[row / arch_data.chunk_capacity];
+		uint chunk_row = row % arch_data.chunk_capacity;
+		uint64& word = ((uint64*)(chunk.memory + arch_data.enabled_offset))[chunk_row / ECS_ENABLED_MASK_BITS];
+		uint64 bit = 1ull << (chunk_row % ECS_ENABLED_MASK_BITS);
+		if (((word & bit) != 0) == enabled) {
+			return false;
+		}
+
+		word ^= bit;
+		if (enabled) {
+			chunk.enabled_count++;
+			arch_data.enabled_count++;
+		}
+		else {
+			chunk.enabled_count--;
+			arch_data.enabled_count--;
+		}
+		return true;
+	}
+
+	// The memory of the chunks is zeroed, so every entity of a new chunk starts disabled. A new chunk counts as changed in every column
+	static ecs_chunk& allocate_chunk(archetype_data& arch_data) {
+		ecs_chunk chunk;
+		chunk.memory = (uchar*)allocate_memory_aligned(MEMORY_TAG_ECS, arch_data.chunk_size, ECS_CHUNK_ALIGNMENT);
+		chunk.entity_count = 0;
+		chunk.enabled_count = 0;
+		chunk.structure_version = ++state_ptr->version;
+		chunk.column_versions.fill(chunk.structure_version);
+		arch_data.chunks.push_back(chunk);
+		return arch_data.chunks.back();
+	}
+
+	static uint get_column_index(archetype_data& arch_data, component_id component) {
+		return (uint)component < ECS_MAX_COMPONENTS ? arch_data.columns_by_component[component] : INVALID_ID;
+	}
+
+	// Stamps the columns of the components of signature with a new version
+	static void mark_columns_changed(archetype_data& arch_data, ecs_chunk& chunk, uint signature) {
+		uint64 version = ++state_ptr->version;
+		for (uint i = 0; i < arch_data.components_tracker.size(); ++i) {
+			if (signature & (1u << arch_data.components_tracker[i])) {
+				chunk.column_versions[i] = version;
+			}
+		}
+	}
+
+	// Stamps the set of entities of the chunk, and every column when the rows have moved
+	static void mark_structure_changed(archetype_data& arch_data, ecs_chunk& chunk, bool rows_changed) {
+		if (rows_changed) {
+			mark_columns_changed(arch_data, chunk, arch_data.signature);
+		}
+		chunk.structure_version = ++state_ptr->version;
+	}
+
+	// Appends a row at the end of the archetype, the components of the row are not initialized
+	static uint push_row(archetype_data& arch_data, uint entity, bool enabled) {
+		// Every chunk but the last one is full, the new row goes to the end of the last chunk
+		if (arch_data.entity_count == arch_data.chunks.size() * arch_data.chunk_capacity) {
+			allocate_chunk(arch_data);
+		}
+
+		uint row = arch_data.entity_count++;
+		arch_data.chunks.back().entity_count++;
+		*get_row_entity(arch_data, row) = entity;
+		set_row_enabled(arch_data, row, enabled);
+		return row;
+	}
+
+	// Removes the row moving the last row of the archetype to the hole, so the chunks stay packed
+	// There is a secondary effect wich is the order of the entities may vary wich at the time of render for example affects the order (thats why exists z-order)
+	static void remove_row(archetype_data& arch_data, uint row) {
+		uint last_row = arch_data.entity_count - 1;
+		if (row != last_row) {
+			for (uint i = 0; i < arch_data.component_sizes.size(); i++) {
+				copy_memory(get_component(arch_data, i, row), get_component(arch_data, i, last_row), arch_data.component_sizes[i]);
+			}
+
+			uint last_entity = *get_row_entity(arch_data, last_row);
+			*get_row_entity(arch_data, row) = last_entity;
+			set_row_enabled(arch_data, row, is_row_enabled(arch_data, last_row));
+			slot_map_get(state_ptr->entities_tracker, last_entity)->component_index = row;
+			mark_structure_changed(arch_data, arch_data.chunks[row / arch_data.chunk_capacity], true);
+		}
+		set_row_enabled(arch_data, last_row, false);
+
+		arch_data.entity_count--;
+		arch_data.chunks.back().entity_count--;
+		if (arch_data.chunks.back().entity_count == 0) {
+			free_memory_aligned(MEMORY_TAG_ECS, arch_data.chunks.back().memory, arch_data.chunk_size, ECS_CHUNK_ALIGNMENT);
+			arch_data.chunks.pop_back();
+		}
+		else {
+			mark_structure_changed(arch_data, arch_data.chunks.back(), false);
+		}
+	}
+
+	// Moves the entity to the target archetype keeping its id, the components of both archetypes are copied and the new ones are zeroed
+	static void migrate_entity(uint entity, ecs_entity_entry& entity_entry, archetype target) {
+		archetype_data& source_data = state_ptr->archetypes[entity_entry.archetype];
+		archetype_data& target_data = state_ptr->archetypes[target];
+		uint source_row = entity_entry.component_index;
+		uint target_row = push_row(target_data, entity, is_row_enabled(source_data, source_row));
+		for (uint i = 0; i < target_data.component_sizes.size(); ++i) {
+			uint source_column = get_column_index(source_data, target_data.components_tracker[i]);
+			if (source_column != INVALID_ID) {
+				copy_memory(get_component(target_data, i, target_row), get_component(source_data, source_column, source_row), target_data.component_sizes[i]);
+			}
+			else {
+				zero_memory(get_component(target_data, i, target_row), target_data.component_sizes[i]);
+			}
+		}
+		mark_structure_changed(target_data, target_data.chunks.back(), true);
+		remove_row(source_data, source_row);
+
+		entity_entry.archetype = target;
+		entity_entry.component_index = target_row;
+	}
+
+	// Follows the transition of the archetype graph, the built archetype with the signature of the transition is looked up once and cached
+	static uint get_transition(archetype archetype, component_id component, bool add) {
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		uint& transition = add ? arch_data.add_transitions[component] : arch_data.remove_transitions[component];
+		if (transition != ECS_TRANSITION_UNRESOLVED) {
+			return transition;
+		}
+
+		uint signature = add ? arch_data.signature | (1u << component) : arch_data.signature & ~(1u << component);
+		transition = ECS_TRANSITION_NONE;
+		for (uint i = 0; i < state_ptr->archetypes.size(); ++i) {
+			if (state_ptr->archetypes[i].is_built && state_ptr->archetypes[i].signature == signature) {
+				transition = i;
+				break;
+			}
+		}
+		return transition;
+	}
+
+	static void register_runtime_field(component_id component, ecs_runtime_field_type type, uint offset, uint source_offset) {
+		ecs_runtime_field field;
+		field.type = type;
+		field.offset = offset;
+		field.source_offset = source_offset;
+		state_ptr->runtime_fields[component].push_back(field);
+	}
+
+	static uint get_runtime_field_size(ecs_runtime_field_type type) {
+		return type == ECS_RUNTIME_FIELD_NAME_ID ? sizeof(name_id) : sizeof(void*);
+	}
+
+	// Derives the name ids of count consecutive components of a column, reset_pointers also clears their pointers
+	static void resolve_runtime_fields(component_id component, uint component_size, uchar* components, uint count, bool reset_pointers) {
+		std::vector<ecs_runtime_field>& fields = state_ptr->runtime_fields[component];
+		for (ecs_runtime_field& field : fields) {
+			if (field.offset + get_runtime_field_size(field.type) > component_size || field.source_offset + 1 > component_size) {
+				continue;
+			}
+
+			if (field.type == ECS_RUNTIME_FIELD_POINTER) {
+				for (uint i = 0; reset_pointers && i < count; ++i) {
+					zero_memory(components + (uint64)component_size * i + field.offset, sizeof(void*));
+				}
+				continue;
+			}
+
+			// NOTE: The components spawned together usually share their names, the previous id is reused while the name repeats
+			const char* previous_name = nullptr;
+			name_id id = INVALID_NAME_ID;
+			for (uint i = 0; i < count; ++i) {
+				uchar* data = components + (uint64)component_size * i;
+				const char* name = (const char*)(data + field.source_offset);
+				if (!previous_name || strcmp(previous_name, name) != 0) {
+					id = name_id_intern(name);
+					previous_name = name;
+				}
+				copy_memory(data + field.offset, &id, sizeof(name_id));
+			}
+		}
+	}
+
+	// Places a blob of the snapshot, every blob is aligned as the columns of the chunks
+	static uint64 snapshot_reserve(ecs_snapshot_writer& writer, uint64 size) {
+		uint64 offset = (writer.size + ECS_COLUMN_ALIGNMENT - 1) & ~(uint64)(ECS_COLUMN_ALIGNMENT - 1);
+		writer.size = offset + size;
+		return offset;
+	}
+
+	static bool snapshot_range_valid(uint64 offset, uint64 size, uint64 snapshot_size) {
+		return (offset % ECS_COLUMN_ALIGNMENT) == 0 && offset <= snapshot_size && size <= snapshot_size - offset;
+	}
+
+	// Lays out the snapshot, the blobs are only written if the writer has data
+	static void write_snapshot(ecs_snapshot_writer& writer) {
+		slot_map<ecs_entity_entry>& entities = state_ptr->entities_tracker;
+
+		ecs_snapshot_header header = {};
+		header.magic = ECS_SNAPSHOT_MAGIC;
+		header.format_version = ECS_SNAPSHOT_FORMAT_VERSION;
+		header.entry_size = sizeof(ecs_entity_entry);
+		header.slot_count = entities.slot_count;
+		header.entity_count = entities.count;
+		header.free_head = entities.free_head;
+		header.free_tail = entities.free_tail;
+		for (archetype_data& arch_data : state_ptr->archetypes) {
+			header.archetype_count += arch_data.is_built;
+		}
+
+		uint64 header_offset = snapshot_reserve(writer, sizeof(ecs_snapshot_header));
+		header.archetypes_offset = snapshot_reserve(writer, sizeof(ecs_snapshot_archetype) * header.archetype_count);
+		header.slots_offset = snapshot_reserve(writer, sizeof(slot_map_slot) * (uint64)entities.slot_count);
+		header.handles_offset = snapshot_reserve(writer, sizeof(slot_map_handle) * (uint64)entities.count);
+		header.entries_offset = snapshot_reserve(writer, sizeof(ecs_entity_entry) * (uint64)entities.count);
+		if (writer.data && entities.slot_count) {
+			copy_memory(writer.data + header.slots_offset, entities.slots, sizeof(slot_map_slot) * (uint64)entities.slot_count);
+		}
+		if (writer.data && entities.count) {
+			copy_memory(writer.data + header.handles_offset, entities.handles, sizeof(slot_map_handle) * (uint64)entities.count);
+			copy_memory(writer.data + header.entries_offset, entities.values, sizeof(ecs_entity_entry) * (uint64)entities.count);
+		}
+
+		uint archetype_index = 0;
+		for (uint i = 0; i < state_ptr->archetypes.size(); ++i) {
+			archetype_data& arch_data = state_ptr->archetypes[i];
+			if (!arch_data.is_built) {
+				continue;
+			}
+
+			ecs_snapshot_archetype record = {};
+			record.archetype = i;
+			record.component_count = (uint)arch_data.components_tracker.size();
+			record.entity_count = arch_data.entity_count;
+			record.components_offset = snapshot_reserve(writer, sizeof(ecs_snapshot_component) * record.component_count);
+
+			for (uint c = 0; c < record.component_count; ++c) {
+				std::vector<component_data_type>& data_types = state_ptr->components_data_types.at(arch_data.components_tracker[c]);
+				std::vector<ecs_runtime_field>& runtime_fields = state_ptr->runtime_fields[arch_data.components_tracker[c]];
+
+				ecs_snapshot_component component = {};
+				component.component = arch_data.components_tracker[c];
+				component.size = arch_data.component_sizes[c];
+				component.data_type_count = (uint)data_types.size();
+				component.runtime_field_count = (uint)runtime_fields.size();
+				component.data_types_offset = snapshot_reserve(writer, sizeof(uint) * (uint64)component.data_type_count);
+				component.runtime_fields_offset = snapshot_reserve(writer, sizeof(ecs_runtime_field) * (uint64)component.runtime_field_count);
+				component.column_offset = snapshot_reserve(writer, (uint64)component.size * record.entity_count);
+				if (!writer.data) {
+					continue;
+				}
+
+				uint* snapshot_data_types = (uint*)(writer.data + component.data_types_offset);
+				for (uint j = 0; j < component.data_type_count; ++j) {
+					snapshot_data_types[j] = data_types[j];
+				}
+				if (component.runtime_field_count) {
+					copy_memory(writer.data + component.runtime_fields_offset, runtime_fields.data(), sizeof(ecs_runtime_field) * (uint64)component.runtime_field_count);
+				}
+
+				// The chunks are packed, so the column of the archetype is the columns of the chunks one after the other
+				uchar* column = writer.data + component.column_offset;
+				for (ecs_chunk& chunk : arch_data.chunks) {
+					uint64 column_size = (uint64)component.size * chunk.entity_count;
+					copy_memory(column, chunk.memory + arch_data.column_offsets[c], column_size);
+					column += column_size;
+				}
+
+				// NOTE: The runtime fields are zeroed so the snapshot holds no pointers and the same world gives the same bytes in every process
+				for (ecs_runtime_field& field : runtime_fields) {
+					uint field_size = get_runtime_field_size(field.type);
+					if (field.offset + field_size > component.size) {
+						continue;
+					}
+					for (uint row = 0; row < record.entity_count; ++row) {
+						zero_memory(writer.data + component.column_offset + (uint64)component.size * row + field.offset, field_size);
+					}
+				}
+				copy_memory(writer.data + record.components_offset + sizeof(ecs_snapshot_component) * c, &component, sizeof(ecs_snapshot_component));
+			}
+
+			record.entities_offset = snapshot_reserve(writer, sizeof(uint) * (uint64)record.entity_count);
+			record.enabled_offset = snapshot_reserve(writer, sizeof(uint64) * (((uint64)record.entity_count + ECS_ENABLED_MASK_BITS - 1) / ECS_ENABLED_MASK_BITS));
+			if (writer.data) {
+				uint* snapshot_entities = (uint*)(writer.data + record.entities_offset);
+				uint64* snapshot_enabled = (uint64*)(writer.data + record.enabled_offset);
+				uint first_row = 0;
+				for (ecs_chunk& chunk : arch_data.chunks) {
+					copy_memory(snapshot_entities + first_row, chunk.memory + arch_data.entities_offset, sizeof(uint) * (uint64)chunk.entity_count);
+					ecs_for_each_enabled((uint64*)(chunk.memory + arch_data.enabled_offset), chunk.entity_count, [&](uint row) {
+						uint archetype_row = first_row + row;
+						snapshot_enabled[archetype_row / ECS_ENABLED_MASK_BITS] |= 1ull << (archetype_row % ECS_ENABLED_MASK_BITS);
+					});
+					first_row += chunk.entity_count;
+				}
+				copy_memory(writer.data + header.archetypes_offset + sizeof(ecs_snapshot_archetype) * archetype_index, &record, sizeof(ecs_snapshot_archetype));
+			}
+			archetype_index++;
+		}
+
+		header.size = writer.size;
+		if (writer.data) {
+			copy_memory(writer.data + header_offset, &header, sizeof(ecs_snapshot_header));
+		}
+	}
 
 	bool ecs_system_initialize() {
 		state_ptr = std::make_unique<ecs_system_state>();
@@ -44,6 +491,10 @@ namespace caliope {
 		if (state_ptr == nullptr) {
 			return false;
 		}
+
+		slot_map_create(state_ptr->entities_tracker);
+		flat_hash_map_create(state_ptr->query_cache);
+		state_ptr->version = 0;
 		
 		// Builtin archetypes TODO: Build from loaded files and delete this
 		std::vector<uint> new_archetype_size = {sizeof(transform_component), sizeof(material_component)};
@@ -110,173 +561,333 @@ namespace caliope {
 		ui_box_components_data_types.push_back({ COMPONENT_DATA_TYPE_VEC3, COMPONENT_DATA_TYPE_UINT });
 		ecs_system_build_archetype(ARCHETYPE_UI_CONTAINER_BOX, new_archetype_id, new_archetype_size, ui_box_components_data_types);
 
+		register_runtime_field(MATERIAL_COMPONENT, ECS_RUNTIME_FIELD_NAME_ID, offsetof(material_component, material_id), offsetof(material_component, material_name));
+		register_runtime_field(MATERIAL_ANIMATION_COMPONENT, ECS_RUNTIME_FIELD_NAME_ID, offsetof(material_animation_component, animation_id), offsetof(material_animation_component, animation_name));
+		register_runtime_field(UI_MATERIAL_COMPONENT, ECS_RUNTIME_FIELD_NAME_ID, offsetof(ui_material_component, material_id), offsetof(ui_material_component, material_name));
+		register_runtime_field(UI_DYNAMIC_MATERIAL_COMPONENT, ECS_RUNTIME_FIELD_POINTER, offsetof(ui_dynamic_material_component, current_texture), 0);
+		register_runtime_field(UI_MOUSE_EVENTS_COMPONENT, ECS_RUNTIME_FIELD_POINTER, offsetof(ui_events_component, on_ui_hover), 0);
+		register_runtime_field(UI_MOUSE_EVENTS_COMPONENT, ECS_RUNTIME_FIELD_POINTER, offsetof(ui_events_component, on_ui_unhover), 0);
+		register_runtime_field(UI_MOUSE_EVENTS_COMPONENT, ECS_RUNTIME_FIELD_POINTER, offsetof(ui_events_component, on_ui_pressed), 0);
+		register_runtime_field(UI_MOUSE_EVENTS_COMPONENT, ECS_RUNTIME_FIELD_POINTER, offsetof(ui_events_component, on_ui_clicked), 0);
+		register_runtime_field(UI_MOUSE_EVENTS_COMPONENT, ECS_RUNTIME_FIELD_POINTER, offsetof(ui_events_component, on_ui_released), 0);
+
 		CE_LOG_INFO("ECS system initialized.");
 
 		return true;
 	}
 
 	void ecs_system_shutdown() {
-		for (uint i = 0; i < state_ptr->archetypes.size(); ++i) {
-
-			if (state_ptr->archetypes[i].entity_count == 0) {
-				continue;
-			}
+		ecs_command_buffer_clear(state_ptr->frame_commands);
 
-			for (uint j = 0; j < state_ptr->archetypes[i].component_sizes.size(); ++j) {
-				uint block_size = state_ptr->archetypes[i].entity_count * state_ptr->archetypes[i].component_sizes[j];	
-				void* block = state_ptr->archetypes[i].component_pool[j].data();
-				free_memory(MEMORY_TAG_ECS, block, block_size);
+		for (uint i = 0; i < state_ptr->archetypes.size(); ++i) {
+			archetype_data& arch_data = state_ptr->archetypes[i];
+			for (uint j = 0; j < arch_data.chunks.size(); ++j) {
+				free_memory_aligned(MEMORY_TAG_ECS, arch_data.chunks[j].memory, arch_data.chunk_size, ECS_CHUNK_ALIGNMENT);
 			}
 		}
 
 		state_ptr->archetypes.clear();
-		state_ptr->entites_grouped_by_archetypes.clear();
-		state_ptr->enabled_entites_grouped_by_archetypes.clear();
-		state_ptr->reusable_entities_pool = std::stack<uint>();
+		slot_map_destroy(state_ptr->entities_tracker);
+		flat_hash_map_destroy(state_ptr->query_cache);
 		state_ptr.reset();
 	}
 	
-	uint ecs_system_add_entity(archetype archetype) {
-		for (uint i = 0; i < state_ptr->archetypes[archetype].component_pool.size(); i++) {
-			uint component_size = state_ptr->archetypes[archetype].component_sizes[i];
-			void* component_blocK = allocate_memory(MEMORY_TAG_ECS, component_size);
-			zero_memory(component_blocK, component_size);
+	ecs_command_buffer& ecs_system_get_frame_commands() {
+		return state_ptr->frame_commands;
+	}
 
-			state_ptr->archetypes[archetype].component_pool[i].push_back(component_blocK);
-		}
+	void ecs_system_apply_frame_commands() {
+		ecs_command_buffer_apply(state_ptr->frame_commands);
+	}
 
-		ecs_entity_entry entity_entry;
-		uint id_entity = 0;
-		
-		if (state_ptr->reusable_entities_pool.empty()) {
-			id_entity = state_ptr->system_entities_count;
-			state_ptr->system_entities_count++;
-		}
-		else {
-			id_entity = state_ptr->reusable_entities_pool.top();
-			state_ptr->reusable_entities_pool.pop();
-		}
+	uint ecs_system_add_entity(archetype archetype) {
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
 
+		ecs_entity_entry entity_entry;
 		entity_entry.archetype = archetype;
-		entity_entry.component_index = state_ptr->archetypes[archetype].entity_count;
-		entity_entry.is_enabled = true;
-		state_ptr->archetypes[archetype].entity_count++;
-		state_ptr->entites_grouped_by_archetypes[archetype].push_back(id_entity);
-		state_ptr->enabled_entites_grouped_by_archetypes[archetype].push_back(id_entity);
+		entity_entry.component_index = arch_data.entity_count;
+		uint id_entity = slot_map_insert(state_ptr->entities_tracker, entity_entry);
 
-		state_ptr->entities_tracker.insert({ id_entity, entity_entry });
+		uint row = push_row(arch_data, id_entity, true);
+		for (uint i = 0; i < arch_data.component_sizes.size(); i++) {
+			zero_memory(get_component(arch_data, i, row), arch_data.component_sizes[i]);
+		}
+		mark_structure_changed(arch_data, arch_data.chunks.back(), true);
 		
 		return id_entity;
 	}
 
-	void ecs_system_change_entity(uint entity, archetype archetype) {
-		ecs_system_delete_entity(entity);
-		ecs_system_add_entity(archetype);
-	}
+	void ecs_system_spawn_batch(archetype archetype, uint count, uint component_count, const component_id* components, const void* const* components_data, uint* out_entities) {
+		if (archetype >= state_ptr->archetypes.size() || !state_ptr->archetypes[archetype].is_built) {
+			CE_LOG_ERROR("ecs_system_spawn_batch archetype %u is not built", archetype);
+			return;
+		}
+		if (count == 0) {
+			return;
+		}
 
-	void ecs_system_insert_data(uint entity, component_id component, void* data) {
-		ecs_entity_entry entity_entry = state_ptr->entities_tracker.at(entity);
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
 
-		/*/if (state_ptr->archetypes[entity_entry.archetype].components_tracker.find(component) == state_ptr->archetypes[entity_entry.archetype].components_tracker.end()) {
-			CE_LOG_WARNING("ecs_system_insert_data component not found in the entity %s", entity);
-			return;
-		}*/
-		uint component_index = -1;
-		std::vector<component_id> components = state_ptr->archetypes[entity_entry.archetype].components_tracker;
-		for (uint i = 0; i < components.size(); ++i) {
-			if (components[i] == component) {
-				component_index = i;
-				break;
+		// Source array of each column, nullptr for the columns that are zeroed
+		std::array<const uchar*, ECS_MAX_COMPONENTS> sources;
+		sources.fill(nullptr);
+		for (uint i = 0; i < component_count; ++i) {
+			uint column = get_column_index(arch_data, components[i]);
+			if (column != INVALID_ID) {
+				sources[column] = (const uchar*)components_data[i];
 			}
 		}
 
-		if (component_index == -1) {
-			return;
+		// Reserves every chunk and entity slot up front
+		uint needed_chunks = (arch_data.entity_count + count + arch_data.chunk_capacity - 1) / arch_data.chunk_capacity;
+		arch_data.chunks.reserve(needed_chunks);
+		while (arch_data.chunks.size() < needed_chunks) {
+			allocate_chunk(arch_data);
 		}
+		slot_map_reserve(state_ptr->entities_tracker, state_ptr->entities_tracker.count + count);
+
+		// Fills the free rows of each chunk, the rows of a chunk are contiguous in every column
+		uint spawned = 0;
+		while (spawned < count) {
+			uint row = arch_data.entity_count;
+			ecs_chunk& chunk = arch_data.chunks[row / arch_data.chunk_capacity];
+			uint chunk_row = row % arch_data.chunk_capacity;
+			uint rows = arch_data.chunk_capacity - chunk_row;
+			if (rows > count - spawned) {
+				rows = count - spawned;
+			}
 
-		//uint component_index = state_ptr->archetypes[entity_entry.archetype].components_tracker.at(component);
+			for (uint i = 0; i < arch_data.component_sizes.size(); ++i) {
+				uint component_size = arch_data.component_sizes[i];
+				uchar* destination = chunk.memory + arch_data.column_offsets[i] + component_size * chunk_row;
+				if (sources[i]) {
+					copy_memory(destination, sources[i] + (uint64)component_size * spawned, (uint64)component_size * rows);
+					resolve_runtime_fields(arch_data.components_tracker[i], component_size, destination, rows, false);
+				}
+				else {
+					zero_memory(destination, (uint64)component_size * rows);
+				}
+			}
 
-		uint size_data = state_ptr->archetypes[entity_entry.archetype].component_sizes[component_index];
-		copy_memory(state_ptr->archetypes[entity_entry.archetype].component_pool[component_index][entity_entry.component_index], data, size_data);
-	}
+			uint* chunk_entities = (uint*)(chunk.memory + arch_data.entities_offset) + chunk_row;
+			for (uint i = 0; i < rows; ++i) {
+				ecs_entity_entry entity_entry;
+				entity_entry.archetype = archetype;
+				entity_entry.component_index = row + i;
+				uint id_entity = slot_map_insert(state_ptr->entities_tracker, entity_entry);
 
-	void ecs_system_delete_entity(uint entity) {
+				chunk_entities[i] = id_entity;
+				if (out_entities) {
+					out_entities[spawned + i] = id_entity;
+				}
+			}
 
-		if (state_ptr->entities_tracker.find(entity) == state_ptr->entities_tracker.end()) {
-			return;
+			// Sets the enabled bits of the new rows a word at a time
+			uint64* chunk_enabled = (uint64*)(chunk.memory + arch_data.enabled_offset);
+			for (uint bit = chunk_row; bit < chunk_row + rows;) {
+				uint word_bits = ECS_ENABLED_MASK_BITS - bit % ECS_ENABLED_MASK_BITS;
+				if (word_bits > chunk_row + rows - bit) {
+					word_bits = chunk_row + rows - bit;
+				}
+				uint64 bits = word_bits == ECS_ENABLED_MASK_BITS ? ~0ull : ((1ull << word_bits) - 1);
+				chunk_enabled[bit / ECS_ENABLED_MASK_BITS] |= bits << (bit % ECS_ENABLED_MASK_BITS);
+				bit += word_bits;
+			}
+
+			chunk.entity_count += rows;
+			chunk.enabled_count += rows;
+			arch_data.entity_count += rows;
+			arch_data.enabled_count += rows;
+			spawned += rows;
+			mark_structure_changed(arch_data, chunk, true);
 		}
+	}
 
-		state_ptr->reusable_entities_pool.push(entity);
+	void ecs_system_spawn_resource_entities(scene_resource_data& resource_data, std::vector<uint>& out_entities) {
+		uint entity_count = (uint)resource_data.archetypes.size();
+		out_entities.assign(entity_count, INVALID_ID);
 
-		ecs_entity_entry entity_entry = state_ptr->entities_tracker.at(entity);
-		archetype archtype = entity_entry.archetype;
-		uint entity_index = entity_entry.component_index;
+		// Entities of each archetype in the order of the resource, the archetypes are built the first time they appear
+		std::vector<archetype> group_archetypes;
+		std::vector<std::vector<uint>> groups;
+		for (uint entity_index = 0; entity_index < entity_count; ++entity_index) {
+			archetype arch = resource_data.archetypes[entity_index];
 
+			uint group = 0;
+			while (group < group_archetypes.size() && group_archetypes[group] != arch) {
+				group++;
+			}
+			if (group < group_archetypes.size()) {
+				groups[group].push_back(entity_index);
+				continue;
+			}
 
-		// Get last entity of the archetype to replace the erased entity
-		
-		uint last_entity = state_ptr->entites_grouped_by_archetypes.at(entity_entry.archetype).back();
-		state_ptr->entites_grouped_by_archetypes.at(entity_entry.archetype).pop_back();
-		ecs_entity_entry& last_entity_entry = state_ptr->entities_tracker.at(last_entity);
+			// Tries to build the archetype if not exists
+			std::vector<uint> new_archetype_size;
+			std::vector<component_id> new_archetype_id;
+			std::vector<std::vector<component_data_type>> new_components_data_types;
+			for (uint component_index = 0; component_index < resource_data.components[entity_index].size(); ++component_index) {
+				component_id comp_id = resource_data.components[entity_index][component_index];
+				new_archetype_id.push_back(comp_id);
+				new_archetype_size.push_back(resource_data.components_sizes.at(comp_id));
+				new_components_data_types.push_back(resource_data.components_data_types[entity_index][component_index]);
+			}
+			ecs_system_build_archetype(arch, new_archetype_id, new_archetype_size, new_components_data_types);
 
-		for (uint i = 0; i < state_ptr->archetypes[archtype].component_pool.size(); i++) {
+			group_archetypes.push_back(arch);
+			groups.push_back({ entity_index });
+		}
 
-			uint component_size = state_ptr->archetypes[archtype].component_sizes[i];
-			void* block = state_ptr->archetypes[archtype].component_pool[i][entity_index];
-			free_memory(MEMORY_TAG_ECS, block, component_size);
+		stack_allocator* scratch = stack_allocator_get_thread_scratch();
+		std::vector<uint> spawned_entities;
+		for (uint group = 0; group < groups.size(); ++group) {
+			std::vector<uint>& rows = groups[group];
+			std::vector<component_id>& components = resource_data.components[rows[0]];
+			uint component_count = (uint)components.size();
+
+			// Gathers the components of the group in columns, so they are copied to the chunks in bulk.
+			// The groups whose entities don't list the same components, or that don't fit in the scratch, are spawned one entity at a time
+			bool gathered = scratch != nullptr;
+			for (uint i = 1; gathered && i < rows.size(); ++i) {
+				gathered = resource_data.components[rows[i]] == components;
+			}
+
+			std::vector<const void*> columns(component_count);
+			if (gathered) {
+				stack_allocator_scope scope(*scratch);
+				for (uint component_index = 0; gathered && component_index < component_count; ++component_index) {
+					uint component_size = resource_data.components_sizes.at(components[component_index]);
+					uchar* column = (uchar*)stack_allocator_allocate(*scratch, (uint64)component_size * rows.size(), ECS_COLUMN_ALIGNMENT);
+					if (column == nullptr) {
+						gathered = false;
+						break;
+					}
+
+					for (uint i = 0; i < rows.size(); ++i) {
+						copy_memory(column + (uint64)component_size * i, resource_data.components_data[rows[i]][component_index], component_size);
+					}
+					columns[component_index] = column;
+				}
 
-			// Replace the erased entity pointer with the pointer to the last entity
-			// There is a secondary effect wich is the order of the entities may vary wich at the time of render for example affects the order (thats why exists z-order)
-			state_ptr->archetypes[archtype].component_pool[i][entity_index] = state_ptr->archetypes[archtype].component_pool[i][last_entity_entry.component_index];
-			state_ptr->archetypes[archtype].component_pool[i].pop_back();
+				if (gathered) {
+					spawned_entities.resize(rows.size());
+					ecs_system_spawn_batch(group_archetypes[group], (uint)rows.size(), component_count, components.data(), columns.data(), spawned_entities.data());
+					for (uint i = 0; i < rows.size(); ++i) {
+						out_entities[rows[i]] = spawned_entities[i];
+					}
+				}
+			}
 
+			if (!gathered) {
+				for (uint entity_index : rows) {
+					std::vector<void*>& entity_data = resource_data.components_data[entity_index];
+					ecs_system_spawn_batch(group_archetypes[group], 1, (uint)resource_data.components[entity_index].size(), resource_data.components[entity_index].data(), entity_data.data(), &out_entities[entity_index]);
+				}
+			}
 		}
-		last_entity_entry.component_index = entity_index;
+	}
 
-		state_ptr->archetypes[archtype].entity_count--;
+	bool ecs_system_change_entity(uint entity, archetype archetype) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry) {
+			return false;
+		}
 
+		if (archetype >= state_ptr->archetypes.size() || !state_ptr->archetypes[archetype].is_built) {
+			CE_LOG_ERROR("ecs_system_change_entity archetype %u is not built", archetype);
+			return false;
+		}
 
-		for (uint i = 0; i < state_ptr->enabled_entites_grouped_by_archetypes.at(entity_entry.archetype).size(); ++i) {
-			if (state_ptr->enabled_entites_grouped_by_archetypes.at(entity_entry.archetype)[i] == entity) {
-				state_ptr->enabled_entites_grouped_by_archetypes[archtype].erase(state_ptr->enabled_entites_grouped_by_archetypes[archtype].begin() + i);
-				break;
-			}
+		if (found_entry->archetype != archetype) {
+			migrate_entity(entity, *found_entry, archetype);
 		}
+		return true;
+	}
 
-		for (uint i = 0; i < state_ptr->entites_grouped_by_archetypes.at(entity_entry.archetype).size(); ++i) {
-			if (state_ptr->entites_grouped_by_archetypes.at(entity_entry.archetype)[i] == entity) {
-				state_ptr->entites_grouped_by_archetypes[archtype].erase(state_ptr->entites_grouped_by_archetypes[archtype].begin() + i);
-				state_ptr->entites_grouped_by_archetypes[archtype].insert(state_ptr->entites_grouped_by_archetypes[archtype].begin() + i, last_entity);
+	bool ecs_system_add_component(uint entity, component_id component, const void* data) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry || (uint)component >= ECS_MAX_COMPONENTS) {
+			return false;
+		}
 
-				break;
+		archetype_data& arch_data = state_ptr->archetypes[found_entry->archetype];
+		if (!(arch_data.signature & (1u << component))) {
+			uint target = get_transition(found_entry->archetype, component, true);
+			if (target == ECS_TRANSITION_NONE) {
+				CE_LOG_ERROR("ecs_system_add_component there is no archetype with the components of archetype %u and component %u", found_entry->archetype, component);
+				return false;
 			}
+			migrate_entity(entity, *found_entry, (archetype)target);
+		}
+
+		if (data) {
+			ecs_system_insert_data(entity, component, (void*)data);
+		}
+		return true;
+	}
+
+	bool ecs_system_remove_component(uint entity, component_id component) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry || (uint)component >= ECS_MAX_COMPONENTS) {
+			return false;
 		}
 
+		archetype_data& arch_data = state_ptr->archetypes[found_entry->archetype];
+		if (!(arch_data.signature & (1u << component))) {
+			return true;
+		}
 
-		state_ptr->entities_tracker.erase(entity);
-		state_ptr->system_entities_count--;
+		uint target = get_transition(found_entry->archetype, component, false);
+		if (target == ECS_TRANSITION_NONE) {
+			CE_LOG_ERROR("ecs_system_remove_component there is no archetype with the components of archetype %u without component %u", found_entry->archetype, component);
+			return false;
+		}
+		migrate_entity(entity, *found_entry, (archetype)target);
+		return true;
 	}
 
-	void ecs_system_enable_entity(uint entity, bool enabled) {
-		if (state_ptr->entities_tracker.find(entity) == state_ptr->entities_tracker.end()) {
+	void ecs_system_insert_data(uint entity, component_id component, void* data) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry) {
+			return;
+		}
+		ecs_entity_entry entity_entry = *found_entry;
+		archetype_data& arch_data = state_ptr->archetypes[entity_entry.archetype];
+
+		uint component_index = get_column_index(arch_data, component);
+		if (component_index == INVALID_ID) {
 			return;
 		}
 
-		ecs_entity_entry& entity_entry = state_ptr->entities_tracker.at(entity);
+		uchar* component_data = get_component(arch_data, component_index, entity_entry.component_index);
+		copy_memory(component_data, data, arch_data.component_sizes[component_index]);
+		resolve_runtime_fields(component, arch_data.component_sizes[component_index], component_data, 1, false);
+		mark_columns_changed(arch_data, arch_data.chunks[entity_entry.component_index / arch_data.chunk_capacity], 1u << component);
+	}
+
+	void ecs_system_delete_entity(uint entity) {
 
-		if (enabled == true && entity_entry.is_enabled == false) {
-			state_ptr->enabled_entites_grouped_by_archetypes[entity_entry.archetype].insert(state_ptr->enabled_entites_grouped_by_archetypes.at(entity_entry.archetype).begin(), entity);
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry) {
+			return;
 		}
-		else {
-			for (uint i = 0; i < state_ptr->enabled_entites_grouped_by_archetypes[entity_entry.archetype].size(); ++i) {
-				if (state_ptr->enabled_entites_grouped_by_archetypes.at(entity_entry.archetype)[i] == entity && enabled == false) {
-					state_ptr->enabled_entites_grouped_by_archetypes.at(entity_entry.archetype).erase(state_ptr->enabled_entites_grouped_by_archetypes.at(entity_entry.archetype).begin() + i);
-					break;
-				}
-			}
+
+		archetype_data& arch_data = state_ptr->archetypes[found_entry->archetype];
+		remove_row(arch_data, found_entry->component_index);
+
+		slot_map_remove(state_ptr->entities_tracker, entity);
+	}
+
+	void ecs_system_enable_entity(uint entity, bool enabled) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry) {
+			return;
 		}
 
-		entity_entry.is_enabled = enabled;
+		archetype_data& arch_data = state_ptr->archetypes[found_entry->archetype];
+		if (set_row_enabled(arch_data, found_entry->component_index, enabled)) {
+			mark_structure_changed(arch_data, arch_data.chunks[found_entry->component_index / arch_data.chunk_capacity], false);
+		}
 	}
 
 	void ecs_system_build_archetype(archetype archetype, std::vector<component_id>& components_id, std::vector<uint>& components_sizes, std::vector<std::vector<component_data_type>>& components_data_types) {
@@ -286,17 +897,37 @@ namespace caliope {
 			return;
 		}
 		
-		if (state_ptr->entites_grouped_by_archetypes.find(archetype) != state_ptr->entites_grouped_by_archetypes.end()) {
+		if (archetype < state_ptr->archetypes.size() && state_ptr->archetypes[archetype].is_built) {
+			return;
+		}
+
+		if (archetype >= ECS_MAX_ARCHETYPES) {
+			CE_LOG_ERROR("ecs_system_build_archetype archetype %u is out of range", archetype);
 			return;
 		}
 
-		archetype_data arch_data;
+		for (uint i = 0; i < components_id.size(); ++i) {
+			if (components_id[i] >= ECS_MAX_COMPONENTS) {
+				CE_LOG_ERROR("ecs_system_build_archetype component id %u is out of the signature range", components_id[i]);
+				return;
+			}
+		}
+
+		if (archetype >= state_ptr->archetypes.size()) {
+			state_ptr->archetypes.resize(archetype + 1);
+		}
+
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		uint row_size = sizeof(uint);
+		arch_data.signature = 0;
+		arch_data.columns_by_component.fill(INVALID_ID);
 		for (uint i = 0; i < components_sizes.size(); ++i) {
 			arch_data.component_sizes.push_back(components_sizes[i]);
 			arch_data.components_tracker.push_back(components_id[i]);
-			
-			std::vector<void*> component_pool;
-			arch_data.component_pool.push_back(component_pool);
+			arch_data.columns_by_component[components_id[i]] = i;
+			arch_data.signature |= 1u << components_id[i];
+			arch_data.column_offsets.push_back(0);
+			row_size += components_sizes[i];
 
 			std::vector<component_data_type> component_types;
 			for (uint j = 0; j < components_data_types[i].size(); ++j) {
@@ -305,50 +936,493 @@ namespace caliope {
 
 			state_ptr->components_data_types.insert({ components_id[i], component_types });
 		}
+
+		// Fit as many entities as possible in a chunk, the columns padding can take a few of them
+		uint capacity = ECS_CHUNK_SIZE / row_size;
+		while (capacity > 1 && layout_chunk(arch_data, capacity) > ECS_CHUNK_SIZE) {
+			capacity--;
+		}
+		if (capacity == 0) {
+			// NOTE: The entity doesn't fit in a chunk, the chunks of this archetype are bigger and hold a single entity
+			capacity = 1;
+		}
+		arch_data.chunk_capacity = capacity;
+		arch_data.chunk_size = align_offset(layout_chunk(arch_data, capacity), ECS_CHUNK_ALIGNMENT);
+		if (arch_data.chunk_size < ECS_CHUNK_SIZE) {
+			arch_data.chunk_size = ECS_CHUNK_SIZE;
+		}
 		arch_data.entity_count = 0;
-		state_ptr->archetypes.insert(state_ptr->archetypes.begin() + archetype, arch_data);
-		state_ptr->entites_grouped_by_archetypes.insert({ archetype, std::vector<uint>() });
+		arch_data.enabled_count = 0;
+		arch_data.is_built = true;
+
+		// The new archetype can be the missing transition of the others
+		for (archetype_data& other_data : state_ptr->archetypes) {
+			other_data.add_transitions.fill(ECS_TRANSITION_UNRESOLVED);
+			other_data.remove_transitions.fill(ECS_TRANSITION_UNRESOLVED);
+		}
+
+		// The cached queries that match the new archetype start iterating it too
+		for (auto [key, archetypes] : state_ptr->query_cache) {
+			uint signature = (uint)key;
+			uint exclude_signature = (uint)(key >> 32);
+			if ((arch_data.signature & signature) == signature && !(arch_data.signature & exclude_signature)) {
+				archetypes.push_back(archetype);
+			}
+		}
+	}
+
+	std::vector<archetype>& ecs_system_query_archetypes(uint signature, uint exclude_signature) {
+		uint64 key = ((uint64)exclude_signature << 32) | signature;
+		std::vector<archetype>* archetypes = flat_hash_map_find(state_ptr->query_cache, key);
+		if (archetypes) {
+			return *archetypes;
+		}
+
+		archetypes = flat_hash_map_insert(state_ptr->query_cache, key, std::vector<archetype>());
+		for (uint i = 0; i < state_ptr->archetypes.size(); ++i) {
+			archetype_data& arch_data = state_ptr->archetypes[i];
+			if (arch_data.is_built && (arch_data.signature & signature) == signature && !(arch_data.signature & exclude_signature)) {
+				archetypes->push_back((archetype)i);
+			}
+		}
+		return *archetypes;
 	}
 
-	std::vector<uint>& ecs_system_get_entities_by_archetype(archetype archetype){
-		return state_ptr->enabled_entites_grouped_by_archetypes[archetype];
+	uint ecs_system_get_enabled_entity_count(archetype archetype) {
+		if (archetype >= state_ptr->archetypes.size()) {
+			return 0;
+		}
+		return state_ptr->archetypes[archetype].enabled_count;
 	}
 
 	void* ecs_system_get_component_data(uint entity, component_id component, uint64& out_component_size){
 
-		if (state_ptr->entities_tracker.find(entity) == state_ptr->entities_tracker.end()) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry) {
 			return nullptr;
 		}
 
-		ecs_entity_entry entity_entry = state_ptr->entities_tracker.at(entity);
-		uint component_index = -1;
-		std::vector<component_id> components = state_ptr->archetypes[entity_entry.archetype].components_tracker;
-		for (uint i = 0; i < components.size(); ++i) {
-			if (components[i] == component) {
-				component_index = i;
-			}
-		}
-		if (component_index == -1) {
-			return 0;
+		ecs_entity_entry& entity_entry = *found_entry;
+		archetype_data& arch_data = state_ptr->archetypes[entity_entry.archetype];
+		uint component_index = get_column_index(arch_data, component);
+		if (component_index == INVALID_ID) {
+			return nullptr;
 		}
 		
-		out_component_size = state_ptr->archetypes[entity_entry.archetype].component_sizes[component_index];
+		out_component_size = arch_data.component_sizes[component_index];
 
-		return state_ptr->archetypes[entity_entry.archetype].component_pool[component_index][entity_entry.component_index];
+		return get_component(arch_data, component_index, entity_entry.component_index);
+	}
+
+	bool ecs_system_is_entity_alive(uint entity) {
+		return slot_map_contains(state_ptr->entities_tracker, entity);
 	}
 
 	std::vector<component_id>& ecs_system_get_entity_components(uint entity) {
-		ecs_entity_entry entity_entry = state_ptr->entities_tracker.at(entity);
-		return state_ptr->archetypes[entity_entry.archetype].components_tracker;
+		static std::vector<component_id> no_components;
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry) {
+			no_components.clear();
+			return no_components;
+		}
+
+		return state_ptr->archetypes[found_entry->archetype].components_tracker;
 	}
 
 	archetype ecs_system_get_entity_archetype(uint entity) {
-		ecs_entity_entry entity_entry = state_ptr->entities_tracker.at(entity);
-		return entity_entry.archetype;
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry) {
+			return (archetype)INVALID_ID;
+		}
+
+		return found_entry->archetype;
 	}
 	
 	std::vector<component_data_type>& ecs_system_get_component_data_types(component_id component)
 	{
 		 return state_ptr->components_data_types.at(component);
 	}
+
+	uint ecs_system_get_chunk_count(archetype archetype) {
+		if (archetype >= state_ptr->archetypes.size()) {
+			return 0;
+		}
+		return (uint)state_ptr->archetypes[archetype].chunks.size();
+	}
+
+	uint ecs_system_get_chunk_entity_count(archetype archetype, uint chunk) {
+		return state_ptr->archetypes[archetype].chunks[chunk].entity_count;
+	}
+
+	void* ecs_system_get_chunk_component_data(archetype archetype, uint chunk, component_id component) {
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		uint column_index = get_column_index(arch_data, component);
+		return column_index == INVALID_ID ? nullptr : arch_data.chunks[chunk].memory + arch_data.column_offsets[column_index];
+	}
+
+	uint* ecs_system_get_chunk_entities(archetype archetype, uint chunk) {
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		return (uint*)(arch_data.chunks[chunk].memory + arch_data.entities_offset);
+	}
+
+	uint64* ecs_system_get_chunk_enabled_mask(archetype archetype, uint chunk) {
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		return (uint64*)(arch_data.chunks[chunk].memory + arch_data.enabled_offset);
+	}
+
+	uint ecs_system_get_chunk_enabled_count(archetype archetype, uint chunk) {
+		return state_ptr->archetypes[archetype].chunks[chunk].enabled_count;
+	}
+
+	ecs_column ecs_system_get_column(archetype archetype, component_id component) {
+		ecs_column column;
+		column.archetype = archetype;
+		column.index = INVALID_ID;
+		column.offset = 0;
+		column.component_size = 0;
+
+		if (archetype >= state_ptr->archetypes.size() || !state_ptr->archetypes[archetype].is_built) {
+			return column;
+		}
+
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		column.index = get_column_index(arch_data, component);
+		if (column.index != INVALID_ID) {
+			column.offset = arch_data.column_offsets[column.index];
+			column.component_size = arch_data.component_sizes[column.index];
+		}
+		return column;
+	}
+
+	void* ecs_system_get_chunk_column_data(ecs_column& column, uint chunk) {
+		return state_ptr->archetypes[column.archetype].chunks[chunk].memory + column.offset;
+	}
+
+	void* ecs_system_get_entity_column_data(uint entity, ecs_column& column) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry || found_entry->archetype != column.archetype || column.index == INVALID_ID) {
+			return nullptr;
+		}
+
+		archetype_data& arch_data = state_ptr->archetypes[column.archetype];
+		ecs_chunk& chunk = arch_data.chunks[found_entry->component_index / arch_data.chunk_capacity];
+		return chunk.memory + column.offset + column.component_size * (found_entry->component_index % arch_data.chunk_capacity);
+	}
+
+	uint64 ecs_system_get_version() {
+		return state_ptr->version;
+	}
+
+	void ecs_system_mark_chunk_changed(archetype archetype, uint chunk, uint signature) {
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		mark_columns_changed(arch_data, arch_data.chunks[chunk], signature);
+	}
+
+	void ecs_system_mark_entity_changed(uint entity, component_id component) {
+		ecs_entity_entry* found_entry = slot_map_get(state_ptr->entities_tracker, entity);
+		if (!found_entry || (uint)component >= ECS_MAX_COMPONENTS) {
+			return;
+		}
+
+		archetype_data& arch_data = state_ptr->archetypes[found_entry->archetype];
+		mark_columns_changed(arch_data, arch_data.chunks[found_entry->component_index / arch_data.chunk_capacity], 1u << component);
+	}
+
+	bool ecs_system_is_chunk_changed(archetype archetype, uint chunk, uint signature, uint64 version) {
+		archetype_data& arch_data = state_ptr->archetypes[archetype];
+		ecs_chunk& chunk_data = arch_data.chunks[chunk];
+		if (chunk_data.structure_version > version) {
+			return true;
+		}
+
+		for (uint i = 0; i < arch_data.components_tracker.size(); ++i) {
+			if ((signature & (1u << arch_data.components_tracker[i])) && chunk_data.column_versions[i] > version) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	uint64 ecs_system_get_snapshot_size() {
+		ecs_snapshot_writer writer = { nullptr, 0 };
+		write_snapshot(writer);
+		return writer.size;
+	}
+
+	bool ecs_system_write_snapshot(void* buffer, uint64 buffer_size) {
+		uint64 size = ecs_system_get_snapshot_size();
+		if (buffer_size < size || ((uint64)buffer % ECS_COLUMN_ALIGNMENT) != 0) {
+			CE_LOG_ERROR("ecs_system_write_snapshot the buffer must be %llu bytes and 16 bytes aligned", size);
+			return false;
+		}
+
+		// The padding between the blobs is zeroed so the same world always gives the same bytes
+		zero_memory(buffer, size);
+		ecs_snapshot_writer writer = { (uchar*)buffer, 0 };
+		write_snapshot(writer);
+		return true;
+	}
+
+	bool ecs_system_restore_snapshot(const void* snapshot, uint64 snapshot_size) {
+		const uchar* data = (const uchar*)snapshot;
+		if (((uint64)data % ECS_COLUMN_ALIGNMENT) != 0 || snapshot_size < sizeof(ecs_snapshot_header)) {
+			CE_LOG_ERROR("ecs_system_restore_snapshot the snapshot is not aligned or too small");
+			return false;
+		}
+
+		const ecs_snapshot_header& header = *(const ecs_snapshot_header*)data;
+		if (header.magic != ECS_SNAPSHOT_MAGIC || header.format_version != ECS_SNAPSHOT_FORMAT_VERSION || header.entry_size != sizeof(ecs_entity_entry) || header.size != snapshot_size) {
+			CE_LOG_ERROR("ecs_system_restore_snapshot the snapshot is corrupted or from another version");
+			return false;
+		}
+
+		if (header.slot_count > SLOT_MAP_MAX_SLOTS || header.entity_count > header.slot_count ||
+			!snapshot_range_valid(header.archetypes_offset, sizeof(ecs_snapshot_archetype) * (uint64)header.archetype_count, snapshot_size) ||
+			!snapshot_range_valid(header.slots_offset, sizeof(slot_map_slot) * (uint64)header.slot_count, snapshot_size) ||
+			!snapshot_range_valid(header.handles_offset, sizeof(slot_map_handle) * (uint64)header.entity_count, snapshot_size) ||
+			!snapshot_range_valid(header.entries_offset, sizeof(ecs_entity_entry) * (uint64)header.entity_count, snapshot_size)) {
+			CE_LOG_ERROR("ecs_system_restore_snapshot the snapshot is corrupted");
+			return false;
+		}
+
+		// Checks every archetype and the slot map before the world is touched
+		const ecs_snapshot_archetype* records = (const ecs_snapshot_archetype*)(data + header.archetypes_offset);
+		const slot_map_slot* slots = (const slot_map_slot*)(data + header.slots_offset);
+		const slot_map_handle* handles = (const slot_map_handle*)(data + header.handles_offset);
+		const ecs_entity_entry* entries = (const ecs_entity_entry*)(data + header.entries_offset);
+		std::vector<bool> restored_archetypes(ECS_MAX_ARCHETYPES, false);
+		std::vector<bool> used_slots(header.slot_count, false);
+		std::vector<bool> used_entries(header.entity_count, false);
+		uint64 entity_count = 0;
+		for (uint i = 0; i < header.archetype_count; ++i) {
+			const ecs_snapshot_archetype& record = records[i];
+			const ecs_snapshot_component* components = (const ecs_snapshot_component*)(data + record.components_offset);
+			bool valid = record.archetype < ECS_MAX_ARCHETYPES && !restored_archetypes[record.archetype] &&
+				record.component_count > 0 && record.component_count <= ECS_MAX_COMPONENTS &&
+				snapshot_range_valid(record.components_offset, sizeof(ecs_snapshot_component) * (uint64)record.component_count, snapshot_size) &&
+				snapshot_range_valid(record.entities_offset, sizeof(uint) * (uint64)record.entity_count, snapshot_size) &&
+				snapshot_range_valid(record.enabled_offset, sizeof(uint64) * (((uint64)record.entity_count + ECS_ENABLED_MASK_BITS - 1) / ECS_ENABLED_MASK_BITS), snapshot_size);
+			uint signature = 0;
+			for (uint c = 0; valid && c < record.component_count; ++c) {
+				valid = components[c].component < ECS_MAX_COMPONENTS && !(signature & (1u << components[c].component)) &&
+					snapshot_range_valid(components[c].data_types_offset, sizeof(uint) * (uint64)components[c].data_type_count, snapshot_size) &&
+					snapshot_range_valid(components[c].runtime_fields_offset, sizeof(ecs_runtime_field) * (uint64)components[c].runtime_field_count, snapshot_size) &&
+					snapshot_range_valid(components[c].column_offset, (uint64)components[c].size * record.entity_count, snapshot_size);
+
+				const uint* data_types = (const uint*)(data + components[c].data_types_offset);
+				for (uint j = 0; valid && j < components[c].data_type_count; ++j) {
+					valid = data_types[j] <= COMPONENT_DATA_TYPE_FLOAT;
+				}
+				signature |= valid ? 1u << components[c].component : 0;
+			}
+			if (!valid) {
+				CE_LOG_ERROR("ecs_system_restore_snapshot archetype %u of the snapshot is corrupted", record.archetype);
+				return false;
+			}
+			restored_archetypes[record.archetype] = true;
+
+			// Each row must hold a live handle of the slot map whose entry points back to the row
+			const uint* record_entities = (const uint*)(data + record.entities_offset);
+			for (uint row = 0; valid && row < record.entity_count; ++row) {
+				slot_map_handle handle = record_entities[row];
+				uint index = slot_map_internal::handle_index(handle);
+				uint dense_index = index < header.slot_count ? slots[index].index : INVALID_ID;
+				valid = dense_index < header.entity_count && !used_entries[dense_index] &&
+					slots[index].generation == slot_map_internal::handle_generation(handle) && handles[dense_index] == handle &&
+					entries[dense_index].archetype == record.archetype && entries[dense_index].component_index == row;
+				if (valid) {
+					used_entries[dense_index] = true;
+					used_slots[index] = true;
+				}
+			}
+			if (!valid) {
+				CE_LOG_ERROR("ecs_system_restore_snapshot the entities of archetype %u don't match the slot map of the snapshot", record.archetype);
+				return false;
+			}
+
+			// The runtime fields are resolved again with the table of this build, the snapshot must have been taken with the same one
+			bool same_runtime_fields = true;
+			for (uint c = 0; same_runtime_fields && c < record.component_count; ++c) {
+				std::vector<ecs_runtime_field>& runtime_fields = state_ptr->runtime_fields[components[c].component];
+				const ecs_runtime_field* snapshot_runtime_fields = (const ecs_runtime_field*)(data + components[c].runtime_fields_offset);
+				same_runtime_fields = runtime_fields.size() == components[c].runtime_field_count;
+				for (uint j = 0; same_runtime_fields && j < components[c].runtime_field_count; ++j) {
+					same_runtime_fields = runtime_fields[j].type == snapshot_runtime_fields[j].type && runtime_fields[j].offset == snapshot_runtime_fields[j].offset && runtime_fields[j].source_offset == snapshot_runtime_fields[j].source_offset;
+				}
+			}
+			if (!same_runtime_fields) {
+				CE_LOG_ERROR("ecs_system_restore_snapshot archetype %u has other runtime fields than in the snapshot", record.archetype);
+				return false;
+			}
+
+			if (record.archetype < state_ptr->archetypes.size() && state_ptr->archetypes[record.archetype].is_built) {
+				archetype_data& arch_data = state_ptr->archetypes[record.archetype];
+				bool same_schema = arch_data.components_tracker.size() == record.component_count;
+				for (uint c = 0; same_schema && c < record.component_count; ++c) {
+					same_schema = arch_data.components_tracker[c] == components[c].component && arch_data.component_sizes[c] == components[c].size;
+				}
+				if (!same_schema) {
+					CE_LOG_ERROR("ecs_system_restore_snapshot archetype %u has other components than in the snapshot", record.archetype);
+					return false;
+				}
+			}
+			entity_count += record.entity_count;
+		}
+		if (entity_count != header.entity_count) {
+			CE_LOG_ERROR("ecs_system_restore_snapshot the snapshot is corrupted");
+			return false;
+		}
+
+		// The rest of the slots must be the free list from free_head to free_tail, the next insert takes slots[free_head]
+		uint free_count = 0;
+		uint free_last = INVALID_ID;
+		bool valid_free_list = true;
+		for (uint index = header.free_head; index != INVALID_ID; index = slots[index].index) {
+			if (index >= header.slot_count || used_slots[index] || slots[index].generation > SLOT_MAP_GENERATION_MASK) {
+				valid_free_list = false;
+				break;
+			}
+			used_slots[index] = true;
+			free_last = index;
+			free_count++;
+		}
+		if (!valid_free_list || free_count != header.slot_count - header.entity_count || free_last != header.free_tail) {
+			CE_LOG_ERROR("ecs_system_restore_snapshot the free slots of the snapshot are corrupted");
+			return false;
+		}
+
+		// NOTE: The checks above cover every failure of ecs_system_build_archetype, so the world is only touched from here
+		// Builds the archetypes of the snapshot that this world doesn't have from the schema
+		for (uint i = 0; i < header.archetype_count; ++i) {
+			const ecs_snapshot_archetype& record = records[i];
+			if (record.archetype < state_ptr->archetypes.size() && state_ptr->archetypes[record.archetype].is_built) {
+				continue;
+			}
+
+			const ecs_snapshot_component* components = (const ecs_snapshot_component*)(data + record.components_offset);
+			std::vector<component_id> components_id;
+			std::vector<uint> components_sizes;
+			std::vector<std::vector<component_data_type>> components_data_types;
+			for (uint c = 0; c < record.component_count; ++c) {
+				const uint* data_types = (const uint*)(data + components[c].data_types_offset);
+				components_id.push_back((component_id)components[c].component);
+				components_sizes.push_back(components[c].size);
+				components_data_types.push_back(std::vector<component_data_type>());
+				for (uint j = 0; j < components[c].data_type_count; ++j) {
+					components_data_types[c].push_back((component_data_type)data_types[j]);
+				}
+			}
+			ecs_system_build_archetype((archetype)record.archetype, components_id, components_sizes, components_data_types);
+		}
+
+		// Drops the current world, the pending commands point to its entities
+		ecs_command_buffer_clear(state_ptr->frame_commands);
+		for (archetype_data& arch_data : state_ptr->archetypes) {
+			for (ecs_chunk& chunk : arch_data.chunks) {
+				free_memory_aligned(MEMORY_TAG_ECS, chunk.memory, arch_data.chunk_size, ECS_CHUNK_ALIGNMENT);
+			}
+			arch_data.chunks.clear();
+			arch_data.entity_count = 0;
+			arch_data.enabled_count = 0;
+		}
+
+		// The slot map is restored as it was, so the handles of the snapshot are valid and the next inserts give the same ids
+		slot_map<ecs_entity_entry>& entities = state_ptr->entities_tracker;
+		slot_map_reserve(entities, header.slot_count);
+		if (header.slot_count) {
+			copy_memory(entities.slots, data + header.slots_offset, sizeof(slot_map_slot) * (uint64)header.slot_count);
+		}
+		if (header.entity_count) {
+			copy_memory(entities.handles, data + header.handles_offset, sizeof(slot_map_handle) * (uint64)header.entity_count);
+			copy_memory(entities.values, data + header.entries_offset, sizeof(ecs_entity_entry) * (uint64)header.entity_count);
+		}
+		entities.slot_count = header.slot_count;
+		entities.count = header.entity_count;
+		entities.free_head = header.free_head;
+		entities.free_tail = header.free_tail;
+
+		for (uint i = 0; i < header.archetype_count; ++i) {
+			const ecs_snapshot_archetype& record = records[i];
+			const ecs_snapshot_component* components = (const ecs_snapshot_component*)(data + record.components_offset);
+			archetype_data& arch_data = state_ptr->archetypes[record.archetype];
+
+			// One copy per column of each chunk
+			for (uint first_row = 0; first_row < record.entity_count; first_row += arch_data.chunk_capacity) {
+				uint rows = record.entity_count - first_row < arch_data.chunk_capacity ? record.entity_count - first_row : arch_data.chunk_capacity;
+				ecs_chunk& chunk = allocate_chunk(arch_data);
+				for (uint c = 0; c < record.component_count; ++c) {
+					uchar* column = chunk.memory + arch_data.column_offsets[c];
+					copy_memory(column, data + components[c].column_offset + (uint64)components[c].size * first_row, (uint64)components[c].size * rows);
+					resolve_runtime_fields((component_id)components[c].component, components[c].size, column, rows, true);
+				}
+				copy_memory(chunk.memory + arch_data.entities_offset, data + record.entities_offset + sizeof(uint) * (uint64)first_row, sizeof(uint) * (uint64)rows);
+				chunk.entity_count = rows;
+			}
+			arch_data.entity_count = record.entity_count;
+
+			ecs_for_each_enabled((const uint64*)(data + record.enabled_offset), record.entity_count, [&](uint row) {
+				set_row_enabled(arch_data, row, true);
+			});
+
+			// The caches built before the restore see every chunk as changed
+			for (ecs_chunk& chunk : arch_data.chunks) {
+				mark_structure_changed(arch_data, chunk, true);
+			}
+		}
+
+		// The systems resolve the runtime fields of their components again, i.e. the textures of the UI buttons
+		event_fire(EVENT_CODE_ON_ECS_SNAPSHOT_RESTORED, 0);
+
+		return true;
+	}
+
+	bool ecs_system_save_snapshot(std::string& path) {
+		uint64 size = ecs_system_get_snapshot_size();
+		void* snapshot = allocate_memory_aligned(MEMORY_TAG_ECS, size, ECS_COLUMN_ALIGNMENT);
+		bool saved = ecs_system_write_snapshot(snapshot, size);
+
+		file_handle handle;
+		if (saved && file_system_open(path, FILE_MODE_WRITE, handle)) {
+			saved = file_system_write_bytes(handle, size, snapshot);
+			file_system_close(handle);
+		}
+		else {
+			saved = false;
+		}
+
+		if (!saved) {
+			CE_LOG_ERROR("ecs_system_save_snapshot couldn't save the snapshot %s", path.c_str());
+		}
+		free_memory_aligned(MEMORY_TAG_ECS, snapshot, size, ECS_COLUMN_ALIGNMENT);
+		return saved;
+	}
+
+	bool ecs_system_load_snapshot(std::string& path) {
+		file_handle handle;
+		uint64 size = 0;
+		if (!file_system_open(path, FILE_MODE_READ, handle)) {
+			CE_LOG_ERROR("ecs_system_load_snapshot couldn't open the snapshot %s", path.c_str());
+			return false;
+		}
+		if (!file_system_size(handle, size) || size == 0) {
+			CE_LOG_ERROR("ecs_system_load_snapshot couldn't read the snapshot %s", path.c_str());
+			file_system_close(handle);
+			return false;
+		}
+
+		// NOTE: One read of the whole file, then the restore copies the columns straight from it
+		void* snapshot = allocate_memory_aligned(MEMORY_TAG_ECS, size, ECS_COLUMN_ALIGNMENT);
+		uint64 read_bytes = 0;
+		bool loaded = file_system_read_all_bytes(handle, snapshot, size, read_bytes) && read_bytes == size;
+		file_system_close(handle);
+
+		if (loaded) {
+			loaded = ecs_system_restore_snapshot(snapshot, size);
+		}
+		else {
+			CE_LOG_ERROR("ecs_system_load_snapshot couldn't read the snapshot %s", path.c_str());
+		}
+		free_memory_aligned(MEMORY_TAG_ECS, snapshot, size, ECS_COLUMN_ALIGNMENT);
+		return loaded;
+	}
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include "defines.h"
 #include "components/components.inl"
 
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
 namespace caliope {
 
 	typedef enum archetype {
@@ -32,6 +36,39 @@ namespace caliope {
 		UI_CONTAINER_COMPONENT,
 	} component_id;
 
+	// The archetypes and the queries keep a bit per component in a uint signature
+	#define ECS_MAX_COMPONENTS 32
+	// The archetypes are indexed by id, the ids of the custom archetypes must be smaller
+	#define ECS_MAX_ARCHETYPES 256
+
+	// The enabled state of the entities of a chunk is a bitmask, the bit of a row is row % 64 of the word row / 64
+	#define ECS_ENABLED_MASK_BITS 64
+
+	inline bool ecs_is_entity_enabled(const uint64* enabled_mask, uint row) {
+		return (enabled_mask[row / ECS_ENABLED_MASK_BITS] >> (row % ECS_ENABLED_MASK_BITS)) & 1;
+	}
+
+	/*
+	 *  @brief Calls function(row) for every enabled row of a chunk, the words without enabled rows are skipped whole.
+	 */
+	template<typename F>
+	void ecs_for_each_enabled(const uint64* enabled_mask, uint entity_count, F&& function) {
+		uint word_count = (entity_count + ECS_ENABLED_MASK_BITS - 1) / ECS_ENABLED_MASK_BITS;
+		for (uint word_index = 0; word_index < word_count; ++word_index) {
+			uint64 word = enabled_mask[word_index];
+			while (word) {
+#ifdef _MSC_VER
+				unsigned long bit;
+				_BitScanForward64(&bit, word);
+#else
+				uint bit = (uint)__builtin_ctzll(word);
+#endif
+				function(word_index * ECS_ENABLED_MASK_BITS + (uint)bit);
+				word &= word - 1;
+			}
+		}
+	}
+
 	typedef enum component_data_type {
 		COMPONENT_DATA_TYPE_STRING = 0,
 		COMPONENT_DATA_TYPE_VEC4,
@@ -41,11 +78,60 @@ namespace caliope {
 		COMPONENT_DATA_TYPE_FLOAT
 	} component_data_type;
 
-	bool ecs_system_initialize();
-	void ecs_system_shutdown();
+	/*
+	 *  @brief Column of a component in the chunks of an archetype. Resolved once with ecs_system_get_column, then the hot loops index the column directly.
+	 *  index is INVALID_ID if the archetype doesn't have the component.
+	 */
+	typedef struct ecs_column {
+		archetype archetype;
+		uint index;
+		uint offset;
+		uint component_size;
+	} ecs_column;
+
+	struct ecs_command_buffer;
+	struct scene_resource_data;
 
+	CE_API bool ecs_system_initialize();
+	CE_API void ecs_system_shutdown();
+
+	/*
+	 *  @brief Command buffer applied once per frame by the application after the program update, the job threads and the scheduled systems record their structural changes on it.
+	 *  See systems/ecs_command_buffer.h
+	 */
+	CE_API ecs_command_buffer& ecs_system_get_frame_commands();
+	void ecs_system_apply_frame_commands();
+
+	/*
+	 *  @brief The entities are generational handles, once an entity is deleted its id is stale and the functions ignore it, also after its slot is reused by a new entity.
+	 */
 	CE_API uint ecs_system_add_entity(archetype archetype);
-	CE_API void ecs_system_change_entity(uint entity, archetype archetype);
+
+	/*
+	 *  @brief Adds count entities of archetype at once, the chunks and the entity slots are reserved once and each column is copied in bulk.
+	 *  @param components_data One array of count components per component of components, with the component size of the archetype. The components of the archetype that are not given are zeroed.
+	 *  @param out_entities Optional, gets the count new entities in the order of the data.
+	 */
+	CE_API void ecs_system_spawn_batch(archetype archetype, uint count, uint component_count, const component_id* components, const void* const* components_data, uint* out_entities);
+	/*
+	 *  @brief Builds the archetypes of a loaded scene or UI layout and spawns its entities with ecs_system_spawn_batch, one batch per archetype.
+	 *  out_entities gets the new entity of each entity of the resource, in the order of the resource, INVALID_ID for the entities that couldn't be spawned.
+	 */
+	CE_API void ecs_system_spawn_resource_entities(scene_resource_data& resource_data, std::vector<uint>& out_entities);
+	/*
+	 *  @brief Moves the entity to another archetype keeping its id and enabled state. The components shared by both archetypes are copied, the new ones are zeroed and the rest are dropped.
+	 *  Returns false if the entity is stale or the archetype is not built.
+	 */
+	CE_API bool ecs_system_change_entity(uint entity, archetype archetype);
+	/*
+	 *  @brief Migrates the entity to the built archetype that has its components plus or minus component, i.e. a sprite that starts emitting light.
+	 *  The archetype reached by each transition is cached, so the next migrations only copy the components.
+	 *  @param data Optional, the data of the added component, it's zeroed if nullptr. If the entity already has the component the data is just inserted.
+	 *  @note The archetypes are not created on the fly, the transition fails if no archetype with the resulting components has been built.
+	 */
+	CE_API bool ecs_system_add_component(uint entity, component_id component, const void* data);
+	CE_API bool ecs_system_remove_component(uint entity, component_id component);
+	// The name ids cached in the components, i.e. the material_id of a material_component, are derived from their names by the spawns and the inserts
 	CE_API void ecs_system_insert_data(uint entity, component_id component, void* data);
 	CE_API void ecs_system_delete_entity(uint entity);
 	CE_API void ecs_system_enable_entity(uint entity, bool enabled);
@@ -55,9 +141,64 @@ namespace caliope {
 	 */
 	CE_API void ecs_system_build_archetype(archetype archetype, std::vector<component_id>& components_id, std::vector<uint>& components_sizes, std::vector<std::vector<component_data_type>>& components_data_types);
 
-	CE_API std::vector<uint>& ecs_system_get_entities_by_archetype(archetype archetype);
+	CE_API bool ecs_system_is_entity_alive(uint entity);
+	CE_API uint ecs_system_get_enabled_entity_count(archetype archetype);
 	CE_API void* ecs_system_get_component_data(uint entity, component_id component, uint64& out_component_size);
+	// Stale entities have no components and the archetype INVALID_ID
 	CE_API std::vector<component_id>& ecs_system_get_entity_components(uint entity);
 	CE_API archetype ecs_system_get_entity_archetype(uint entity);
 	CE_API std::vector<component_data_type>& ecs_system_get_component_data_types(component_id component);
+
+	/*
+	 *  @brief The components of an archetype are stored in chunks, each chunk holds a contiguous array per component. Every chunk but the last one is full.
+	 *  @note The arrays are valid until an entity of the archetype is added or deleted, deleting moves the last entity of the archetype to the hole.
+	 */
+	CE_API uint ecs_system_get_chunk_count(archetype archetype);
+	CE_API uint ecs_system_get_chunk_entity_count(archetype archetype, uint chunk);
+	// Returns nullptr if the archetype doesn't have the component
+	CE_API void* ecs_system_get_chunk_component_data(archetype archetype, uint chunk, component_id component);
+	CE_API uint* ecs_system_get_chunk_entities(archetype archetype, uint chunk);
+	// Bit per entity of the chunk, see ecs_is_entity_enabled and ecs_for_each_enabled
+	CE_API uint64* ecs_system_get_chunk_enabled_mask(archetype archetype, uint chunk);
+	CE_API uint ecs_system_get_chunk_enabled_count(archetype archetype, uint chunk);
+
+	/*
+	 *  @brief Gets the archetypes that have every component of signature and none of exclude_signature. The result is cached per signature and updated when new archetypes are built,
+	 *  the reference stays valid until the ECS shutdown. Used by ecs_query, see systems/ecs_query.h
+	 */
+	CE_API std::vector<archetype>& ecs_system_query_archetypes(uint signature, uint exclude_signature);
+
+	CE_API ecs_column ecs_system_get_column(archetype archetype, component_id component);
+	// Gets the contiguous array of the column in a chunk, the column must exist
+	CE_API void* ecs_system_get_chunk_column_data(ecs_column& column, uint chunk);
+	// Returns nullptr if the entity is stale, belongs to another archetype or the archetype doesn't have the component
+	CE_API void* ecs_system_get_entity_column_data(uint entity, ecs_column& column);
+
+	/*
+	 *  @brief Binary snapshot of the world for checkpoints and level reloads. It holds a schema with the components, sizes and data types of every built archetype,
+	 *  then each column of an archetype as a single blob and the entity handles as they are, so the saved entities keep their ids after the restore.
+	 *  Every blob starts at a multiple of 16 bytes, the restore reads the columns in place, so the snapshot can be a file mapped in memory.
+	 *  @note The restore replaces every entity of the ECS and drops the frame commands. The systems that keep entity ids, like the scenes and the UI layouts, must hold the same entities as when the snapshot was taken.
+	 *  The runtime fields of the components are not kept, the cached name ids are derived again from the names and the pointers are reset to nullptr, so a snapshot can be loaded by another process.
+	 *  EVENT_CODE_ON_ECS_SNAPSHOT_RESTORED is fired after the restore for the systems to resolve their pointers again, i.e. the UI system binds the callbacks of its buttons.
+	 */
+	CE_API uint64 ecs_system_get_snapshot_size();
+	// Returns false if buffer_size is smaller than ecs_system_get_snapshot_size
+	CE_API bool ecs_system_write_snapshot(void* buffer, uint64 buffer_size);
+	// snapshot must be 16 bytes aligned. The archetypes of the snapshot that are not built yet are built from its schema, it fails without touching the world if the snapshot is corrupted or a built archetype has another schema
+	CE_API bool ecs_system_restore_snapshot(const void* snapshot, uint64 snapshot_size);
+	CE_API bool ecs_system_save_snapshot(std::string& path);
+	CE_API bool ecs_system_load_snapshot(std::string& path);
+
+	/*
+	 *  @brief Change tracking, every write stamps the columns of the chunk with a new version of the ECS. Adding, deleting, enabling or disabling an entity also stamps the structure of its chunk.
+	 *  A cache keeps the ecs_system_get_version of its last update and only rebuilds the chunks that changed after it, see ecs_query_set_changed_filter.
+	 *  ecs_system_insert_data and the queries with non const components stamp the columns, the writes through ecs_system_get_component_data must be marked with ecs_system_mark_entity_changed.
+	 *  @note Only the main thread can write the versions.
+	 */
+	CE_API uint64 ecs_system_get_version();
+	CE_API void ecs_system_mark_chunk_changed(archetype archetype, uint chunk, uint signature);
+	CE_API void ecs_system_mark_entity_changed(uint entity, component_id component);
+	// True if a column of the components of signature or the entities of the chunk changed after version
+	CE_API bool ecs_system_is_chunk_changed(archetype archetype, uint chunk, uint signature, uint64 version);
 }
\ No newline at end of file
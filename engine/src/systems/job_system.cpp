@@ -2,13 +2,18 @@
 
 #include "core/cememory.h"
 #include "core/logger.h"
-#include "containers/ring_queue.h"
+#include "containers/concurrent_ring_queue.h"
+#include "memory/stack_allocator.h"
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 
 namespace caliope {
+	// Temporary memory for the jobs, like the data built by the loaders
+	#define JOB_THREAD_SCRATCH_SIZE MEBIBYTES(4)
 
 	typedef struct job_thread {
 		uchar index;
@@ -31,22 +36,48 @@ namespace caliope {
 	// The max number of job results that can be stored at once.
 	#define MAX_JOB_RESULTS 512
 
+	// The max number of jobs waiting in each priority queue, must be a power of two.
+	#define JOB_QUEUE_CAPACITY 1024
+
+	typedef struct job_queue {
+		// Jobs can be submitted from any thread, the main thread takes them out to assign them.
+		concurrent_ring_queue queue;
+
+		// Job taken from the queue that no thread could handle yet, it goes before the ones in the queue. Only used by the main thread.
+		job_info held_job;
+		bool has_held_job;
+	}job_queue;
+
+	typedef struct parallel_for_work {
+		pfn_parallel_for_task task;
+		void* data;
+		uint count;
+		uint batch_size;
+		uint batch_count;
+
+		std::atomic<uint> next_batch;
+		std::atomic<uint> completed_items;
+		// Job threads inside the batches, the work can't be replaced until all of them leave
+		std::atomic<uint> workers;
+		std::atomic<bool> active;
+	}parallel_for_work;
+
 	typedef struct job_system_state {
 		bool running;
 		uchar thread_count;
 		job_thread job_threads[32];
 
-		ring_queue low_priority_queue;
-		ring_queue normal_priority_queue;
-		ring_queue high_priority_queue;
-
-		// Mutex for each queue, since a job could kick off from another job (thread).
-		std::mutex  low_pri_queue_mutex;
-		std::mutex  normal_pri_queue_mutex;
-		std::mutex  high_pri_queue_mutex;
+		job_queue low_priority_queue;
+		job_queue normal_priority_queue;
+		job_queue high_priority_queue;
 
 		job_result_entry pending_results[MAX_JOB_RESULTS];
 		std::mutex result_mutex;
+
+		parallel_for_work parallel_work;
+		// Wakes up the sleeping job threads when there is a parallel_for to run
+		std::mutex wake_mutex;
+		std::condition_variable wake_condition;
 	} job_system_state;
 
 	std::unique_ptr<job_system_state> state_ptr;
@@ -59,7 +90,7 @@ namespace caliope {
 		entry.callback = callback;
 		if (entry.param_size > 0) {
 			// Take a copy, as the job is destroyed after this.
-			entry.params = allocate_memory(MEMORY_TAG_JOB, param_size);
+			entry.params = allocate_memory_uninitialized(MEMORY_TAG_JOB, param_size);
 			copy_memory(entry.params, params, param_size);
 		}
 		else {
@@ -81,12 +112,31 @@ namespace caliope {
 
 	}
 
+	// Takes batches of the parallel_for until there are no more left
+	static void run_parallel_batches(parallel_for_work& work) {
+		while (true) {
+			uint batch = work.next_batch.fetch_add(1);
+			if (batch >= work.batch_count) {
+				break;
+			}
+
+			uint begin = batch * work.batch_size;
+			uint end = begin + work.batch_size < work.count ? begin + work.batch_size : work.count;
+			work.task(begin, end, work.data);
+			work.completed_items.fetch_add(end - begin);
+		}
+	}
+
 	uint job_thread_run(void* params) {
 		uint index = *(uint*)params;
 		job_thread* thread = &state_ptr->job_threads[index];
 		std::thread::id thread_id = thread->thread.get_id();
 		CE_LOG_INFO("Starting job thread %#i (id=%#i, type=%#i).", thread->index, thread_id, thread->type_mask);
 
+		if (!stack_allocator_create_thread_scratch(JOB_THREAD_SCRATCH_SIZE)) {
+			CE_LOG_ERROR("Job thread %#i couldn't create its scratch stack.", thread->index);
+		}
+
 		while (true)
 		{
 			if (!state_ptr || !state_ptr->running || !thread) {
@@ -116,12 +166,27 @@ namespace caliope {
 				thread->info_mutex.unlock();
 			}
 
+			parallel_for_work& work = state_ptr->parallel_work;
+			if ((thread->type_mask & JOB_TYPE_GENERAL) && work.active) {
+				work.workers++;
+				// Checked again after announcing itself, the work could have finished in between
+				if (work.active) {
+					run_parallel_batches(work);
+				}
+				work.workers--;
+			}
+
 			if (state_ptr->running) {
-				// TODO: Should probably find a better way to do this, such as sleeping until a request comes throught for a new job.
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				// TODO: The regular jobs are still picked up on the next wake up, they should signal the threads too.
+				std::unique_lock<std::mutex> lock(state_ptr->wake_mutex);
+				state_ptr->wake_condition.wait_for(lock, std::chrono::milliseconds(10), [thread]() {
+					return (thread->type_mask & JOB_TYPE_GENERAL) && state_ptr->parallel_work.active;
+				});
 			}
 		}
 
+		stack_allocator_destroy_thread_scratch();
+
 		return 1;
 	}
 
@@ -131,10 +196,14 @@ namespace caliope {
 
 		state_ptr->running = true;
 
-		ring_queue_create(sizeof(job_info), 1024, 0, state_ptr->low_priority_queue);
-		ring_queue_create(sizeof(job_info), 1024, 0, state_ptr->normal_priority_queue);
-		ring_queue_create(sizeof(job_info), 1024, 0, state_ptr->high_priority_queue);
+		job_queue* queues[] = { &state_ptr->low_priority_queue, &state_ptr->normal_priority_queue, &state_ptr->high_priority_queue };
+		for (uint i = 0; i < 3; ++i) {
+			concurrent_ring_queue_create(sizeof(job_info), JOB_QUEUE_CAPACITY, 0, queues[i]->queue);
+			queues[i]->has_held_job = false;
+		}
 		state_ptr->thread_count = max_job_thread_count;
+		state_ptr->parallel_work.active = false;
+		state_ptr->parallel_work.workers = 0;
 
 		// Invalidate all result slots
 		for (uint16 i = 0; i < MAX_JOB_RESULTS; ++i) {
@@ -160,6 +229,7 @@ namespace caliope {
 	{
 		if (state_ptr) {
 			state_ptr->running = false;
+			state_ptr->wake_condition.notify_all();
 
 			uint64 thread_count = state_ptr->thread_count;
 
@@ -169,22 +239,25 @@ namespace caliope {
 				state_ptr->job_threads[i].thread.~thread();
 			}
 
-			ring_queue_destroy(state_ptr->low_priority_queue);
-			ring_queue_destroy(state_ptr->normal_priority_queue);
-			ring_queue_destroy(state_ptr->high_priority_queue);
+			concurrent_ring_queue_destroy(state_ptr->low_priority_queue.queue);
+			concurrent_ring_queue_destroy(state_ptr->normal_priority_queue.queue);
+			concurrent_ring_queue_destroy(state_ptr->high_priority_queue.queue);
 	
 			state_ptr.reset();
 			state_ptr = nullptr;
 		}
 	}
 
-	void process_queue(ring_queue& queue, std::mutex& queue_mutex) {
+	void process_queue(job_queue& queue) {
 		uint64 thread_count = state_ptr->thread_count;
 
 		// Check for a free thread first
-		while (queue.length > 0) {
+		while (true) {
 			job_info info;
-			if (!ring_queue_peek(queue, &info)) {
+			if (queue.has_held_job) {
+				info = queue.held_job;
+			}
+			else if (!concurrent_ring_queue_dequeue(queue.queue, &info)) {
 				break;
 			}
 
@@ -199,11 +272,7 @@ namespace caliope {
 				thread.info_mutex.lock();
 
 				if (!thread.info.entry_point) {
-					// Make sure to remove the entry from the queue.
-					queue_mutex.lock();
-					ring_queue_dequeue(queue, &info);
-					queue_mutex.unlock();
-
+					queue.has_held_job = false;
 					thread.info = info;
 					CE_LOG_INFO("Assigning job to thread: %u", thread.index);
 					thread_found = true;
@@ -217,8 +286,10 @@ namespace caliope {
 				}
 			}
 
-			// This means all of the threads are currently handling a job, so wait until the next update and try again.
+			// This means all of the threads are currently handling a job, so hold it until the next update and try again.
 			if (!thread_found) {
+				queue.held_job = info;
+				queue.has_held_job = true;
 				break;
 			}
 		}
@@ -230,9 +301,9 @@ namespace caliope {
 			return;
 		}
 
-		process_queue(state_ptr->high_priority_queue, state_ptr->high_pri_queue_mutex);
-		process_queue(state_ptr->normal_priority_queue, state_ptr->normal_pri_queue_mutex);
-		process_queue(state_ptr->low_priority_queue, state_ptr->low_pri_queue_mutex);
+		process_queue(state_ptr->high_priority_queue);
+		process_queue(state_ptr->normal_priority_queue);
+		process_queue(state_ptr->low_priority_queue);
 
 		// Process pending results.
 		for (uint16 i = 0; i < MAX_JOB_RESULTS; ++i) {
@@ -260,13 +331,11 @@ namespace caliope {
 	void job_system_submit(job_info info)
 	{
 		uint64 thread_count = state_ptr->thread_count;
-		ring_queue* queue = &state_ptr->normal_priority_queue;
-		std::mutex* queue_mutex = &state_ptr->normal_pri_queue_mutex;
+		job_queue* queue = &state_ptr->normal_priority_queue;
 
 		// If the job is high priority, try to kick if off immediately.
 		if (info.priority == JOB_PRIORITY_HIGH) {
 			queue = &state_ptr->high_priority_queue;
-			queue_mutex = &state_ptr->high_pri_queue_mutex;
 
 			// Check for a free thread that supports the job type first.
 			for (uchar i = 0; i < thread_count; ++i) {
@@ -292,17 +361,68 @@ namespace caliope {
 		// If this point is reached, all threads are busy (if high) or it can wait a frame. Add to the queue and try again next cycle.
 		if (info.priority == JOB_PRIORITY_LOW) {
 			queue = &state_ptr->low_priority_queue;
-			queue_mutex = &state_ptr->low_pri_queue_mutex;
 		}
 
-		// NOTE: Locking here in case the job is submitted from another job/thread
-		queue_mutex->lock();
-		ring_queue_enqueue(*queue, &info);
-		queue_mutex->unlock();
+		// NOTE: The queue takes jobs submitted from other jobs/threads without locking
+		if (!concurrent_ring_queue_enqueue(queue->queue, &info)) {
+			// The job is dropped, its data is not going to be used
+			if (info.param_data) {
+				free_memory(MEMORY_TAG_JOB, info.param_data, info.param_data_size);
+			}
+			if (info.result_data) {
+				free_memory(MEMORY_TAG_JOB, info.result_data, info.result_data_size);
+			}
+			return;
+		}
 
 		CE_LOG_INFO("Job queued");
 	}
 
+	void job_system_parallel_for(uint count, uint batch_size, pfn_parallel_for_task task, void* data)
+	{
+		if (count == 0) {
+			return;
+		}
+
+		if (batch_size == 0) {
+			batch_size = 1;
+		}
+
+		uint batch_count = (count + batch_size - 1) / batch_size;
+		if (state_ptr == nullptr || !state_ptr->running || state_ptr->thread_count == 0 || batch_count == 1) {
+			task(0, count, data);
+			return;
+		}
+
+		// The previous parallel_for left no workers behind, so the work can be written before activating it
+		parallel_for_work& work = state_ptr->parallel_work;
+		work.task = task;
+		work.data = data;
+		work.count = count;
+		work.batch_size = batch_size;
+		work.batch_count = batch_count;
+		work.next_batch = 0;
+		work.completed_items = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(state_ptr->wake_mutex);
+			work.active = true;
+		}
+		state_ptr->wake_condition.notify_all();
+
+		run_parallel_batches(work);
+
+		// Wait for the batches taken by the job threads
+		while (work.completed_items.load() < count) {
+			std::this_thread::yield();
+		}
+
+		work.active = false;
+		while (work.workers.load() != 0) {
+			std::this_thread::yield();
+		}
+	}
+
 	job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, uint param_data_size, uint result_data_size)
 	{
 		return job_create_priority(entry_point, on_success, on_fail, param_data, param_data_size, result_data_size, JOB_TYPE_GENERAL, JOB_PRIORITY_NORMAL);
@@ -324,7 +444,7 @@ namespace caliope {
 
 		job.param_data_size = param_data_size;
 		if (param_data_size) {
-			job.param_data = allocate_memory(MEMORY_TAG_JOB, param_data_size);
+			job.param_data = allocate_memory_uninitialized(MEMORY_TAG_JOB, param_data_size);
 			copy_memory(job.param_data, param_data, param_data_size);
 		}
 		else {
@@ -6,6 +6,9 @@ namespace caliope {
 
 	typedef void (*pfn_job_on_complete)(void*);
 
+	// Runs the items [begin, end) of a parallel_for
+	typedef void (*pfn_parallel_for_task)(uint begin, uint end, void*);
+
 	typedef enum job_type {
 		JOB_TYPE_GENERAL = 0x02,
 		JOB_TYPE_RESOURCE_LOAD = 0x04,
@@ -45,6 +48,12 @@ namespace caliope {
 
 	CE_API void job_system_submit(job_info info);
 
+	/**
+	 * @brief Runs task over the items [0, count) in batches of batch_size items. The general job threads take batches while the calling thread runs them too, it returns when every batch is done.
+	 * @note Only one parallel_for can run at a time and it must be called from the main thread. The job threads busy with a job join when they finish it.
+	 */
+	CE_API void job_system_parallel_for(uint count, uint batch_size, pfn_parallel_for_task task, void* data);
+
 	CE_API job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, uint param_data_size, uint result_data_size);
 	CE_API job_info job_create_type(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, uint param_data_size, uint result_data_size, job_type type);
 	CE_API job_info job_create_priority(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, uint param_data_size, uint result_data_size, job_type type, job_priority priority);
@@ -2,6 +2,7 @@
 #include "cepch.h"
 
 #include "core/logger.h"
+#include "containers/flat_hash_map.h"
 
 #include "resources/resources_types.inl"
 #include "systems/resource_system.h"
@@ -15,7 +16,7 @@ namespace caliope {
 	} material_reference;
 
 	typedef struct material_system_state {
-		std::unordered_map<std::string, material_reference> registered_materials;
+		flat_hash_map<name_id, material_reference> registered_materials;
 		material default_material;
 	}material_system_state;
 
@@ -33,6 +34,7 @@ namespace caliope {
 			return false;
 		}
 
+		flat_hash_map_create(state_ptr->registered_materials);
 		generate_default_material();
 
 		CE_LOG_INFO("Material system initialized.");
@@ -41,16 +43,26 @@ namespace caliope {
 	void material_system_shutdown() {
 		destroy_material(state_ptr->default_material);
 
-		state_ptr->registered_materials.clear(); // Destroys all the materials and their pointers.
+		flat_hash_map_destroy(state_ptr->registered_materials); // Destroys all the materials and their pointers.
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
 
 	material* material_system_adquire(std::string& name) {
-		if (state_ptr->registered_materials.find(name) == state_ptr->registered_materials.end()) {
+		return material_system_adquire(name_id_intern(name.c_str()));
+	}
+
+	material* material_system_adquire(name_id id) {
+		material_reference* reference = flat_hash_map_find(state_ptr->registered_materials, id);
+		if (!reference) {
+			const char* name = name_id_get_string(id);
+			if (!name) {
+				CE_LOG_ERROR("material_system_adquire the name of the id %llu was never interned", id);
+				return material_system_get_default();
+			}
 
 			resource r;
-			if(!resource_system_load(name, RESOURCE_TYPE_MATERIAL, r)){
+			if(!resource_system_load(std::string(name), RESOURCE_TYPE_MATERIAL, r)){
 				CE_LOG_ERROR("material_system_adquire couldnt load file material");
 				return material_system_get_default();
 			}
@@ -63,35 +75,47 @@ namespace caliope {
 				return material_system_get_default();
 			}
 
+			reference = flat_hash_map_find(state_ptr->registered_materials, id);
+			if (!reference) {
+				CE_LOG_ERROR("material_system_adquire the material file %s has a different material name", name);
+				return material_system_get_default();
+			}
 		}
 		
-		state_ptr->registered_materials[name].reference_count++;
-		return &state_ptr->registered_materials[name].material;
+		reference->reference_count++;
+		return &reference->material;
 	}
 
 	material* material_system_adquire_from_config(material_resource_data& material_config)
 	{
-		if (state_ptr->registered_materials.find(std::string(&material_config.name[0])) == state_ptr->registered_materials.end()) {
+		name_id id = name_id_intern(material_config.name.data());
+		material_reference* reference = flat_hash_map_find(state_ptr->registered_materials, id);
+		if (!reference) {
 
 			if (!load_material(material_config)) {
 				CE_LOG_ERROR("material_system_adquire_from_config couldnt adquire material");
 				return material_system_get_default();
 			}
 
+			reference = flat_hash_map_find(state_ptr->registered_materials, id);
 		}
 
-		state_ptr->registered_materials[std::string(&material_config.name[0])].reference_count++;
-		return &state_ptr->registered_materials[std::string(&material_config.name[0])].material;
+		reference->reference_count++;
+		return &reference->material;
 	}
 
 	void material_system_release(std::string& name) {
-		if (state_ptr->registered_materials.find(name) != state_ptr->registered_materials.end()) {
+		material_system_release(name_id_intern(name.c_str()));
+	}
+
+	void material_system_release(name_id id) {
+		material_reference* reference = flat_hash_map_find(state_ptr->registered_materials, id);
+		if (reference) {
 			
-			state_ptr->registered_materials[name].reference_count++;
+			reference->reference_count++;
 
-			if (state_ptr->registered_materials[name].reference_count <= 0) {
-				destroy_material(state_ptr->registered_materials[name].material);
-				state_ptr->registered_materials.erase(name);
+			if (reference->reference_count <= 0) {
+				destroy_material(reference->material);
 			}
 		}
 	}
@@ -102,7 +126,9 @@ namespace caliope {
 
 	bool load_material(material_resource_data& mat_config) {
 		material_reference mr;
+		mr.reference_count = 0;
 		mr.material.name = std::string(mat_config.name.data());
+		mr.material.id = name_id_intern(mat_config.name.data());
 		mr.material.diffuse_color = mat_config.diffuse_color;
 		mr.material.shininess_intensity = mat_config.shininess_intensity;
 		mr.material.shininess_sharpness = mat_config.shininess_sharpness;
@@ -118,23 +144,27 @@ namespace caliope {
 		texture* normal_tex = texture_system_adquire(std::string(mat_config.normal_texture_name.data()));
 		mr.material.normal_texture = normal_tex ? normal_tex : texture_system_get_default_normal();
 
-		state_ptr->registered_materials.insert({ mr.material.name, mr });
+		flat_hash_map_insert(state_ptr->registered_materials, mr.material.id, mr);
 
 		return true;
 	}
 
 	void destroy_material(material& m) {
-		state_ptr->registered_materials.erase(m.name);
+		// Removing destroys m when it is a registered material, copy the id first
+		name_id id = m.id;
 		m.name = "";
+		m.id = INVALID_NAME_ID;
 		m.diffuse_color = glm::vec4(0.0f);;
 		m.shader = nullptr;
 		m.diffuse_texture = nullptr;
 		m.specular_texture = nullptr;
 		m.normal_texture = nullptr;
+		flat_hash_map_remove(state_ptr->registered_materials, id);
 	}
 
 	void generate_default_material() {
 		state_ptr->default_material.name = std::string("default");
+		state_ptr->default_material.id = name_id_intern("default");
 		state_ptr->default_material.diffuse_color = glm::vec4(1.0f);
 
 		state_ptr->default_material.shader = shader_system_adquire(std::string("Builtin.SpriteShader"));
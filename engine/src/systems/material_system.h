@@ -1,5 +1,6 @@
 #pragma once
 #include "defines.h"
+#include "core/name_id.h"
 
 namespace caliope {
 
@@ -10,8 +11,13 @@ namespace caliope {
 	void material_system_shutdown();
 
 	CE_API material* material_system_adquire(std::string& name);
+	/**
+	 * @note The name of the id must have been interned to load the material the first time.
+	 */
+	CE_API material* material_system_adquire(name_id id);
 	CE_API material* material_system_adquire_from_config(material_resource_data& material_config);
 	CE_API void material_system_release(std::string& name);
+	CE_API void material_system_release(name_id id);
 
 	CE_API material* material_system_get_default();
 }
\ No newline at end of file
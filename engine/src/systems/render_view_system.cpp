@@ -1,6 +1,7 @@
 #include "render_view_system.h"
 
 #include "core/logger.h"
+#include "containers/flat_hash_map.h"
 #include "renderer/renderer_types.inl"
 
 #include "renderer/views/world_render_view.h"
@@ -10,7 +11,7 @@
 namespace caliope {
 
 	typedef struct render_view_system_state {
-		std::unordered_map<uint,render_view> registered_views;
+		flat_hash_map<uint, render_view> registered_views;
 	}render_view_system_state;
 
 	static std::unique_ptr<render_view_system_state> state_ptr;
@@ -22,6 +23,7 @@ namespace caliope {
 			return false;
 		}
 
+		flat_hash_map_create(state_ptr->registered_views);
 	
 		CE_LOG_INFO("Render view system initialized.");
 
@@ -29,11 +31,11 @@ namespace caliope {
 	}
 
 	void render_view_system_shutdown() {
-		for (auto view : state_ptr->registered_views) {
-			view.second.on_destroy(view.second);
+		for (auto [type, view] : state_ptr->registered_views) {
+			view.on_destroy(view);
 		}
 
-		state_ptr->registered_views.clear();
+		flat_hash_map_destroy(state_ptr->registered_views);
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
@@ -63,33 +65,35 @@ namespace caliope {
 			view.on_render = ui_render_view_on_render;
 		}
 
-		state_ptr->registered_views.insert({ view.type, view });
+		flat_hash_map_insert(state_ptr->registered_views, view.type, view);
 
 		view.on_create(view);
 
 	}
 
 	void render_view_system_on_window_resize(uint width, uint height) {
-		for (auto view : state_ptr->registered_views) {
-			view.second.on_resize_window(view.second, width, height);
+		for (auto [type, view] : state_ptr->registered_views) {
+			view.on_resize_window(view, width, height);
 		}
 	}
 
 	bool render_view_system_on_build_packet(view_type view_type, renderer_view_packet& out_packet, std::vector<std::any>& variadic_data) {
-		if (state_ptr->registered_views.find(view_type) == state_ptr->registered_views.end()) {
+		render_view* view = flat_hash_map_find(state_ptr->registered_views, view_type);
+		if (!view) {
 			CE_LOG_WARNING("render_view_system_on_build_packet render view not found.");
 			return false;
 		}
 
-		return state_ptr->registered_views.at(view_type).on_build_package(state_ptr->registered_views.at(view_type), out_packet, variadic_data);
+		return view->on_build_package(*view, out_packet, variadic_data);
 	}
 
 	bool render_view_system_on_render(view_type view_type, std::any& packet, uint render_target_index) {
-		if (state_ptr->registered_views.find(view_type) == state_ptr->registered_views.end()) {
+		render_view* view = flat_hash_map_find(state_ptr->registered_views, view_type);
+		if (!view) {
 			CE_LOG_WARNING("render_view_system_on_render render view not found.");
 			return false;
 		}
 
-		return state_ptr->registered_views.at(view_type).on_render(state_ptr->registered_views.at(view_type), packet, render_target_index);
+		return view->on_render(*view, packet, render_target_index);
 	}
 }
\ No newline at end of file
@@ -1,11 +1,16 @@
 #include "scene_system.h"
 #include "core/logger.h"
 #include "core/cememory.h"
+#include "containers/flat_hash_map.h"
 #include "resources/resources_types.inl"
 #include "platform/file_system.h"
 
 #include "components/components.inl"
 #include "ecs_system.h"
+#include "ecs_query.h"
+#include "ecs_scheduler.h"
+#include "memory/frame_allocator.h"
+#include "math/transform.h"
 
 #include "sprite_animation_system.h"
 #include "material_system.h"
@@ -20,13 +25,60 @@ namespace caliope {
 
 	typedef struct scene_system_state {
 		std::unordered_map<std::string, scene> loaded_scenes;
-		std::unordered_map<uint, uint> entity_index_scene; // Index of the entity that occupies in the scene
+		flat_hash_map<uint, uint> entity_index_scene; // Index of the entity that occupies in the scene
 		uint scene_count;
 		uint max_number_entities;
+
+		// Built every frame by the ECS systems of the scene on the job threads, one per enabled entity in the order of the queries
+		frame_vector<transform> sprite_transforms;
+		frame_vector<transform> sprite_animation_transforms;
+		frame_vector<point_light_definition> lights;
+		uint sprite_transforms_system;
+		uint sprite_animation_transforms_system;
+		uint lights_system;
 	}scene_system_state;
 
 	static std::unique_ptr<scene_system_state> state_ptr;
 
+	template<typename T>
+	static void prepare_frame_output(uint output_count, void* user_data) {
+		// NOTE: A new vector every frame, the previous one was taken from the arena of the last frame
+		*(frame_vector<T>*)user_data = frame_vector<T>(output_count);
+	}
+
+	static void update_transforms(const ecs_system_chunk& chunk, void* user_data) {
+		frame_vector<transform>& transforms = *(frame_vector<transform>*)user_data;
+		transform_component* tran_comps = (transform_component*)ecs_system_get_chunk_component_data(chunk.archetype, chunk.chunk, TRANSFORM_COMPONENT);
+
+		uint output = chunk.first_output;
+		ecs_for_each_enabled(chunk.enabled_mask, chunk.entity_count, [&](uint i) {
+			transform& transform = transforms[output++];
+			transform = transform_create();
+			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comps[i].roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
+			transform_set_scale(transform, tran_comps[i].scale);
+			transform_set_position(transform, tran_comps[i].position);
+			// The matrix is cached here so the render views don't build it on the main thread
+			transform_get_local(transform);
+		});
+	}
+
+	static void update_lights(const ecs_system_chunk& chunk, void* user_data) {
+		frame_vector<point_light_definition>& lights = *(frame_vector<point_light_definition>*)user_data;
+		transform_component* tran_comps = (transform_component*)ecs_system_get_chunk_component_data(chunk.archetype, chunk.chunk, TRANSFORM_COMPONENT);
+		point_light_component* light_comps = (point_light_component*)ecs_system_get_chunk_component_data(chunk.archetype, chunk.chunk, POINT_LIGHT_COMPONENT);
+
+		uint output = chunk.first_output;
+		ecs_for_each_enabled(chunk.enabled_mask, chunk.entity_count, [&](uint i) {
+			point_light_definition& definition = lights[output++];
+			definition.position = glm::vec4(tran_comps[i].position, 1.0f);
+			definition.color = light_comps[i].color;
+			definition.constant = light_comps[i].constant;
+			definition.linear = light_comps[i].linear;
+			definition.quadratic = light_comps[i].quadratic;
+			definition.radius = light_comps[i].radius;
+		});
+	}
+
 
 	bool scene_system_initialize(scene_system_configuration& config) {
 		state_ptr = std::make_unique<scene_system_state>();
@@ -36,6 +88,32 @@ namespace caliope {
 		}
 
 		state_ptr->max_number_entities = config.max_number_entities;
+		flat_hash_map_create(state_ptr->entity_index_scene, config.max_number_entities);
+
+		// NOTE: The systems read the same signatures as the queries of scene_system_populate_render_packet, so both walk the entities in the same order
+		ecs_system_config sprite_transforms_config = {};
+		sprite_transforms_config.name = "sprite_transforms";
+		sprite_transforms_config.read_signature = ecs_signature<transform_component, material_component>();
+		sprite_transforms_config.prepare = prepare_frame_output<transform>;
+		sprite_transforms_config.update = update_transforms;
+		sprite_transforms_config.user_data = &state_ptr->sprite_transforms;
+		state_ptr->sprite_transforms_system = ecs_scheduler_register_system(sprite_transforms_config);
+
+		ecs_system_config sprite_animation_transforms_config = {};
+		sprite_animation_transforms_config.name = "sprite_animation_transforms";
+		sprite_animation_transforms_config.read_signature = ecs_signature<transform_component, material_animation_component>();
+		sprite_animation_transforms_config.prepare = prepare_frame_output<transform>;
+		sprite_animation_transforms_config.update = update_transforms;
+		sprite_animation_transforms_config.user_data = &state_ptr->sprite_animation_transforms;
+		state_ptr->sprite_animation_transforms_system = ecs_scheduler_register_system(sprite_animation_transforms_config);
+
+		ecs_system_config lights_config = {};
+		lights_config.name = "point_lights";
+		lights_config.read_signature = ecs_signature<transform_component, point_light_component>();
+		lights_config.prepare = prepare_frame_output<point_light_definition>;
+		lights_config.update = update_lights;
+		lights_config.user_data = &state_ptr->lights;
+		state_ptr->lights_system = ecs_scheduler_register_system(lights_config);
 
 		CE_LOG_INFO("Scene system initialized.");
 
@@ -48,6 +126,11 @@ namespace caliope {
 		}
 
 		state_ptr->loaded_scenes.clear();
+		flat_hash_map_destroy(state_ptr->entity_index_scene);
+
+		ecs_scheduler_unregister_system(state_ptr->sprite_transforms_system);
+		ecs_scheduler_unregister_system(state_ptr->sprite_animation_transforms_system);
+		ecs_scheduler_unregister_system(state_ptr->lights_system);
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
@@ -80,39 +163,17 @@ namespace caliope {
 		scene_system_create_empty(std::string(scene_config.name.data()), enable_by_default);
 
 
-		for (uint entity_index = 0; entity_index < scene_config.archetypes.size(); ++entity_index) {
-
-			// Tries to build the archetype if not exists
-			std::vector<uint> new_archetype_size;
-			std::vector<component_id> new_archetype_id;
-			std::vector<std::vector<component_data_type>> sprite_components_data_types;
+		// The entities of each archetype are spawned in one batch, new_entity_ids keeps the order of the file
+		std::vector<uint> new_entity_ids;
+		ecs_system_spawn_resource_entities(scene_config, new_entity_ids);
 
-			for (uint component_index = 0; component_index < scene_config.components[entity_index].size(); ++component_index) {
-				component_id comp_id = scene_config.components[entity_index][component_index];
-				new_archetype_id.push_back(comp_id);
-				new_archetype_size.push_back(scene_config.components_sizes.at(comp_id));
-
-				sprite_components_data_types.push_back(std::vector<component_data_type>());
-				for (uint component_data_types_index = 0; component_data_types_index < scene_config.components_data_types[entity_index][component_index].size(); ++component_data_types_index) {
-					sprite_components_data_types[component_index].push_back(scene_config.components_data_types[entity_index][component_index][component_data_types_index]);
-				}
-			}
-			ecs_system_build_archetype(scene_config.archetypes[entity_index], new_archetype_id, new_archetype_size, sprite_components_data_types);
-
-
-			// Creates a new entity
-			std::vector<component_id> components;
-			std::vector<void*> data;
-
-			for (uint component_index = 0; component_index < scene_config.components[entity_index].size(); ++component_index) {
-				components.push_back(scene_config.components[entity_index][component_index]);
-				data.push_back(scene_config.components_data[entity_index][component_index]);
+		std::vector<uint>& entities = state_ptr->loaded_scenes.at(std::string(scene_config.name.data())).entities;
+		entities.reserve(entities.size() + new_entity_ids.size());
+		for (uint entity : new_entity_ids) {
+			if (entity != INVALID_ID) {
+				flat_hash_map_insert(state_ptr->entity_index_scene, entity, (uint)entities.size());
+				entities.push_back(entity);
 			}
-
-			scene_system_instance_entity(std::string(scene_config.name.data()), scene_config.archetypes[entity_index],
-				components,
-				data
-			);
 		}
 
 		resource_system_unload(r);
@@ -126,8 +187,9 @@ namespace caliope {
 			return;
 		}
 		
-		while (!state_ptr->loaded_scenes.at(name).entities.empty()) {
-			scene_system_destroy_entity(name, state_ptr->loaded_scenes.at(name).entities.front());
+		for (uint entity : state_ptr->loaded_scenes.at(name).entities) {
+			ecs_system_delete_entity(entity);
+			flat_hash_map_remove(state_ptr->entity_index_scene, entity);
 		}
 
 		state_ptr->loaded_scenes.erase(name);
@@ -153,12 +215,13 @@ namespace caliope {
 			return -1;
 		}
 
-		uint entity = ecs_system_add_entity(archetype);
-		for (uint i = 0; i < components.size(); ++i) {
-			ecs_system_insert_data(entity, components[i], components_data[i]);
+		uint entity = INVALID_ID;
+		ecs_system_spawn_batch(archetype, 1, (uint)components.size(), components.data(), components_data.data(), &entity);
+		if (entity == INVALID_ID) {
+			return -1;
 		}
 		
-		state_ptr->entity_index_scene.insert({ entity, state_ptr->loaded_scenes.at(name).entities.size() });
+		flat_hash_map_insert(state_ptr->entity_index_scene, entity, (uint)state_ptr->loaded_scenes.at(name).entities.size());
 		state_ptr->loaded_scenes.at(name).entities.push_back(entity);
 
 		return entity;
@@ -166,31 +229,24 @@ namespace caliope {
 
 	void scene_system_destroy_entity(std::string& name, uint entity) {
 
-		if (state_ptr->loaded_scenes.find(name) == state_ptr->loaded_scenes.end() || state_ptr->entity_index_scene.find(entity) == state_ptr->entity_index_scene.end()) {
+		if (state_ptr->loaded_scenes.find(name) == state_ptr->loaded_scenes.end() || !flat_hash_map_contains(state_ptr->entity_index_scene, entity)) {
 			CE_LOG_WARNING("scene_system_enable scene %s not found", name.c_str());
 			return;
 		}
 
-		bool remove_last_entity = state_ptr->loaded_scenes.at(name).entities.back() == entity;
-
-		uint entity_scene_index = state_ptr->entity_index_scene.at(entity);
+		std::vector<uint>& entities = state_ptr->loaded_scenes.at(name).entities;
+		uint entity_scene_index = *flat_hash_map_find(state_ptr->entity_index_scene, entity);
 		ecs_system_delete_entity(entity);
 
-
-		if (state_ptr->loaded_scenes.at(name).entities.size() > 1 && !remove_last_entity) {
-			state_ptr->loaded_scenes.at(name).entities.erase(state_ptr->loaded_scenes.at(name).entities.begin() + entity_scene_index);
-
-			uint last_entity = state_ptr->loaded_scenes.at(name).entities.back();
-			state_ptr->loaded_scenes.at(name).entities.pop_back();
-			state_ptr->loaded_scenes.at(name).entities.insert(state_ptr->loaded_scenes.at(name).entities.begin() + entity_scene_index, last_entity);
-			state_ptr->entity_index_scene[last_entity] = entity_scene_index;
-		}
-		else if (remove_last_entity) {
-			uint last_index = state_ptr->loaded_scenes.at(name).entities.size() - 1;
-			state_ptr->loaded_scenes.at(name).entities.erase(state_ptr->loaded_scenes.at(name).entities.begin() + last_index);
+		// Move the last entity to the hole
+		uint last_entity = entities.back();
+		entities[entity_scene_index] = last_entity;
+		entities.pop_back();
+		if (last_entity != entity) {
+			*flat_hash_map_find(state_ptr->entity_index_scene, last_entity) = entity_scene_index;
 		}
 		
-		state_ptr->entity_index_scene.erase(entity);
+		flat_hash_map_remove(state_ptr->entity_index_scene, entity);
 
 	}
 
@@ -206,28 +262,23 @@ namespace caliope {
 		}
 	}
 
-	void scene_system_populate_render_packet(std::vector<renderer_view_packet>& packets, camera* world_cam_in_use, float delta_time) {
+	void scene_system_populate_render_packet(frame_vector<renderer_view_packet>& packets, camera* world_cam_in_use, float delta_time) {
 			
-		std::vector<quad_instance_definition> quads_data;
-		std::vector<point_light_definition> lights_data;
+		frame_vector<quad_instance_definition> quads_data;
 
-		// Gets all sprites entities
-		std::vector<uint>& sprites = ecs_system_get_entities_by_archetype(ARCHETYPE_SPRITE);
-		for (uint entity_index = 0; entity_index < sprites.size(); ++entity_index) {
+		// NOTE: Reserve up front, the frame arena can't reuse the blocks left behind by a vector growth
+		quads_data.reserve(state_ptr->sprite_transforms.size() + state_ptr->sprite_animation_transforms.size());
 
-			uint64 size;
-			quad_instance_definition quad_definition;
-			quad_definition.id = sprites[entity_index];
+		// Gets all sprites entities, the components are read straight from the chunks of the archetypes and the transforms were built by the sprite_transforms system
+		uint sprite_index = 0;
+		ecs_query<const transform_component, const material_component> sprites_query = ecs_query_create<const transform_component, const material_component>();
+		ecs_query_for_each(sprites_query, [&](uint entity, const transform_component& tran_comp, const material_component& sprite_comp) {
 
-			transform_component* tran_comp = (transform_component*)ecs_system_get_component_data(sprites[entity_index], TRANSFORM_COMPONENT, size);
-			transform transform = transform_create();
-			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp->roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
-			transform_set_scale(transform, tran_comp->scale);
-			transform_set_position(transform, tran_comp->position);
-			quad_definition.transform = transform;
+			quad_instance_definition quad_definition;
+			quad_definition.id = entity;
+			quad_definition.transform = state_ptr->sprite_transforms[sprite_index++];
 
-			material_component* sprite_comp = (material_component*)ecs_system_get_component_data(sprites[entity_index], MATERIAL_COMPONENT, size);
-			material* mat = material_system_adquire(std::string(sprite_comp->material_name.data()));
+			material* mat = material_system_adquire(sprite_comp.material_id);
 			quad_definition.diffuse_color = mat->diffuse_color;
 			quad_definition.shininess_intensity = mat->shininess_intensity;
 			quad_definition.shininess_sharpness = mat->shininess_sharpness;
@@ -236,32 +287,32 @@ namespace caliope {
 			quad_definition.specular_texture = mat->specular_texture;
 			quad_definition.normal_texture = mat->normal_texture;
 
-			quad_definition.z_order = sprite_comp->z_order;
+			quad_definition.z_order = sprite_comp.z_order;
 			quad_definition.texture_region = texture_system_calculate_custom_region_coordinates(
-				*material_system_adquire(std::string(sprite_comp->material_name.data()))->diffuse_texture,
-				sprite_comp->texture_region[0],
-				sprite_comp->texture_region[1],
+				*mat->diffuse_texture,
+				sprite_comp.texture_region[0],
+				sprite_comp.texture_region[1],
 				false
 			);
 
 			quads_data.push_back(quad_definition);
-		}
+		});
 			
 		// Gets all animations sprites entities
-		std::vector<uint>& sprites_animation = ecs_system_get_entities_by_archetype(ARCHETYPE_SPRITE_ANIMATION);
-		for (uint entity_index = 0; entity_index < sprites_animation.size(); ++entity_index) {
+		uint sprite_animation_index = 0;
+		ecs_query<const transform_component, const material_animation_component> sprites_animation_query = ecs_query_create<const transform_component, const material_animation_component>();
+		ecs_query_for_each(sprites_animation_query, [&](uint entity, const transform_component& tran_comp, const material_animation_component& anim_comp) {
 
-			uint64 size;
 			quad_instance_definition quad_definition;
-			quad_definition.id = sprites_animation[entity_index];
+			quad_definition.id = entity;
+			quad_definition.transform = state_ptr->sprite_animation_transforms[sprite_animation_index++];
 
-			material_animation_component* anim_comp = (material_animation_component*)ecs_system_get_component_data(sprites_animation[entity_index], MATERIAL_ANIMATION_COMPONENT, size);
-			sprite_frame* frame = sprite_animation_system_acquire_frame(std::string(anim_comp->animation_name.data()), delta_time);
+			sprite_frame* frame = sprite_animation_system_acquire_frame(anim_comp.animation_id, delta_time);
 			if (frame == nullptr) {
-				continue;
+				return;
 			}
 
-			material* mat = material_system_adquire(frame->material_name);
+			material* mat = material_system_adquire(frame->material_id);
 			quad_definition.diffuse_color = mat->diffuse_color;
 			quad_definition.shininess_intensity = mat->shininess_intensity;
 			quad_definition.shininess_sharpness = mat->shininess_sharpness;
@@ -270,51 +321,25 @@ namespace caliope {
 			quad_definition.specular_texture = mat->specular_texture;
 			quad_definition.normal_texture = mat->normal_texture;
 
-			quad_definition.z_order = anim_comp->z_order;
+			quad_definition.z_order = anim_comp.z_order;
 			quad_definition.texture_region = frame->texture_region;
 
-			transform_component* tran_comp = (transform_component*)ecs_system_get_component_data(sprites_animation[entity_index], TRANSFORM_COMPONENT, size);
-			transform transform = transform_create();
-			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp->roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
-			transform_set_scale(transform, tran_comp->scale);
-			transform_set_position(transform, tran_comp->position);
-			quad_definition.transform = transform;	
-
-
 			quads_data.push_back(quad_definition);
-		}
-			
-
-		// Gets all point lighst entities
-		std::vector<uint>& point_lights = ecs_system_get_entities_by_archetype(ARCHETYPE_POINT_LIGHT);
-		for (uint entity_index = 0; entity_index < point_lights.size(); ++entity_index) {
-			uint64 size;
+		});
 
-			point_light_definition definition;
-
-			transform_component* tran_comp = (transform_component*)ecs_system_get_component_data(point_lights[entity_index], TRANSFORM_COMPONENT, size);
-			definition.position = glm::vec4(tran_comp->position, 1.0f);
-
-			point_light_component* light_comp = (point_light_component*)ecs_system_get_component_data(point_lights[entity_index], POINT_LIGHT_COMPONENT, size);
-			definition.color = light_comp->color;
-			definition.constant = light_comp->constant;
-			definition.linear = light_comp->linear;
-			definition.quadratic = light_comp->quadratic;
-			definition.radius = light_comp->radius;
-
-			lights_data.push_back(definition);
-		}
+		// The point lights were gathered by the point_lights system
+		frame_vector<point_light_definition>& lights_data = state_ptr->lights;
 
 
 		renderer_view_packet world_packet;
 		world_packet.view_type = VIEW_TYPE_WORLD;
-		render_view_system_on_build_packet(VIEW_TYPE_WORLD, world_packet, std::vector<std::any>({ quads_data, lights_data, world_cam_in_use, delta_time }));
-		packets.push_back(world_packet);
+		render_view_system_on_build_packet(VIEW_TYPE_WORLD, world_packet, std::vector<std::any>({ &quads_data, &lights_data, world_cam_in_use, delta_time }));
+		packets.push_back(std::move(world_packet));
 
 
 		renderer_view_packet pick_object_packet;
 		pick_object_packet.view_type = VIEW_TYPE_WORLD_OBJECT_PICK;
-		render_view_system_on_build_packet(VIEW_TYPE_WORLD_OBJECT_PICK, pick_object_packet, std::vector<std::any>({ quads_data, world_cam_in_use, delta_time }));
-		packets.push_back(pick_object_packet);
+		render_view_system_on_build_packet(VIEW_TYPE_WORLD_OBJECT_PICK, pick_object_packet, std::vector<std::any>({ &quads_data, world_cam_in_use, delta_time }));
+		packets.push_back(std::move(pick_object_packet));
 	}
 }
\ No newline at end of file
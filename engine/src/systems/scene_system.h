@@ -1,5 +1,6 @@
 #pragma once
 #include "defines.h"
+#include "memory/frame_allocator.h"
 
 
 namespace caliope {
@@ -18,7 +19,7 @@ namespace caliope {
 	bool scene_system_initialize(scene_system_configuration& config);
 	void scene_system_shutdown();
 	
-	void scene_system_populate_render_packet(std::vector<renderer_view_packet>& packets, camera* world_cam_in_use, float delta_time);
+	void scene_system_populate_render_packet(frame_vector<renderer_view_packet>& packets, camera* world_cam_in_use, float delta_time);
 
 	CE_API bool scene_system_create_empty(std::string& name, bool enable_by_default);
 	CE_API bool scene_system_load(std::string& name, bool enable_by_default);
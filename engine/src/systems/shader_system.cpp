@@ -1,6 +1,7 @@
 #include "shader_system.h"
 #include "cepch.h"
 #include "core/logger.h"
+#include "containers/flat_hash_map.h"
 
 #include "resources/resources_types.inl"
 #include "systems/resource_system.h"
@@ -16,7 +17,7 @@ namespace caliope {
 	} shader_reference;
 
 	typedef struct shader_system_state {
-		std::unordered_map<std::string, shader_reference> registered_shaders;
+		flat_hash_map<name_id, shader_reference> registered_shaders;
 
 	}shader_system_state;
 
@@ -34,6 +35,8 @@ namespace caliope {
 			return false;
 		}
 
+		flat_hash_map_create(state_ptr->registered_shaders);
+
 		if (shader_system_adquire(BUILTIN_SHADER_NAME) == nullptr) {
 			CE_LOG_ERROR("Could not load Builtin.SpriteShader as default shader. Shutting down");
 			return false;
@@ -48,45 +51,72 @@ namespace caliope {
 			destroy_shader(value.shader);
 		}
 
-		state_ptr->registered_shaders.clear();
+		flat_hash_map_destroy(state_ptr->registered_shaders);
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
 	
 	shader* shader_system_adquire(std::string& name) {
-		if (state_ptr->registered_shaders.find(name) == state_ptr->registered_shaders.end()) {
+		return shader_system_adquire(name_id_intern(name.c_str()));
+	}
+
+	shader* shader_system_adquire(name_id id) {
+		shader_reference* reference = flat_hash_map_find(state_ptr->registered_shaders, id);
+		if (!reference) {
+			const char* name = name_id_get_string(id);
+			if (!name) {
+				CE_LOG_ERROR("shader_system_adquire the name of the id %llu was never interned", id);
+				return nullptr;
+			}
+
 			resource r;
-			if (!resource_system_load(name, RESOURCE_TYPE_SHADER, r)) {
+			if (!resource_system_load(std::string(name), RESOURCE_TYPE_SHADER, r)) {
 				CE_LOG_ERROR("shader_system_adquire couldnt load shader config file");
-				return false;
+				return nullptr;
 			}
 			shader_resource_data shader_config = std::any_cast<shader_resource_data>(r.data);
 			resource_system_unload(r);
 
 			if (!load_shader(shader_config)) {
-				CE_LOG_ERROR("shader_system_create failed to load shader %s", name.c_str());
-				return false;
+				CE_LOG_ERROR("shader_system_create failed to load shader %s", name);
+				return nullptr;
+			}
+
+			reference = flat_hash_map_find(state_ptr->registered_shaders, id);
+			if (!reference) {
+				CE_LOG_ERROR("shader_system_adquire the shader file %s has a different shader name", name);
+				return nullptr;
 			}
 		}
 		
-		state_ptr->registered_shaders[name].reference_count++;
-		return &state_ptr->registered_shaders[name].shader;
+		reference->reference_count++;
+		return &reference->shader;
 	}
 	
 	void shader_system_release(std::string& name) {
-		if (state_ptr->registered_shaders.find(name) != state_ptr->registered_shaders.end()) {
-			state_ptr->registered_shaders[name].reference_count--;
+		shader_system_release(name_id_intern(name.c_str()));
+	}
+
+	void shader_system_release(name_id id) {
+		shader_reference* reference = flat_hash_map_find(state_ptr->registered_shaders, id);
+		if (reference) {
+			reference->reference_count--;
 
-			if (state_ptr->registered_shaders[name].reference_count <= 0) {
-				destroy_shader(state_ptr->registered_shaders[name].shader);
-				state_ptr->registered_shaders.erase(name);
+			if (reference->reference_count <= 0) {
+				destroy_shader(reference->shader);
+				flat_hash_map_remove(state_ptr->registered_shaders, id);
 			}
 		}
 	}
 
 	void shader_system_use(std::string& name) {
-		if (state_ptr->registered_shaders.find(name) != state_ptr->registered_shaders.end()) {
-			renderer_shader_use(state_ptr->registered_shaders[name].shader);
+		shader_system_use(name_id_intern(name.c_str()));
+	}
+
+	void shader_system_use(name_id id) {
+		shader_reference* reference = flat_hash_map_find(state_ptr->registered_shaders, id);
+		if (reference) {
+			renderer_shader_use(reference->shader);
 		}
 	}
 
@@ -94,9 +124,10 @@ namespace caliope {
 		shader_reference sr;
 		sr.reference_count = 0;
 		sr.shader.name = shader_config.name;
+		sr.shader.id = name_id_intern(shader_config.name.c_str());
 		bool result = renderer_shader_create(shader_config, sr.shader);
 
-		state_ptr->registered_shaders.insert({ shader_config.name, sr });
+		flat_hash_map_insert(state_ptr->registered_shaders, sr.shader.id, sr);
 
 		return result;
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include "defines.h"
+#include "core/name_id.h"
 
 namespace caliope {
 
@@ -10,7 +11,13 @@ namespace caliope {
 	void shader_system_shutdown();
 
 	CE_API shader* shader_system_adquire(std::string& name);
+	/**
+	 * @note The name of the id must have been interned to load the shader the first time.
+	 */
+	CE_API shader* shader_system_adquire(name_id id);
 	CE_API void shader_system_release(std::string& name);
+	CE_API void shader_system_release(name_id id);
 
 	CE_API void shader_system_use(std::string& name);
+	CE_API void shader_system_use(name_id id);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "cepch.h"
 
 #include "core/logger.h"
+#include "containers/flat_hash_map.h"
 #include "resources/resources_types.inl"
 #include "systems/resource_system.h"
 #include "systems/texture_system.h"
@@ -10,7 +11,7 @@
 namespace caliope {
 
 	typedef struct sprite_animation_system_state {
-		std::unordered_map<std::string, sprite_animation> registered_animations;
+		flat_hash_map<name_id, sprite_animation> registered_animations;
 	} sprite_animation_system_state;
 
 	static std::unique_ptr<sprite_animation_system_state> state_ptr;
@@ -24,17 +25,19 @@ namespace caliope {
 			return false;
 		}
 
+		flat_hash_map_create(state_ptr->registered_animations);
+
 		return true;
 	}
 
 	void sprite_animation_system_shutdown() {
-		state_ptr->registered_animations.clear();
+		flat_hash_map_destroy(state_ptr->registered_animations);
 		state_ptr.reset();
 	}
 
 	bool sprite_animation_system_register(std::string& name)
 	{
-		if (state_ptr->registered_animations.find(name) != state_ptr->registered_animations.end()) {
+		if (flat_hash_map_contains(state_ptr->registered_animations, name_id_intern(name.c_str()))) {
 			CE_LOG_ERROR("Animation with this name already exists");
 			return false;
 		}
@@ -56,19 +59,33 @@ namespace caliope {
 
 
 	void sprite_animation_system_unregister(std::string name) {
-		if (state_ptr->registered_animations.find(name) != state_ptr->registered_animations.end()) {
-			state_ptr->registered_animations.erase(name);
-		}
+		flat_hash_map_remove(state_ptr->registered_animations, name_id_intern(name.c_str()));
 	}
 
 	sprite_frame* sprite_animation_system_acquire_frame(std::string& name, float delta_time) {
-		
-		if (state_ptr->registered_animations.find(name) == state_ptr->registered_animations.end()) {
-			CE_LOG_WARNING("Animation with this name not exists, trying to adquire it : %s", name.c_str());
-			sprite_animation_system_register(name);
+		return sprite_animation_system_acquire_frame(name_id_intern(name.c_str()), delta_time);
+	}
+
+	sprite_frame* sprite_animation_system_acquire_frame(name_id id, float delta_time) {
+		sprite_animation* found_animation = flat_hash_map_find(state_ptr->registered_animations, id);
+		if (!found_animation) {
+			const char* name = name_id_get_string(id);
+			if (!name) {
+				CE_LOG_ERROR("sprite_animation_system_acquire_frame the name of the id %llu was never interned", id);
+				return nullptr;
+			}
+
+			CE_LOG_WARNING("Animation with this name not exists, trying to adquire it : %s", name);
+			std::string animation_name(name);
+			sprite_animation_system_register(animation_name);
+
+			found_animation = flat_hash_map_find(state_ptr->registered_animations, id);
+			if (!found_animation) {
+				return nullptr;
+			}
 		}
 
-		sprite_animation& animation = state_ptr->registered_animations[name];
+		sprite_animation& animation = *found_animation;
 
 		if (animation.is_playing) {
 			animation.accumulated_delta += delta_time;
@@ -92,11 +109,13 @@ namespace caliope {
 		sprite_animation animation_internal;
 
 		animation_internal.name = std::string(animation_config.name.data());
+		animation_internal.id = name_id_intern(animation_config.name.data());
 		for (uint i = animation_config.starting_row; i < animation_config.number_of_rows; ++i) {
 			for (uint j = animation_config.starting_column; j < animation_config.number_of_columns; ++j) {
 				caliope::sprite_frame frame;
 				frame.material_name = animation_config.frames_data[i].material_name;
-				frame.texture_region = texture_system_calculate_grid_region_coordinates(*material_system_adquire(frame.material_name)->diffuse_texture, animation_config.frames_data[i].grid_size, i, j);
+				frame.material_id = name_id_intern(frame.material_name.c_str());
+				frame.texture_region = texture_system_calculate_grid_region_coordinates(*material_system_adquire(frame.material_id)->diffuse_texture, animation_config.frames_data[i].grid_size, i, j);
 				animation_internal.frames.push_back(frame);
 			}
 		}
@@ -107,7 +126,7 @@ namespace caliope {
 		animation_internal.current_frame = 0;
 
 
-		state_ptr->registered_animations.insert({ animation_internal.name , animation_internal });
+		flat_hash_map_insert(state_ptr->registered_animations, animation_internal.id, animation_internal);
 
 		return true;
 	}
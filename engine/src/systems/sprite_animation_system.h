@@ -1,5 +1,6 @@
 
 #include "defines.h"
+#include "core/name_id.h"
 #include <glm/glm.hpp>
 
 namespace caliope {
@@ -14,4 +15,8 @@ namespace caliope {
 	CE_API void sprite_animation_system_unregister(std::string name);
 
 	sprite_frame* sprite_animation_system_acquire_frame(std::string& name, float delta_time);
+	/**
+	 * @note The name of the id must have been interned to register the animation the first time.
+	 */
+	sprite_frame* sprite_animation_system_acquire_frame(name_id id, float delta_time);
 }
\ No newline at end of file
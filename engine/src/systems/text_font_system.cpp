@@ -2,6 +2,8 @@
 #include "resources/resources_types.inl"
 #include "core/logger.h"
 #include "core/cememory.h"
+#include "core/name_id.h"
+#include "containers/flat_hash_map.h"
 
 #include "systems/resource_system.h"
 #include "systems/texture_system.h"
@@ -17,7 +19,7 @@ namespace caliope {
 
 
 	typedef struct text_style_system_state {
-		std::unordered_map<std::string, text_font_reference> registered_fonts;
+		flat_hash_map<name_id, text_font_reference> registered_fonts; // Key: id of the name of the font followed by its size
 
 	} text_style_system_state;
 
@@ -34,13 +36,15 @@ namespace caliope {
 			return false;
 		}
 
+		flat_hash_map_create(state_ptr->registered_fonts);
+
 		CE_LOG_INFO("Text font system initialized.");
 		return true;
 	}
 
 	void text_font_system_shutdown()
 	{
-		state_ptr->registered_fonts.clear(); // Destroys all the text styles and their pointers.
+		flat_hash_map_destroy(state_ptr->registered_fonts); // Destroys all the text styles and their pointers.
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
@@ -48,7 +52,9 @@ namespace caliope {
 	text_font* text_font_system_adquire_font(std::string& name, uint font_size)
 	{
 		std::string full_name = name + "_" + std::to_string(font_size);
-		if (state_ptr->registered_fonts.find(full_name) == state_ptr->registered_fonts.end()) {
+		name_id id = name_id_intern(full_name.c_str());
+		text_font_reference* reference = flat_hash_map_find(state_ptr->registered_fonts, id);
+		if (!reference) {
 
 			resource r;
 			if (!resource_system_load(name, RESOURCE_TYPE_TEXT_FONT, r)) {
@@ -64,10 +70,16 @@ namespace caliope {
 			}
 
 			resource_system_unload(r);
+
+			reference = flat_hash_map_find(state_ptr->registered_fonts, id);
+			if (!reference) {
+				CE_LOG_ERROR("text_font_system_adquire_font the font file %s has a different font name", name.c_str());
+				return nullptr;
+			}
 		}
 
-		state_ptr->registered_fonts[full_name].reference_count++;
-		return &state_ptr->registered_fonts[full_name].text_font;
+		reference->reference_count++;
+		return &reference->text_font;
 	}
 
 	text_font_glyph* text_font_system_get_glyph(text_font* font, uint codepoint)
@@ -83,13 +95,13 @@ namespace caliope {
 
 	void text_font_system_release(std::string& name)
 	{
-		if (state_ptr->registered_fonts.find(name) != state_ptr->registered_fonts.end()) {
+		text_font_reference* reference = flat_hash_map_find(state_ptr->registered_fonts, name_id_intern(name.c_str()));
+		if (reference) {
 
-			state_ptr->registered_fonts[name].reference_count++;
+			reference->reference_count++;
 
-			if (state_ptr->registered_fonts[name].reference_count <= 0) {
-				destroy_text_font(state_ptr->registered_fonts[name].text_font);
-				state_ptr->registered_fonts.erase(name);
+			if (reference->reference_count <= 0) {
+				destroy_text_font(reference->text_font);
 			}
 		}
 	}
@@ -211,15 +223,17 @@ namespace caliope {
 		// Write data to atlas
 		texture_system_write_data(*tfr.text_font.atlas_material->diffuse_texture, 0, pack_image_size * 4, rgba_pixels.data());
 
-		state_ptr->registered_fonts.insert({ tfr.text_font.name, tfr });
+		flat_hash_map_insert(state_ptr->registered_fonts, name_id_intern(tfr.text_font.name.c_str()), tfr);
 
 		return true;
 	}
 
 	void destroy_text_font(text_font& tf) {
-		state_ptr->registered_fonts.erase(tf.name);
+		// Removing destroys tf, keep the id of the name first
+		name_id id = name_id_intern(tf.name.c_str());
 		tf.name = "";
 		material_system_release(tf.atlas_material->name);
 		// TODO:
+		flat_hash_map_remove(state_ptr->registered_fonts, id);
 	}
 }
\ No newline at end of file
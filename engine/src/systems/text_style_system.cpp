@@ -3,6 +3,8 @@
 #include "core/logger.h"
 #include "core/cestring.h"
 #include "core/cememory.h"
+#include "core/name_id.h"
+#include "containers/flat_hash_map.h"
 
 #include "systems/resource_system.h"
 #include "systems/material_system.h"
@@ -17,7 +19,7 @@ namespace caliope {
 
 
 	typedef struct text_style_system_state {
-		std::unordered_map<std::string, text_style_reference> registered_style_tables;
+		flat_hash_map<name_id, text_style_reference> registered_style_tables;
 
 	} text_style_system_state;
 
@@ -34,25 +36,29 @@ namespace caliope {
 			return false;
 		}
 
+		flat_hash_map_create(state_ptr->registered_style_tables);
+
 		CE_LOG_INFO("Text style system initialized.");
 		return true;
 	}
 
 	void text_style_system_shutdown()
 	{
+		// destroy_text_style removes the style table from the map, the entry being visited can be removed
 		for (auto [key, value] : state_ptr->registered_style_tables) {
 			destroy_text_style(value.text_style);
-			value.reference_count = 0;
 		}
 
-		state_ptr->registered_style_tables.clear();
+		flat_hash_map_destroy(state_ptr->registered_style_tables);
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
 
 	text_style_table* text_style_system_adquire_text_style_table(std::string& name)
 	{
-		if (state_ptr->registered_style_tables.find(name) == state_ptr->registered_style_tables.end()) {
+		name_id id = name_id_intern(name.c_str());
+		text_style_reference* reference = flat_hash_map_find(state_ptr->registered_style_tables, id);
+		if (!reference) {
 
 			resource r;
 			if (!resource_system_load(name, RESOURCE_TYPE_TEXT_STYLE, r)) {
@@ -68,10 +74,15 @@ namespace caliope {
 				return nullptr;
 			}
 
+			reference = flat_hash_map_find(state_ptr->registered_style_tables, id);
+			if (!reference) {
+				CE_LOG_ERROR("text_style_system_adquire the text style file %s has a different style table name", name.c_str());
+				return nullptr;
+			}
 		}
 
-		state_ptr->registered_style_tables[name].reference_count++;
-		return &state_ptr->registered_style_tables[name].text_style;
+		reference->reference_count++;
+		return &reference->text_style;
 	}
 
 	text_style text_style_system_adquire_text_style(text_style_table* style_table, std::string& text_tag)
@@ -83,18 +94,18 @@ namespace caliope {
 			return text_style();
 		}
 
-		if (state_ptr->registered_style_tables.at(style_table->name).text_style.tag_style_indexes.find(text_tag) == state_ptr->registered_style_tables.at(style_table->name).text_style.tag_style_indexes.end()) {
+		if (style_table->tag_style_indexes.find(text_tag) == style_table->tag_style_indexes.end()) {
 			CE_LOG_WARNING("text_style_system_adquire_text_style the tag %s not found.", text_tag.c_str());
 			return text_style(); // TODO: Return a default
 		}
 
-		uint index_style = state_ptr->registered_style_tables.at(style_table->name).text_style.tag_style_indexes.at(text_tag);
+		uint index_style = style_table->tag_style_indexes.at(text_tag);
 
 		style.tag_name_length = text_tag.size();
-		style.font = state_ptr->registered_style_tables.at(style_table->name).text_style.fonts[index_style];
-		style.font_size = state_ptr->registered_style_tables.at(style_table->name).text_style.text_sizes[index_style];
-		style.additional_interlinial_space = state_ptr->registered_style_tables.at(style_table->name).text_style.additional_interline_spaces[index_style];
-		style.text_color = state_ptr->registered_style_tables.at(style_table->name).text_style.text_colors[index_style];
+		style.font = style_table->fonts[index_style];
+		style.font_size = style_table->text_sizes[index_style];
+		style.additional_interlinial_space = style_table->additional_interline_spaces[index_style];
+		style.text_color = style_table->text_colors[index_style];
 
 		return style;
 	}
@@ -108,29 +119,29 @@ namespace caliope {
 			return text_image_style();
 		}
 
-		if (state_ptr->registered_style_tables.at(style_table->name).text_style.tag_image_indexes.find(image_tag) == state_ptr->registered_style_tables.at(style_table->name).text_style.tag_image_indexes.end()) {
+		if (style_table->tag_image_indexes.find(image_tag) == style_table->tag_image_indexes.end()) {
 			CE_LOG_WARNING("text_style_system_adquire_text_image_style the tag %s not found.", image_tag.c_str());
 			return text_image_style();
 		}
 
-		uint index_style = state_ptr->registered_style_tables.at(style_table->name).text_style.tag_image_indexes.at(image_tag);
+		uint index_style = style_table->tag_image_indexes.at(image_tag);
 
-		style.material = state_ptr->registered_style_tables.at(style_table->name).text_style.materials[index_style];
-		style.image_size = state_ptr->registered_style_tables.at(style_table->name).text_style.image_sizes[index_style];
-		style.texture_coord = state_ptr->registered_style_tables.at(style_table->name).text_style.texture_coordinates[index_style];
+		style.material = style_table->materials[index_style];
+		style.image_size = style_table->image_sizes[index_style];
+		style.texture_coord = style_table->texture_coordinates[index_style];
 
 		return style;
 	}
 
 	void text_style_system_release(std::string& name)
 	{
-		if (state_ptr->registered_style_tables.find(name) != state_ptr->registered_style_tables.end()) {
+		text_style_reference* reference = flat_hash_map_find(state_ptr->registered_style_tables, name_id_intern(name.c_str()));
+		if (reference) {
 
-			state_ptr->registered_style_tables[name].reference_count++;
+			reference->reference_count++;
 
-			if (state_ptr->registered_style_tables[name].reference_count <= 0) {
-				destroy_text_style(state_ptr->registered_style_tables[name].text_style);
-				state_ptr->registered_style_tables.erase(name);
+			if (reference->reference_count <= 0) {
+				destroy_text_style(reference->text_style);
 			}
 		}
 	}
@@ -160,13 +171,14 @@ namespace caliope {
 			tsr.text_style.texture_coordinates.push_back(text_coord);
 		}
 
-		state_ptr->registered_style_tables.insert({ tsr.text_style.name, tsr });
+		flat_hash_map_insert(state_ptr->registered_style_tables, name_id_intern(tsr.text_style.name.c_str()), tsr);
 
 		return true;
 	}
 
 	void destroy_text_style(text_style_table& ts) {
-		state_ptr->registered_style_tables.erase(ts.name);
+		// Removing destroys ts, keep the id of the name first
+		name_id id = name_id_intern(ts.name.c_str());
 		ts.name = "";
 		
 		for (uint i = 0; i < ts.materials.size(); ++i) {
@@ -181,5 +193,7 @@ namespace caliope {
 		ts.tag_image_indexes.clear();
 		ts.materials.clear();
 		ts.image_sizes.clear();
+
+		flat_hash_map_remove(state_ptr->registered_style_tables, id);
 	}
 }
\ No newline at end of file
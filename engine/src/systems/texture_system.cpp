@@ -2,6 +2,7 @@
 #include "cepch.h"
 #include "core/logger.h"
 #include "core/cememory.h"
+#include "containers/flat_hash_map.h"
 
 #include "resources/resources_types.inl"
 #include "systems/resource_system.h"
@@ -17,7 +18,7 @@ namespace caliope {
 	} texture_reference;
 
 	typedef struct texture_system_state {
-		std::unordered_map<std::string, texture_reference> registered_textures;
+		flat_hash_map<name_id, texture_reference> registered_textures;
 
 		texture default_diffuse_texture;
 		texture default_specular_texture;
@@ -39,6 +40,7 @@ namespace caliope {
 			return false;
 		}
 
+		flat_hash_map_create(state_ptr->registered_textures);
 		generate_default_textures();
 
 		CE_LOG_INFO("Texture system initialized.");
@@ -54,40 +56,56 @@ namespace caliope {
 		destroy_texture(state_ptr->default_specular_texture);
 		destroy_texture(state_ptr->default_normal_texture);
 
-		state_ptr->registered_textures.clear();
+		flat_hash_map_destroy(state_ptr->registered_textures);
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
 	
 	texture* texture_system_adquire(std::string& name) {
-		if (name == "") {
+		return texture_system_adquire(name_id_intern(name.c_str()));
+	}
+
+	texture* texture_system_adquire(name_id id) {
+		if (id == INVALID_NAME_ID) {
 			return nullptr;
 		}
 
-		if (state_ptr->registered_textures.find(name) == state_ptr->registered_textures.end()) {
+		texture_reference* reference = flat_hash_map_find(state_ptr->registered_textures, id);
+		if (!reference) {
+			const char* name = name_id_get_string(id);
+			if (!name) {
+				CE_LOG_WARNING("texture_system_adquire the name of the id %llu was never interned", id);
+				return nullptr;
+			}
+
 			texture_reference tr;
-			if (!load_texture(name, tr.texture)) {
-				CE_LOG_WARNING("texture_system_adquire failed to load texture %s", name.c_str());
-				return false;
+			tr.reference_count = 0;
+			if (!load_texture(std::string(name), tr.texture)) {
+				CE_LOG_WARNING("texture_system_adquire failed to load texture %s", name);
+				return nullptr;
 			}
 
-			state_ptr->registered_textures.insert({ name, tr });
+			reference = flat_hash_map_insert(state_ptr->registered_textures, id, tr);
 		}
 
-		state_ptr->registered_textures[name].reference_count++;
-		return &state_ptr->registered_textures[name].texture;
+		reference->reference_count++;
+		return &reference->texture;
 	}
 
 	texture* texture_system_adquire_writeable(std::string& name, uint width, uint height, uchar channel_count, bool has_transparency)
 	{
-		if (name == "") {
+		name_id id = name_id_intern(name.c_str());
+		if (id == INVALID_NAME_ID) {
 			return nullptr;
 		}
 
-		if (state_ptr->registered_textures.find(name) == state_ptr->registered_textures.end()) {
+		texture_reference* reference = flat_hash_map_find(state_ptr->registered_textures, id);
+		if (!reference) {
 			texture_reference tr;
+			tr.reference_count = 0;
 
 			tr.texture.name = name;
+			tr.texture.id = id;
 			tr.texture.normal_render_batch_index = 0;
 			tr.texture.pick_render_batch_index = 0;
 			tr.texture.width = width;
@@ -99,20 +117,25 @@ namespace caliope {
 
 			renderer_texture_create_writeable(tr.texture);
 
-			state_ptr->registered_textures.insert({ name, tr });
+			reference = flat_hash_map_insert(state_ptr->registered_textures, id, tr);
 		}
 
-		state_ptr->registered_textures[name].reference_count++;
-		return &state_ptr->registered_textures[name].texture;
+		reference->reference_count++;
+		return &reference->texture;
 	}
 	
 	void texture_system_release(std::string& name) {
-		if (state_ptr->registered_textures.find(name) != state_ptr->registered_textures.end()) {
-			state_ptr->registered_textures[name].reference_count--;
+		texture_system_release(name_id_intern(name.c_str()));
+	}
+
+	void texture_system_release(name_id id) {
+		texture_reference* reference = flat_hash_map_find(state_ptr->registered_textures, id);
+		if (reference) {
+			reference->reference_count--;
 
-			if (state_ptr->registered_textures[name].reference_count <= 0) {
-				destroy_texture(state_ptr->registered_textures[name].texture);
-				state_ptr->registered_textures.erase(name);
+			if (reference->reference_count <= 0) {
+				destroy_texture(reference->texture);
+				flat_hash_map_remove(state_ptr->registered_textures, id);
 			}
 		}
 	}
@@ -123,11 +146,12 @@ namespace caliope {
 	}
 
 	void texture_system_change_filter(std::string& name, texture_filter new_mag_filter, texture_filter new_min_filter) {
-		if (state_ptr->registered_textures.find(name) != state_ptr->registered_textures.end()) {
-			state_ptr->registered_textures[name].texture.magnification_filter = new_mag_filter;
-			state_ptr->registered_textures[name].texture.minification_filter = new_min_filter;
+		texture_reference* reference = flat_hash_map_find(state_ptr->registered_textures, name_id_intern(name.c_str()));
+		if (reference) {
+			reference->texture.magnification_filter = new_mag_filter;
+			reference->texture.minification_filter = new_min_filter;
 
-			renderer_texture_change_filter(state_ptr->registered_textures[name].texture);
+			renderer_texture_change_filter(reference->texture);
 		}
 	}
 
@@ -194,6 +218,7 @@ namespace caliope {
 		image_resource_data image_data = std::any_cast<image_resource_data>(r.data);
 
 		t.name = name;
+		t.id = name_id_intern(name.c_str());
 		t.normal_render_batch_index = 0;
 		t.pick_render_batch_index = 0;
 		t.width = image_data.width;
@@ -246,6 +271,7 @@ namespace caliope {
 			}
 		}
 		state_ptr->default_diffuse_texture.name = std::string("default_texture");
+		state_ptr->default_diffuse_texture.id = name_id_intern("default_texture");
 		state_ptr->default_diffuse_texture.normal_render_batch_index = 0;
 		state_ptr->default_diffuse_texture.width = texture_dimensions;
 		state_ptr->default_diffuse_texture.height = texture_dimensions;
@@ -258,6 +284,7 @@ namespace caliope {
 
 		std::array<uchar, 16 * 16 * 4> spec_pixels = { 0 };
 		state_ptr->default_specular_texture.name = std::string("default_spec");
+		state_ptr->default_specular_texture.id = name_id_intern("default_spec");
 		state_ptr->default_specular_texture.normal_render_batch_index = 0;
 		state_ptr->default_specular_texture.width = 16;
 		state_ptr->default_specular_texture.height = 16;
@@ -280,6 +307,7 @@ namespace caliope {
 			}
 		}
 		state_ptr->default_normal_texture.name = std::string("default_normal");
+		state_ptr->default_normal_texture.id = name_id_intern("default_normal");
 		state_ptr->default_normal_texture.normal_render_batch_index = 0;
 		state_ptr->default_normal_texture.width = 16;
 		state_ptr->default_normal_texture.height = 16;
@@ -1,5 +1,6 @@
 #pragma once
 #include "defines.h"
+#include "core/name_id.h"
 #include <glm/glm.hpp>
 namespace caliope {
 
@@ -11,8 +12,13 @@ namespace caliope {
 	void texture_system_shutdown();
 
 	CE_API texture* texture_system_adquire(std::string& name);
+	/**
+	 * @note The name of the id must have been interned to load the texture the first time.
+	 */
+	CE_API texture* texture_system_adquire(name_id id);
 	CE_API texture* texture_system_adquire_writeable(std::string& name, uint width, uint height, uchar channel_count, bool has_transparency);
 	CE_API void texture_system_release(std::string& name);
+	CE_API void texture_system_release(name_id id);
 
 	CE_API void texture_system_write_data(texture& t, uint offset, uint size, uchar* pixels);
 	CE_API void texture_system_change_filter(std::string& name, texture_filter new_mag_filter, texture_filter new_min_filter);
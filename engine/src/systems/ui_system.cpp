@@ -1,14 +1,17 @@
 #include "ui_system.h"
 #include "core/logger.h"
 #include "core/cememory.h"
+#include "containers/flat_hash_map.h"
 #include "core/cestring.h"
 #include "core/event.h"
+#include "memory/frame_allocator.h"
 #include "resources/resources_types.inl"
 #include "platform/file_system.h"
 #include "platform/platform.h"
 
 #include "components/components.inl"
 #include "ecs_system.h"
+#include "ecs_query.h"
 #include "object_pick_system.h"
 
 #include "sprite_animation_system.h"
@@ -27,7 +30,9 @@ namespace caliope {
 
 	typedef struct ui_system_state {
 		std::unordered_map<std::string, scene> loaded_ui_layouts;
-		std::unordered_map<uint, uint> entity_index_layout; // Index of the entity that occupies in the layout
+		flat_hash_map<uint, uint> entity_index_layout; // Index of the entity that occupies in the layout
+		// The callbacks of the buttons, the ECS snapshots don't keep them so they are bound again after a restore
+		flat_hash_map<uint, ui_events_component> button_events;
 
 		uint layout_count;
 		uint max_number_entities;
@@ -54,6 +59,7 @@ namespace caliope {
 		if (ui_dynamic_image_comp != nullptr) {
 			ui_dynamic_image_comp->current_color = ui_dynamic_image_comp->pressed_color;
 			ui_dynamic_image_comp->current_texture = texture_system_adquire(std::string(&ui_dynamic_image_comp->pressed_texture[0]));
+			ecs_system_mark_entity_changed(clicked_entity, UI_DYNAMIC_MATERIAL_COMPONENT);
 		}
 		if (ui_events_comp != nullptr && ui_events_comp->on_ui_pressed) {
 			ui_events_comp->on_ui_pressed(EVENT_CODE_ON_UI_BUTTON_PRESSED, 0);
@@ -72,6 +78,7 @@ namespace caliope {
 		if (ui_dynamic_image_comp != nullptr) {
 			ui_dynamic_image_comp->current_color = ui_dynamic_image_comp->normal_color;
 			ui_dynamic_image_comp->current_texture = texture_system_adquire(std::string(&ui_dynamic_image_comp->normal_texture[0]));
+			ecs_system_mark_entity_changed(released_entity, UI_DYNAMIC_MATERIAL_COMPONENT);
 		}
 
 		if (ui_events_comp != nullptr && ui_events_comp->on_ui_clicked && object_pick_system_get_ui_hover_entity() == state_ptr->current_clicked_entity) {
@@ -98,6 +105,7 @@ namespace caliope {
 		if (ui_dynamic_image_comp != nullptr) {
 			ui_dynamic_image_comp->current_color = ui_dynamic_image_comp->hover_color;
 			ui_dynamic_image_comp->current_texture = texture_system_adquire(std::string(&ui_dynamic_image_comp->hover_texture[0]));
+			ecs_system_mark_entity_changed(hover_entity, UI_DYNAMIC_MATERIAL_COMPONENT);
 		}
 		if (ui_events_comp != nullptr && ui_events_comp->on_ui_hover) {
 			ui_events_comp->on_ui_hover(EVENT_CODE_ON_UI_BUTTON_HOVER, 0);
@@ -112,6 +120,7 @@ namespace caliope {
 		if (previous_ui_dynamic_image_comp != nullptr) {
 			previous_ui_dynamic_image_comp->current_color = previous_ui_dynamic_image_comp->normal_color;
 			previous_ui_dynamic_image_comp->current_texture = texture_system_adquire(std::string(&previous_ui_dynamic_image_comp->normal_texture[0]));
+			ecs_system_mark_entity_changed(previous_hover_entity, UI_DYNAMIC_MATERIAL_COMPONENT);
 		}
 		if (previous_ui_events_comp != nullptr && previous_ui_events_comp->on_ui_unhover) {
 			previous_ui_events_comp->on_ui_unhover(EVENT_CODE_ON_UI_BUTTON_UNHOVER, 0);
@@ -122,6 +131,31 @@ namespace caliope {
 		return false;
 	}
 
+	// Sets button values by default
+	static void reset_ui_dynamic_materials() {
+		ecs_query<ui_dynamic_material_component> ui_dynamic_materials_query = ecs_query_create<ui_dynamic_material_component>();
+		ecs_query_for_each(ui_dynamic_materials_query, [](uint entity, ui_dynamic_material_component& ui_dynamic_image_comp) {
+			ui_dynamic_image_comp.current_color = ui_dynamic_image_comp.normal_color;
+			ui_dynamic_image_comp.current_texture = texture_system_adquire(std::string(&ui_dynamic_image_comp.normal_texture[0]));
+		});
+	}
+
+	// NOTE: The ECS restore resets the textures and the callbacks of the buttons to nullptr
+	bool on_ecs_snapshot_restored(event_system_code code, std::any data) {
+		reset_ui_dynamic_materials();
+
+		for (auto [entity, events] : state_ptr->button_events) {
+			uint64 size;
+			if (ecs_system_get_component_data(entity, UI_MOUSE_EVENTS_COMPONENT, size)) {
+				ecs_system_insert_data(entity, UI_MOUSE_EVENTS_COMPONENT, &events);
+			}
+		}
+		state_ptr->previous_hover_entity = -1;
+		state_ptr->current_clicked_entity = -1;
+
+		return false;
+	}
+
 	bool ui_system_initialize(ui_system_configuration& config) {
 		state_ptr = std::make_unique<ui_system_state>();
 
@@ -130,6 +164,8 @@ namespace caliope {
 		}
 
 		state_ptr->max_number_entities = config.max_number_entities;
+		flat_hash_map_create(state_ptr->entity_index_layout, config.max_number_entities);
+		flat_hash_map_create(state_ptr->button_events);
 		state_ptr->window_width = config.initial_window_width;
 		state_ptr->window_height = config.initial_window_height;
 		state_ptr->aspect_ratio = (float)config.initial_window_width / (float)config.initial_window_height;
@@ -138,6 +174,7 @@ namespace caliope {
 		event_register(EVENT_CODE_ON_ENTITY_PRESSED, on_ui_pressed);
 		event_register(EVENT_CODE_ON_ENTITY_RELEASED, on_ui_released);
 		event_register(EVENT_CODE_ON_ENTITY_HOVER, on_ui_hover);
+		event_register(EVENT_CODE_ON_ECS_SNAPSHOT_RESTORED, on_ecs_snapshot_restored);
 
 		CE_LOG_INFO("UI system initialized.");
 
@@ -150,6 +187,8 @@ namespace caliope {
 		}
 
 		state_ptr->loaded_ui_layouts.clear();
+		flat_hash_map_destroy(state_ptr->entity_index_layout);
+		flat_hash_map_destroy(state_ptr->button_events);
 		state_ptr.reset();
 		state_ptr = nullptr;
 	}
@@ -188,43 +227,17 @@ namespace caliope {
 
 		ui_system_create_empty_layout(std::string(scene_config.name.data()), enable_by_default);
 
+		// The entities of each archetype are spawned in one batch, new_entity_ids keeps the order of the file
 		std::vector<uint> new_entity_ids;
-
-		for (uint entity_index = 0; entity_index < scene_config.archetypes.size(); ++entity_index) {
-
-			// Tries to build the archetype if not exists
-			std::vector<uint> new_archetype_size;
-			std::vector<component_id> new_archetype_id;
-			std::vector<std::vector<component_data_type>> sprite_components_data_types;
-
-			for (uint component_index = 0; component_index < scene_config.components[entity_index].size(); ++component_index) {
-				component_id comp_id = scene_config.components[entity_index][component_index];
-				new_archetype_id.push_back(comp_id);
-				new_archetype_size.push_back(scene_config.components_sizes.at(comp_id));
-
-				sprite_components_data_types.push_back(std::vector<component_data_type>());
-				for (uint component_data_types_index = 0; component_data_types_index < scene_config.components_data_types[entity_index][component_index].size(); ++component_data_types_index) {
-					sprite_components_data_types[component_index].push_back(scene_config.components_data_types[entity_index][component_index][component_data_types_index]);
-				}
+		ecs_system_spawn_resource_entities(scene_config, new_entity_ids);
+
+		std::vector<uint>& entities = state_ptr->loaded_ui_layouts.at(std::string(scene_config.name.data())).entities;
+		entities.reserve(entities.size() + new_entity_ids.size());
+		for (uint entity : new_entity_ids) {
+			if (entity != INVALID_ID) {
+				flat_hash_map_insert(state_ptr->entity_index_layout, entity, (uint)entities.size());
+				entities.push_back(entity);
 			}
-			ecs_system_build_archetype(scene_config.archetypes[entity_index], new_archetype_id, new_archetype_size, sprite_components_data_types);
-
-
-			// Creates a new entity
-			std::vector<component_id> components;
-			std::vector<void*> data;
-
-			for (uint component_index = 0; component_index < scene_config.components[entity_index].size(); ++component_index) {
-				components.push_back(scene_config.components[entity_index][component_index]);
-				data.push_back(scene_config.components_data[entity_index][component_index]);
-			}
-
-			new_entity_ids.push_back(
-				ui_system_instance_entity(std::string(scene_config.name.data()), scene_config.archetypes[entity_index],
-					components,
-					data
-				)
-			);
 		}
 
 		resource_system_unload(r);
@@ -246,24 +259,7 @@ namespace caliope {
 		}
 
 		// TODO: Improve this, be implicit in the loading phase? make it more simple than this
-		// Sets button values by default
-		std::vector<uint> ui_button = ecs_system_get_entities_by_archetype(ARCHETYPE_UI_BUTTON);// TODO: If the vector is a reference and there is no button, calling the function the renderer crash, investigate why!
-		for (uint entity_index = 0; entity_index < ui_button.size(); ++entity_index) {
-			uint64 size;
-			ui_dynamic_material_component* ui_dynamic_image_comp = (ui_dynamic_material_component*)ecs_system_get_component_data(ui_button[entity_index], UI_DYNAMIC_MATERIAL_COMPONENT, size);
-			ui_dynamic_material_component new_ui_dynamic_image_comp;
-			new_ui_dynamic_image_comp.normal_color = ui_dynamic_image_comp->normal_color;
-			new_ui_dynamic_image_comp.hover_color = ui_dynamic_image_comp->hover_color;
-			new_ui_dynamic_image_comp.pressed_color = ui_dynamic_image_comp->pressed_color;
-			new_ui_dynamic_image_comp.normal_texture = ui_dynamic_image_comp->normal_texture;
-			new_ui_dynamic_image_comp.hover_texture = ui_dynamic_image_comp->hover_texture;
-			new_ui_dynamic_image_comp.pressed_texture = ui_dynamic_image_comp->pressed_texture;
-
-			new_ui_dynamic_image_comp.current_color = ui_dynamic_image_comp->normal_color;
-			new_ui_dynamic_image_comp.current_texture = texture_system_adquire(std::string(&ui_dynamic_image_comp->normal_texture[0]));
-
-			ecs_system_insert_data(ui_button[entity_index], UI_DYNAMIC_MATERIAL_COMPONENT, &new_ui_dynamic_image_comp);
-		}
+		reset_ui_dynamic_materials();
 
 		return true;
 	}
@@ -275,8 +271,10 @@ namespace caliope {
 			return;
 		}
 
-		while (!state_ptr->loaded_ui_layouts.at(name).entities.empty()) {
-			ui_system_destroy_entity(name, state_ptr->loaded_ui_layouts.at(name).entities.front());
+		for (uint entity : state_ptr->loaded_ui_layouts.at(name).entities) {
+			ecs_system_delete_entity(entity);
+			flat_hash_map_remove(state_ptr->entity_index_layout, entity);
+			flat_hash_map_remove(state_ptr->button_events, entity);
 		}
 
 		state_ptr->loaded_ui_layouts.erase(name);
@@ -306,7 +304,6 @@ namespace caliope {
 		parent_component parent_comp;
 		parent_comp.parent = -1;
 
-
 		std::vector<component_id> components = { PARENT_COMPONENT, UI_TRANSFORM_COMPONENT, UI_MATERIAL_COMPONENT, UI_BEHAVIOUR_COMPONENT };
 		std::vector<void*> data = { &parent_comp, &transform , &ui_material, &cursor_behaviour };
 
@@ -316,7 +313,7 @@ namespace caliope {
 		}
 
 		
-		state_ptr->entity_index_layout.insert({ entity, state_ptr->loaded_ui_layouts.at(name).entities.size() });
+		flat_hash_map_insert(state_ptr->entity_index_layout, entity, (uint)state_ptr->loaded_ui_layouts.at(name).entities.size());
 		state_ptr->loaded_ui_layouts.at(name).entities.push_back(entity);
 
 		return entity;
@@ -344,8 +341,9 @@ namespace caliope {
 		}
 
 
-		state_ptr->entity_index_layout.insert({ entity, state_ptr->loaded_ui_layouts.at(name).entities.size() });
+		flat_hash_map_insert(state_ptr->entity_index_layout, entity, (uint)state_ptr->loaded_ui_layouts.at(name).entities.size());
 		state_ptr->loaded_ui_layouts.at(name).entities.push_back(entity);
+		*flat_hash_map_insert(state_ptr->button_events, entity, ui_mouse_events) = ui_mouse_events;
 
 
 		event_register(EVENT_CODE_ON_UI_BUTTON_PRESSED, ui_mouse_events.on_ui_pressed);
@@ -375,7 +373,7 @@ namespace caliope {
 		}
 
 
-		state_ptr->entity_index_layout.insert({ entity, state_ptr->loaded_ui_layouts.at(name).entities.size() });
+		flat_hash_map_insert(state_ptr->entity_index_layout, entity, (uint)state_ptr->loaded_ui_layouts.at(name).entities.size());
 		state_ptr->loaded_ui_layouts.at(name).entities.push_back(entity);
 
 
@@ -401,7 +399,7 @@ namespace caliope {
 		}
 
 
-		state_ptr->entity_index_layout.insert({ entity, state_ptr->loaded_ui_layouts.at(name).entities.size() });
+		flat_hash_map_insert(state_ptr->entity_index_layout, entity, (uint)state_ptr->loaded_ui_layouts.at(name).entities.size());
 		state_ptr->loaded_ui_layouts.at(name).entities.push_back(entity);
 
 
@@ -415,12 +413,13 @@ namespace caliope {
 			return -1;
 		}
 
-		uint entity = ecs_system_add_entity(archetype);
-		for (uint i = 0; i < components.size(); ++i) {
-			ecs_system_insert_data(entity, components[i], components_data[i]);
+		uint entity = INVALID_ID;
+		ecs_system_spawn_batch(archetype, 1, (uint)components.size(), components.data(), components_data.data(), &entity);
+		if (entity == INVALID_ID) {
+			return -1;
 		}
 
-		state_ptr->entity_index_layout.insert({ entity, state_ptr->loaded_ui_layouts.at(name).entities.size() });
+		flat_hash_map_insert(state_ptr->entity_index_layout, entity, (uint)state_ptr->loaded_ui_layouts.at(name).entities.size());
 		state_ptr->loaded_ui_layouts.at(name).entities.push_back(entity);
 
 		return entity;
@@ -428,31 +427,25 @@ namespace caliope {
 
 	void ui_system_destroy_entity(std::string& name, uint entity) {
 
-		if (state_ptr->loaded_ui_layouts.find(name) == state_ptr->loaded_ui_layouts.end() || state_ptr->entity_index_layout.find(entity) == state_ptr->entity_index_layout.end()) {
+		if (state_ptr->loaded_ui_layouts.find(name) == state_ptr->loaded_ui_layouts.end() || !flat_hash_map_contains(state_ptr->entity_index_layout, entity)) {
 			CE_LOG_WARNING("ui_system_destroy_entity scene %s not found", name.c_str());
 			return;
 		}
 
-		bool remove_last_entity = state_ptr->loaded_ui_layouts.at(name).entities.back() == entity;
-
-		uint entity_scene_index = state_ptr->entity_index_layout.at(entity);
+		std::vector<uint>& entities = state_ptr->loaded_ui_layouts.at(name).entities;
+		uint entity_scene_index = *flat_hash_map_find(state_ptr->entity_index_layout, entity);
 		ecs_system_delete_entity(entity);
 
-
-		if (state_ptr->loaded_ui_layouts.at(name).entities.size() > 1 && !remove_last_entity) {
-			state_ptr->loaded_ui_layouts.at(name).entities.erase(state_ptr->loaded_ui_layouts.at(name).entities.begin() + entity_scene_index);
-
-			uint last_entity = state_ptr->loaded_ui_layouts.at(name).entities.back();
-			state_ptr->loaded_ui_layouts.at(name).entities.pop_back();
-			state_ptr->loaded_ui_layouts.at(name).entities.insert(state_ptr->loaded_ui_layouts.at(name).entities.begin() + entity_scene_index, last_entity);
-			state_ptr->entity_index_layout[last_entity] = entity_scene_index;
-		}
-		else if (remove_last_entity) {
-			uint last_index = state_ptr->loaded_ui_layouts.at(name).entities.size() - 1;
-			state_ptr->loaded_ui_layouts.at(name).entities.erase(state_ptr->loaded_ui_layouts.at(name).entities.begin() + last_index);
+		// Move the last entity to the hole
+		uint last_entity = entities.back();
+		entities[entity_scene_index] = last_entity;
+		entities.pop_back();
+		if (last_entity != entity) {
+			*flat_hash_map_find(state_ptr->entity_index_layout, last_entity) = entity_scene_index;
 		}
-
-		state_ptr->entity_index_layout.erase(entity);
+		
+		flat_hash_map_remove(state_ptr->entity_index_layout, entity);
+		flat_hash_map_remove(state_ptr->button_events, entity);
 
 	}
 
@@ -482,7 +475,7 @@ namespace caliope {
 		}
 	}
 
-	glm::vec3 calculate_position_based_on_anchor_bounds_and_parent(ui_transform_component* transform, ui_anchor_position anchor, uint parent) {
+	glm::vec3 calculate_position_based_on_anchor_bounds_and_parent(const ui_transform_component* transform, ui_anchor_position anchor, uint parent) {
 		uint64 size;
 		ui_transform_component* parent_transform = (ui_transform_component*)ecs_system_get_component_data(parent, UI_TRANSFORM_COMPONENT, size);
 		parent_component* parent_of_parent = (parent_component*)ecs_system_get_component_data(parent, PARENT_COMPONENT, size);
@@ -572,40 +565,34 @@ namespace caliope {
 		};
 	}
 
-	glm::vec3 calculate_scale_based_on_bounds_and_parent(ui_transform_component* transform, uint parent) {
+	glm::vec3 calculate_scale_based_on_bounds_and_parent(const ui_transform_component* transform, uint parent) {
 		glm::vec2 final_scale = transform->bounds_max_point;
 		// NOTE: Here is not applied the aspect ratio because then the sizes do not rescale according to the window size, because applies the aspect ratio which will be applied into the proyection
 		// so the final result will end up with the same size in any resolution
 		return { final_scale.x, final_scale.y, 0 };
 	}
 
-	void populate_package_with_ui_image(std::vector<quad_instance_definition>& quads_data, std::vector<quad_instance_definition>& pick_quads_data) {
-		std::vector<uint>& ui_images = ecs_system_get_entities_by_archetype(ARCHETYPE_UI_IMAGE);
-		for (uint entity_index = 0; entity_index < ui_images.size(); ++entity_index) {
+	void populate_package_with_ui_image(frame_vector<quad_instance_definition>& quads_data, frame_vector<quad_instance_definition>& pick_quads_data) {
+		// The buttons also have a ui material, they are populated apart
+		ecs_query<const parent_component, const ui_transform_component, const ui_material_component, const ui_behaviour_component> ui_images_query =
+			ecs_query_create<const parent_component, const ui_transform_component, const ui_material_component, const ui_behaviour_component>(ecs_signature<ui_dynamic_material_component>());
 
-			uint64 size;
-			ui_behaviour_component* behaviour_comp = (ui_behaviour_component*)ecs_system_get_component_data(ui_images[entity_index], UI_BEHAVIOUR_COMPONENT, size);
-			if (behaviour_comp->visibility == UI_VISIBILITY_COLLAPSE) {
+		ecs_query_for_each(ui_images_query, [&](uint entity, const parent_component& parent_comp, const ui_transform_component& tran_comp, const ui_material_component& ui_image_comp, const ui_behaviour_component& behaviour_comp) {
+			if (behaviour_comp.visibility == UI_VISIBILITY_COLLAPSE) {
 				// Skip and go for the next one
-				continue;
+				return;
 			}
-			
-			parent_component* parent_comp = (parent_component*)ecs_system_get_component_data(ui_images[entity_index], PARENT_COMPONENT, size);
-			
 
 			quad_instance_definition quad_definition;
-			quad_definition.id = ui_images[entity_index];
+			quad_definition.id = entity;
 
-			ui_transform_component* tran_comp = (ui_transform_component*)ecs_system_get_component_data(ui_images[entity_index], UI_TRANSFORM_COMPONENT, size);
 			transform transform = transform_create();
-			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp->roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
-			transform_set_scale(transform, calculate_scale_based_on_bounds_and_parent(tran_comp, parent_comp->parent));
-			transform_set_position(transform, calculate_position_based_on_anchor_bounds_and_parent(tran_comp, tran_comp->anchor, parent_comp->parent));
+			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp.roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
+			transform_set_scale(transform, calculate_scale_based_on_bounds_and_parent(&tran_comp, parent_comp.parent));
+			transform_set_position(transform, calculate_position_based_on_anchor_bounds_and_parent(&tran_comp, tran_comp.anchor, parent_comp.parent));
 			quad_definition.transform = transform;
 
-			ui_material_component* ui_image_comp = (ui_material_component*)ecs_system_get_component_data(ui_images[entity_index], UI_MATERIAL_COMPONENT, size);
-
-			material* mat = material_system_adquire(std::string(ui_image_comp->material_name.data()));
+			material* mat = material_system_adquire(ui_image_comp.material_id);
 			quad_definition.diffuse_color = mat->diffuse_color;
 			quad_definition.shininess_intensity = mat->shininess_intensity;
 			quad_definition.shininess_sharpness = mat->shininess_sharpness;
@@ -614,11 +601,11 @@ namespace caliope {
 			quad_definition.specular_texture = mat->specular_texture;
 			quad_definition.normal_texture = mat->normal_texture;
 
-			quad_definition.z_order = tran_comp->z_order;
+			quad_definition.z_order = tran_comp.z_order;
 			quad_definition.texture_region = texture_system_calculate_custom_region_coordinates(
-				*material_system_adquire(std::string(ui_image_comp->material_name.data()))->diffuse_texture,
-				ui_image_comp->texture_region[0],
-				ui_image_comp->texture_region[1],
+				*mat->diffuse_texture,
+				ui_image_comp.texture_region[0],
+				ui_image_comp.texture_region[1],
 				true
 			);
 
@@ -626,42 +613,35 @@ namespace caliope {
 			quads_data.push_back(quad_definition);
 
 			quads_data.push_back(quad_definition);
-			if (behaviour_comp->visibility == UI_VISIBILITY_VISIBLE) {
+			if (behaviour_comp.visibility == UI_VISIBILITY_VISIBLE) {
 				pick_quads_data.push_back(quad_definition);
 			}
-		}
+		});
 	}
 
-	void populate_package_with_ui_button(std::vector<quad_instance_definition>& quads_data, std::vector<quad_instance_definition>& pick_quads_data) {
-		std::vector<uint> ui_button = ecs_system_get_entities_by_archetype(ARCHETYPE_UI_BUTTON);// TODO: If the vector is a reference and there is no button, calling the function the renderer crash, investigate why!
-		for (uint entity_index = 0; entity_index < ui_button.size(); ++entity_index) {
+	void populate_package_with_ui_button(frame_vector<quad_instance_definition>& quads_data, frame_vector<quad_instance_definition>& pick_quads_data) {
+		ecs_query<const parent_component, const ui_transform_component, const ui_material_component, const ui_dynamic_material_component, const ui_behaviour_component> ui_buttons_query =
+			ecs_query_create<const parent_component, const ui_transform_component, const ui_material_component, const ui_dynamic_material_component, const ui_behaviour_component>();
 
-			uint64 size;
-			ui_behaviour_component* behaviour_comp = (ui_behaviour_component*)ecs_system_get_component_data(ui_button[entity_index], UI_BEHAVIOUR_COMPONENT, size);
-			if (behaviour_comp->visibility == UI_VISIBILITY_COLLAPSE) {
+		ecs_query_for_each(ui_buttons_query, [&](uint entity, const parent_component& parent_comp, const ui_transform_component& tran_comp, const ui_material_component& ui_button_comp, const ui_dynamic_material_component& ui_dynamic_image_comp, const ui_behaviour_component& behaviour_comp) {
+			if (behaviour_comp.visibility == UI_VISIBILITY_COLLAPSE) {
 				// Skip and go for the next one
-				continue;
+				return;
 			}
 
 			quad_instance_definition quad_definition;
-			quad_definition.id = ui_button[entity_index];
+			quad_definition.id = entity;
 
-			parent_component* parent_comp = (parent_component*)ecs_system_get_component_data(ui_button[entity_index], PARENT_COMPONENT, size);
-			
-			ui_transform_component* tran_comp = (ui_transform_component*)ecs_system_get_component_data(ui_button[entity_index], UI_TRANSFORM_COMPONENT, size);
 			transform transform = transform_create();
-			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp->roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
-			transform_set_scale(transform, calculate_scale_based_on_bounds_and_parent(tran_comp, parent_comp->parent));
-			transform_set_position(transform, calculate_position_based_on_anchor_bounds_and_parent(tran_comp, tran_comp->anchor, parent_comp->parent));
+			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp.roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
+			transform_set_scale(transform, calculate_scale_based_on_bounds_and_parent(&tran_comp, parent_comp.parent));
+			transform_set_position(transform, calculate_position_based_on_anchor_bounds_and_parent(&tran_comp, tran_comp.anchor, parent_comp.parent));
 			quad_definition.transform = transform;
 
+			material* mat = material_system_adquire(ui_button_comp.material_id); //TODO: Use a built in material UI?
 
-			ui_dynamic_material_component* ui_dynamic_image_comp = (ui_dynamic_material_component*)ecs_system_get_component_data(ui_button[entity_index], UI_DYNAMIC_MATERIAL_COMPONENT, size);
-			ui_material_component* ui_button_comp = (ui_material_component*)ecs_system_get_component_data(ui_button[entity_index], UI_MATERIAL_COMPONENT, size);
-			material* mat = material_system_adquire(std::string(ui_button_comp->material_name.data())); //TODO: Use a built in material UI?
-
-			quad_definition.diffuse_color = ui_dynamic_image_comp->current_color;
-			quad_definition.diffuse_texture = ui_dynamic_image_comp->current_texture;
+			quad_definition.diffuse_color = ui_dynamic_image_comp.current_color;
+			quad_definition.diffuse_texture = ui_dynamic_image_comp.current_texture;
 
 			quad_definition.shininess_intensity = mat->shininess_intensity;
 			quad_definition.shininess_sharpness = mat->shininess_sharpness;
@@ -669,22 +649,20 @@ namespace caliope {
 			quad_definition.specular_texture = mat->specular_texture;
 			quad_definition.normal_texture = mat->normal_texture;
 
-			quad_definition.z_order = tran_comp->z_order;
+			quad_definition.z_order = tran_comp.z_order;
 			quad_definition.texture_region = texture_system_calculate_custom_region_coordinates(
-				*material_system_adquire(std::string(ui_button_comp->material_name.data()))->diffuse_texture,
-				ui_button_comp->texture_region[0],
-				ui_button_comp->texture_region[1],
+				*mat->diffuse_texture,
+				ui_button_comp.texture_region[0],
+				ui_button_comp.texture_region[1],
 				true
 			);
 
-			ui_behaviour_component* cursor_behaviour_comp = (ui_behaviour_component*)ecs_system_get_component_data(ui_button[entity_index], UI_BEHAVIOUR_COMPONENT, size);
-
 			quads_data.push_back(quad_definition);
 
-			if (cursor_behaviour_comp->visibility == UI_VISIBILITY_VISIBLE) {
+			if (behaviour_comp.visibility == UI_VISIBILITY_VISIBLE) {
 				pick_quads_data.push_back(quad_definition);
 			}
-		}
+		});
 	}
 
 
@@ -859,232 +837,243 @@ namespace caliope {
 		}
 	}
 
-	void populate_package_with_ui_text(std::vector<quad_instance_definition>& quads_data, std::vector<quad_instance_definition>& pick_quads_data) {
+	void populate_package_with_ui_text(frame_vector<quad_instance_definition>& quads_data, frame_vector<quad_instance_definition>& pick_quads_data) {
 
 		// TODO: Optimization, for the pick, calculate the bounds based on the text and just create a quad that big
 
-		std::vector<uint> ui_text = ecs_system_get_entities_by_archetype(ARCHETYPE_UI_TEXT_BOX);// TODO: If the vector is a reference and there is no text, calling the function the renderer crash?, investigate why!
-		for (uint entity_index = 0; entity_index < ui_text.size(); ++entity_index) {
+		ecs_query<const parent_component, const ui_transform_component, const ui_text_component, const ui_behaviour_component> ui_texts_query =
+			ecs_query_create<const parent_component, const ui_transform_component, const ui_text_component, const ui_behaviour_component>();
+		decltype(ui_texts_query)::chunk_type chunk = {};
+		while (ecs_query_next_chunk(ui_texts_query, chunk)) {
+			const parent_component* parents = ecs_query_column<const parent_component>(chunk);
+			const ui_transform_component* transforms = ecs_query_column<const ui_transform_component>(chunk);
+			const ui_text_component* texts = ecs_query_column<const ui_text_component>(chunk);
+			const ui_behaviour_component* behaviours = ecs_query_column<const ui_behaviour_component>(chunk);
+
+			for (uint entity_index = 0; entity_index < chunk.entity_count; ++entity_index) {
+				if (!ecs_is_entity_enabled(chunk.enabled_mask, entity_index)) {
+					continue;
+				}
 
-			uint64 size;
-			ui_behaviour_component* behaviour_comp = (ui_behaviour_component*)ecs_system_get_component_data(ui_text[entity_index], UI_BEHAVIOUR_COMPONENT, size);
-			if (behaviour_comp->visibility == UI_VISIBILITY_COLLAPSE) {
-				// Skip and go for the next one
-				continue;
-			}
+				const ui_behaviour_component* behaviour_comp = &behaviours[entity_index];
+				if (behaviour_comp->visibility == UI_VISIBILITY_COLLAPSE) {
+					// Skip and go for the next one
+					continue;
+				}
 
-			quad_instance_definition quad_definition;
-			quad_definition.transform = transform_create(); // Just to initialize it
-			quad_definition.id = ui_text[entity_index];// TODO: If wants to make each character a unique id then move this inside the for loop
+				quad_instance_definition quad_definition;
+				quad_definition.transform = transform_create(); // Just to initialize it
+				quad_definition.id = chunk.entities[entity_index];// TODO: If wants to make each character a unique id then move this inside the for loop
 
-			parent_component* parent_comp = (parent_component*)ecs_system_get_component_data(ui_text[entity_index], PARENT_COMPONENT, size);
+				const parent_component* parent_comp = &parents[entity_index];
 			
-			ui_transform_component* tran_comp = (ui_transform_component*)ecs_system_get_component_data(ui_text[entity_index], UI_TRANSFORM_COMPONENT, size);
-			transform transform = transform_create();
-			transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp->roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
-			transform_set_scale(transform, calculate_scale_based_on_bounds_and_parent(tran_comp, parent_comp->parent));
-			transform_set_position(transform, calculate_position_based_on_anchor_bounds_and_parent(tran_comp, tran_comp->anchor, parent_comp->parent));
-			// Do a correction to align correctly the TOP-LEFT corner of the text box with the text 
-			transform.position.x -= tran_comp->bounds_max_point.x / 2;
-			transform.position.y -= tran_comp->bounds_max_point.y / 2;
-
-			ui_text_component* ui_text_comp = (ui_text_component*)ecs_system_get_component_data(ui_text[entity_index], UI_TEXT_COMPONENT, size);
-			// Found the glyph. generate points.
-			text_style_table* style_table = text_style_system_adquire_text_style_table(std::string(&ui_text_comp->style_table_name[0]));
+				const ui_transform_component* tran_comp = &transforms[entity_index];
+				transform transform = transform_create();
+				transform_set_rotation(transform, glm::angleAxis(glm::radians(tran_comp->roll_rotation), glm::vec3(0.f, 0.f, 1.f)));
+				transform_set_scale(transform, calculate_scale_based_on_bounds_and_parent(tran_comp, parent_comp->parent));
+				transform_set_position(transform, calculate_position_based_on_anchor_bounds_and_parent(tran_comp, tran_comp->anchor, parent_comp->parent));
+				// Do a correction to align correctly the TOP-LEFT corner of the text box with the text 
+				transform.position.x -= tran_comp->bounds_max_point.x / 2;
+				transform.position.y -= tran_comp->bounds_max_point.y / 2;
+
+				const ui_text_component* ui_text_comp = &texts[entity_index];
+				// Found the glyph. generate points.
+				text_style_table* style_table = text_style_system_adquire_text_style_table(std::string(&ui_text_comp->style_table_name[0]));
 			
-			text_style default_style = text_style_system_adquire_text_style(style_table, std::string("default"));
+				text_style default_style = text_style_system_adquire_text_style(style_table, std::string("default"));
 			
-			text_style* in_use_style = &default_style;
-
-			// Gets the style list applied to the text
-			// Vectors used as stacks because they are contigous in memory
-			uint current_candidate_style_index = 0;
-			std::vector<text_style> styles;
-			std::vector<uint> style_starting_indices;
-			std::vector<uint> style_ending_indices;
-
-			uint current_candidate_image_index = 0;
-			std::vector<text_image_style> insterted_images;
-			std::vector<uint> inserted_image_starting_indices;
-			std::vector<uint> inserted_image_ending_indices;
-
-			uint current_break_line_index = 0;
-			std::vector<uint> break_line_indices;
-			std::vector<int> line_heights;
-
-			get_metrics_applying_style_to_text(style_table, std::string(&ui_text_comp->text[0]),
-				styles, style_starting_indices, style_ending_indices,
-				insterted_images, inserted_image_starting_indices, inserted_image_ending_indices,// TODO: Do this operation every time the text change or precalculate it at the level beggining
-				tran_comp->bounds_max_point.x, break_line_indices, line_heights);
+				text_style* in_use_style = &default_style;
+
+				// Gets the style list applied to the text
+				// Vectors used as stacks because they are contigous in memory
+				uint current_candidate_style_index = 0;
+				std::vector<text_style> styles;
+				std::vector<uint> style_starting_indices;
+				std::vector<uint> style_ending_indices;
+
+				uint current_candidate_image_index = 0;
+				std::vector<text_image_style> insterted_images;
+				std::vector<uint> inserted_image_starting_indices;
+				std::vector<uint> inserted_image_ending_indices;
+
+				uint current_break_line_index = 0;
+				std::vector<uint> break_line_indices;
+				std::vector<int> line_heights;
+
+				get_metrics_applying_style_to_text(style_table, std::string(&ui_text_comp->text[0]),
+					styles, style_starting_indices, style_ending_indices,
+					insterted_images, inserted_image_starting_indices, inserted_image_ending_indices,// TODO: Do this operation every time the text change or precalculate it at the level beggining
+					tran_comp->bounds_max_point.x, break_line_indices, line_heights);
 			
 
-			float x_advance = 0;
-			float y_advance = 0;
-			if (!line_heights.empty()) {
-				y_advance = line_heights[0];
-			}
-			// Iterates each string character
-			for (uint char_index = 0; char_index < ui_text_comp->text.size(); ++char_index) {
-				if (ui_text_comp->text[char_index] == '\0') {
-					break;
+				float x_advance = 0;
+				float y_advance = 0;
+				if (!line_heights.empty()) {
+					y_advance = line_heights[0];
 				}
+				// Iterates each string character
+				for (uint char_index = 0; char_index < ui_text_comp->text.size(); ++char_index) {
+					if (ui_text_comp->text[char_index] == '\0') {
+						break;
+					}
 
 
-				caliope::quad_instance_definition qd = quads_data[quads_data.size() - 1];
+					caliope::quad_instance_definition qd = quads_data[quads_data.size() - 1];
 
-				// Check if needs to insert a inline image
-				if (current_candidate_image_index < inserted_image_starting_indices.size() && char_index == inserted_image_starting_indices[current_candidate_image_index]) {
+					// Check if needs to insert a inline image
+					if (current_candidate_image_index < inserted_image_starting_indices.size() && char_index == inserted_image_starting_indices[current_candidate_image_index]) {
 
-					// For correct spacing
-					quad_definition.transform.position.x = transform.position.x + (x_advance)+(insterted_images[current_candidate_image_index].image_size.x / 2) ;
-					quad_definition.transform.position.y = transform.position.y + y_advance - (insterted_images[current_candidate_image_index].image_size.y / 2);
+						// For correct spacing
+						quad_definition.transform.position.x = transform.position.x + (x_advance)+(insterted_images[current_candidate_image_index].image_size.x / 2) ;
+						quad_definition.transform.position.y = transform.position.y + y_advance - (insterted_images[current_candidate_image_index].image_size.y / 2);
 
-					x_advance += insterted_images[current_candidate_image_index].image_size.x;
+						x_advance += insterted_images[current_candidate_image_index].image_size.x;
 
 
-					// Quad for the inline image
-					quad_definition.transform.scale.x = insterted_images[current_candidate_image_index].image_size.x;
-					quad_definition.transform.scale.y = insterted_images[current_candidate_image_index].image_size.y;
+						// Quad for the inline image
+						quad_definition.transform.scale.x = insterted_images[current_candidate_image_index].image_size.x;
+						quad_definition.transform.scale.y = insterted_images[current_candidate_image_index].image_size.y;
 
-					material* mat = insterted_images[current_candidate_image_index].material;
-					quad_definition.diffuse_color = mat->diffuse_color;
-					quad_definition.shininess_intensity = mat->shininess_intensity;
-					quad_definition.shininess_sharpness = mat->shininess_sharpness;
-					quad_definition.shader = mat->shader;
-					quad_definition.diffuse_texture = mat->diffuse_texture;
-					quad_definition.specular_texture = mat->specular_texture;
-					quad_definition.normal_texture = mat->normal_texture;
+						material* mat = insterted_images[current_candidate_image_index].material;
+						quad_definition.diffuse_color = mat->diffuse_color;
+						quad_definition.shininess_intensity = mat->shininess_intensity;
+						quad_definition.shininess_sharpness = mat->shininess_sharpness;
+						quad_definition.shader = mat->shader;
+						quad_definition.diffuse_texture = mat->diffuse_texture;
+						quad_definition.specular_texture = mat->specular_texture;
+						quad_definition.normal_texture = mat->normal_texture;
 
-					quad_definition.diffuse_color = insterted_images[current_candidate_image_index].material->diffuse_color;
-					quad_definition.z_order = tran_comp->z_order;
-					quad_definition.texture_region = texture_system_calculate_custom_region_coordinates(
-						*insterted_images[current_candidate_image_index].material->diffuse_texture,
-						insterted_images[current_candidate_image_index].texture_coord[0],
-						insterted_images[current_candidate_image_index].texture_coord[1],
-						true
-					);
+						quad_definition.diffuse_color = insterted_images[current_candidate_image_index].material->diffuse_color;
+						quad_definition.z_order = tran_comp->z_order;
+						quad_definition.texture_region = texture_system_calculate_custom_region_coordinates(
+							*insterted_images[current_candidate_image_index].material->diffuse_texture,
+							insterted_images[current_candidate_image_index].texture_coord[0],
+							insterted_images[current_candidate_image_index].texture_coord[1],
+							true
+						);
 
-					quads_data.push_back(quad_definition);
+						quads_data.push_back(quad_definition);
 
-					char_index = inserted_image_ending_indices[current_candidate_image_index];
-					current_candidate_image_index++;
-					continue;
-				}
+						char_index = inserted_image_ending_indices[current_candidate_image_index];
+						current_candidate_image_index++;
+						continue;
+					}
 
-				//Checks if it needs to apply a new style 
-				if (current_candidate_style_index < style_starting_indices.size() && char_index == style_starting_indices[current_candidate_style_index]) {
-					in_use_style = &styles[current_candidate_style_index];
-					char_index += styles[current_candidate_style_index].tag_name_length + 1; // The plus 1 is to skip the separator character '|' too
-					continue;
-				}
+					//Checks if it needs to apply a new style 
+					if (current_candidate_style_index < style_starting_indices.size() && char_index == style_starting_indices[current_candidate_style_index]) {
+						in_use_style = &styles[current_candidate_style_index];
+						char_index += styles[current_candidate_style_index].tag_name_length + 1; // The plus 1 is to skip the separator character '|' too
+						continue;
+					}
 
-				if (current_candidate_style_index < style_starting_indices.size() && char_index == style_ending_indices[current_candidate_style_index]) {
-					in_use_style = &default_style;
-					current_candidate_style_index++;
-					continue;
-				}
+					if (current_candidate_style_index < style_starting_indices.size() && char_index == style_ending_indices[current_candidate_style_index]) {
+						in_use_style = &default_style;
+						current_candidate_style_index++;
+						continue;
+					}
 
-				// Checks if needs to break a line
-				if (current_break_line_index < break_line_indices.size() && break_line_indices[current_break_line_index] == char_index) {
-					x_advance = 0;
-					current_break_line_index++;
-					if (current_break_line_index < line_heights.size()) {
-						y_advance += line_heights[current_break_line_index] + in_use_style->additional_interlinial_space;
+					// Checks if needs to break a line
+					if (current_break_line_index < break_line_indices.size() && break_line_indices[current_break_line_index] == char_index) {
+						x_advance = 0;
+						current_break_line_index++;
+						if (current_break_line_index < line_heights.size()) {
+							y_advance += line_heights[current_break_line_index] + in_use_style->additional_interlinial_space;
+						}
+						continue;
 					}
-					continue;
-				}
 
-				// Checks if needs to space
-				if (ui_text_comp->text[char_index] == ' ') {
-					// If there is a blank space skip to next char
-					if (x_advance != 0) {
-						x_advance += in_use_style->font->x_advance_space;
+					// Checks if needs to space
+					if (ui_text_comp->text[char_index] == ' ') {
+						// If there is a blank space skip to next char
+						if (x_advance != 0) {
+							x_advance += in_use_style->font->x_advance_space;
+						}
+						continue;
 					}
-					continue;
-				}
 
-				// Checks if needs to tab
-				if (ui_text_comp->text[char_index] == '\t') {
-					// If there is a tab space skip to next char
-					if (x_advance != 0) {
-						x_advance += in_use_style->font->x_advance_tab;
+					// Checks if needs to tab
+					if (ui_text_comp->text[char_index] == '\t') {
+						// If there is a tab space skip to next char
+						if (x_advance != 0) {
+							x_advance += in_use_style->font->x_advance_tab;
+						}
+						continue;
 					}
-					continue;
-				}
 
-				text_font_glyph* g = text_font_system_get_glyph(in_use_style->font, ui_text_comp->text[char_index]);
-				// TODO: Do the alignment position calculation, kerning and spacing inside the text font system and return its value with functions?
-				quad_definition.transform.position.x = transform.position.x + (x_advance)+(g->width / 2) + g->x_offset;
-				float glyph_pos_y = ((g->y_offset2 + g->y_offset) / 2);
-				quad_definition.transform.position.y = transform.position.y + y_advance + (glyph_pos_y);
+					text_font_glyph* g = text_font_system_get_glyph(in_use_style->font, ui_text_comp->text[char_index]);
+					// TODO: Do the alignment position calculation, kerning and spacing inside the text font system and return its value with functions?
+					quad_definition.transform.position.x = transform.position.x + (x_advance)+(g->width / 2) + g->x_offset;
+					float glyph_pos_y = ((g->y_offset2 + g->y_offset) / 2);
+					quad_definition.transform.position.y = transform.position.y + y_advance + (glyph_pos_y);
 
 
-				int kerning_advance = 0;
+					int kerning_advance = 0;
 
-				// Try to find kerning, if does, applies it to x_advance 
-				if (char_index + 1 < ui_text_comp->text.size()) {
-					text_font_glyph* g_next = text_font_system_get_glyph(in_use_style->font, ui_text_comp->text[char_index + 1]);
+					// Try to find kerning, if does, applies it to x_advance 
+					if (char_index + 1 < ui_text_comp->text.size()) {
+						text_font_glyph* g_next = text_font_system_get_glyph(in_use_style->font, ui_text_comp->text[char_index + 1]);
 
-					//TODO: Make it more efficient!!
-					for (uint i = 0; i < in_use_style->font->kernings.size(); ++i) {
-						text_font_kerning* k = &in_use_style->font->kernings[i];
-						if (g->kerning_index == k->codepoint1 && g_next->kerning_index == k->codepoint2) {
-							kerning_advance = -(k->advance);
-							break;
+						//TODO: Make it more efficient!!
+						for (uint i = 0; i < in_use_style->font->kernings.size(); ++i) {
+							text_font_kerning* k = &in_use_style->font->kernings[i];
+							if (g->kerning_index == k->codepoint1 && g_next->kerning_index == k->codepoint2) {
+								kerning_advance = -(k->advance);
+								break;
+							}
 						}
 					}
-				}
 
 
-				x_advance += (g->x_advance) + (kerning_advance);
+					x_advance += (g->x_advance) + (kerning_advance);
 
-				// Quad for the glyph
-				quad_definition.transform.scale.x = g->width;
-				quad_definition.transform.scale.y = g->height;
+					// Quad for the glyph
+					quad_definition.transform.scale.x = g->width;
+					quad_definition.transform.scale.y = g->height;
 
-				material* mat = in_use_style->font->atlas_material;
-				quad_definition.diffuse_color = mat->diffuse_color;
-				quad_definition.shininess_intensity = mat->shininess_intensity;
-				quad_definition.shininess_sharpness = mat->shininess_sharpness;
-				quad_definition.shader = mat->shader;
-				quad_definition.diffuse_texture = mat->diffuse_texture;
-				quad_definition.specular_texture = mat->specular_texture;
-				quad_definition.normal_texture = mat->normal_texture;
+					material* mat = in_use_style->font->atlas_material;
+					quad_definition.diffuse_color = mat->diffuse_color;
+					quad_definition.shininess_intensity = mat->shininess_intensity;
+					quad_definition.shininess_sharpness = mat->shininess_sharpness;
+					quad_definition.shader = mat->shader;
+					quad_definition.diffuse_texture = mat->diffuse_texture;
+					quad_definition.specular_texture = mat->specular_texture;
+					quad_definition.normal_texture = mat->normal_texture;
 
-				quad_definition.diffuse_color = in_use_style->text_color;
-				quad_definition.z_order = tran_comp->z_order;
-				quad_definition.texture_region = texture_system_calculate_custom_region_coordinates(
-					*in_use_style->font->atlas_material->diffuse_texture,
-					{ g->x,  g->y },
-					{ g->x + g->width, (g->y + g->height) },
-					false
-				);
+					quad_definition.diffuse_color = in_use_style->text_color;
+					quad_definition.z_order = tran_comp->z_order;
+					quad_definition.texture_region = texture_system_calculate_custom_region_coordinates(
+						*in_use_style->font->atlas_material->diffuse_texture,
+						{ g->x,  g->y },
+						{ g->x + g->width, (g->y + g->height) },
+						false
+					);
 
-				quads_data.push_back(quad_definition);
+					quads_data.push_back(quad_definition);
 
-				if (behaviour_comp->visibility == UI_VISIBILITY_VISIBLE) {
-					pick_quads_data.push_back(quad_definition);
+					if (behaviour_comp->visibility == UI_VISIBILITY_VISIBLE) {
+						pick_quads_data.push_back(quad_definition);
+					}
 				}
 			}
 		}
 	}
 
 	void reset_ui_elements_values() {
-		std::vector<uint> ui_container_boxes = ecs_system_get_entities_by_archetype(ARCHETYPE_UI_CONTAINER_BOX);// TODO: If the vector is a reference and there is no text, calling the function the renderer crash?, investigate why!
-		for (uint entity_index = 0; entity_index < ui_container_boxes.size(); ++entity_index) {
-			uint64 size;
-			ui_container_component* container_comp = (ui_container_component*)ecs_system_get_component_data(ui_container_boxes[entity_index], UI_CONTAINER_COMPONENT, size);
-			ui_container_component new_container_comp;
-			new_container_comp.is_arranged_horizontal = container_comp->is_arranged_horizontal;
-			new_container_comp.next_position = glm::vec3(0.0f);
-			ecs_system_insert_data(ui_container_boxes[entity_index], UI_CONTAINER_COMPONENT, &new_container_comp);
-		}
+		ecs_query<ui_container_component> ui_containers_query = ecs_query_create<ui_container_component>();
+		ecs_query_for_each(ui_containers_query, [](uint entity, ui_container_component& container_comp) {
+			container_comp.next_position = glm::vec3(0.0f);
+		});
 	}
 
-	void ui_system_populate_render_packet(std::vector<renderer_view_packet>& packets, camera* ui_cam_in_use, float delta_time) {
+	void ui_system_populate_render_packet(frame_vector<renderer_view_packet>& packets, camera* ui_cam_in_use, float delta_time) {
+
+		frame_vector<quad_instance_definition> quads_data;
+		frame_vector<quad_instance_definition> pick_quads_data;
 
-		std::vector<quad_instance_definition> quads_data;
-		std::vector<quad_instance_definition> pick_quads_data;
+		// NOTE: Reserve up front, the frame arena can't reuse the blocks left behind by a vector growth. The text glyphs can't be known beforehand
+		uint64 ui_elements_count = (uint64)ecs_system_get_enabled_entity_count(ARCHETYPE_UI_IMAGE) + ecs_system_get_enabled_entity_count(ARCHETYPE_UI_BUTTON);
+		quads_data.reserve(ui_elements_count * 2);
+		pick_quads_data.reserve(ui_elements_count);
 
 		
 		populate_package_with_ui_image(quads_data, pick_quads_data);
@@ -1094,13 +1083,13 @@ namespace caliope {
 
 		renderer_view_packet ui_packet;
 		ui_packet.view_type = VIEW_TYPE_UI;
-		render_view_system_on_build_packet(VIEW_TYPE_UI, ui_packet, std::vector<std::any>({ quads_data, ui_cam_in_use, delta_time }));
-		packets.push_back(ui_packet);
+		render_view_system_on_build_packet(VIEW_TYPE_UI, ui_packet, std::vector<std::any>({ &quads_data, ui_cam_in_use, delta_time }));
+		packets.push_back(std::move(ui_packet));
 
 		renderer_view_packet pick_object_packet;
 		pick_object_packet.view_type = VIEW_TYPE_UI_OBJECT_PICK;
-		render_view_system_on_build_packet(VIEW_TYPE_UI_OBJECT_PICK, pick_object_packet, std::vector<std::any>({ pick_quads_data, ui_cam_in_use, delta_time }));
-		packets.push_back(pick_object_packet);
+		render_view_system_on_build_packet(VIEW_TYPE_UI_OBJECT_PICK, pick_object_packet, std::vector<std::any>({ &pick_quads_data, ui_cam_in_use, delta_time }));
+		packets.push_back(std::move(pick_object_packet));
 
 		reset_ui_elements_values();
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include "defines.h"
+#include "memory/frame_allocator.h"
 
 
 namespace caliope {
@@ -29,7 +30,7 @@ namespace caliope {
 	void ui_system_shutdown();
 	void ui_system_on_resize(uint16 width, uint16 height);
 
-	void ui_system_populate_render_packet(std::vector<renderer_view_packet>& packets, camera* ui_cam_in_use, float delta_time);
+	void ui_system_populate_render_packet(frame_vector<renderer_view_packet>& packets, camera* ui_cam_in_use, float delta_time);
 
 	CE_API bool ui_system_create_empty_layout(std::string& name, bool enable_by_default);
 	CE_API bool ui_system_load_layout(std::string& name, bool enable_by_default);
@@ -9,6 +9,8 @@ bool create_program(caliope::program_config& out_config) {
     out_config.height = 1080;
     out_config.maximum_number_entities_per_frame = 10000;
     out_config.maximum_number_textures_per_frame = 400;
+    out_config.memory_region_size = MEBIBYTES(256);
+    out_config.maximum_memory_size = GIBIBYTES(1);
 
 
     out_config.initialize = initialize_testbed;